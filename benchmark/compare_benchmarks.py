@@ -0,0 +1,89 @@
+#!/usr/bin/env python
+"""
+Compares Google Benchmark JSON results (--benchmark_out_format=json).
+
+  compare_benchmarks.py baseline.json contender.json
+      compares each benchmark of the contender with the same benchmark of the
+      baseline, e.g. the results of two revisions.
+
+  compare_benchmarks.py --pairs results.json
+      compares each benchmark 'BM_X_Reference/...' with 'BM_X/...' of the
+      same run, e.g. a new kernel with the implementation it replaces.
+
+A positive change means the contender is slower. The exit code is 1 if any
+benchmark got slower than the given threshold.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        results = json.load(f)
+    times = {}
+    for bench in results['benchmarks']:
+        # skip mean/median/stddev entries of repeated runs
+        if bench.get('run_type', 'iteration') != 'iteration':
+            continue
+        times[bench['name']] = float(bench['cpu_time'])
+    return times
+
+
+def compare(pairs, threshold):
+    name_width = max([len(name) for name, _, _ in pairs] + [10])
+    print('{0:<{w}} {1:>14} {2:>14} {3:>9}'.format(
+        'Benchmark', 'Baseline', 'Contender', 'Change', w=name_width))
+    regression = False
+    for name, baseline, contender in pairs:
+        change = (contender - baseline) / baseline if baseline > 0 else 0.0
+        marker = ''
+        if change > threshold:
+            marker = '  <-- slower'
+            regression = True
+        elif change < -threshold:
+            marker = '  <-- faster'
+        print('{0:<{w}} {1:>14.1f} {2:>14.1f} {3:>+8.1%}{4}'.format(
+            name, baseline, contender, change, marker, w=name_width))
+    return regression
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('files', nargs='+', help='benchmark JSON result files')
+    parser.add_argument('--pairs', action='store_true',
+                        help='compare BM_X_Reference with BM_X within one file')
+    parser.add_argument('--threshold', type=float, default=0.05,
+                        help='relative change which is reported (default 0.05)')
+    args = parser.parse_args()
+
+    pairs = []
+    if args.pairs:
+        if len(args.files) != 1:
+            parser.error('--pairs expects exactly one file')
+        times = load(args.files[0])
+        for name in sorted(times):
+            base, sep, params = name.partition('/')
+            if base.endswith('_Reference'):
+                contender = base[:-len('_Reference')] + sep + params
+                if contender in times:
+                    pairs.append((contender, times[name], times[contender]))
+    else:
+        if len(args.files) != 2:
+            parser.error('expected a baseline and a contender file')
+        baseline = load(args.files[0])
+        contender = load(args.files[1])
+        for name in sorted(baseline):
+            if name in contender:
+                pairs.append((name, baseline[name], contender[name]))
+
+    if not pairs:
+        print('No comparable benchmarks found')
+        return 0
+    return 1 if compare(pairs, args.threshold) else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,507 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+/*
+ * Google Benchmark microbenchmarks of the per-frame kernels of the
+ * PylonCameraNode. Each kernel runs over realistic sensor resolutions for
+ * mono8 and rgb8. Kernels with a '_Reference' twin keep the previous
+ * implementation, so a replacement (e.g. a SIMD version) can be compared
+ * within one run:
+ *   pylon_camera_kernel_benchmark --benchmark_out=new.json --benchmark_out_format=json
+ *   benchmark/compare_benchmarks.py --pairs new.json
+ * or between two revisions:
+ *   benchmark/compare_benchmarks.py old.json new.json
+ */
+
+#include <benchmark/benchmark.h>
+#include <cv_bridge/cv_bridge.h>
+#include <image_geometry/pinhole_camera_model.h>
+#include <sensor_msgs/CameraInfo.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/image_encodings.h>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <pylon_camera/image_kernels.h>
+
+namespace
+{
+
+// [width, height, channels]
+void imageSizes(benchmark::internal::Benchmark* b)
+{
+    const int sizes[][2] = { { 640, 480 },
+                             { 1280, 1024 },
+                             { 1920, 1200 },
+                             { 2592, 2048 } };
+    for ( const int channels : { 1, 3 } )
+    {
+        for ( const auto& size : sizes )
+        {
+            b->Args({ size[0], size[1], channels });
+        }
+    }
+    b->ArgNames({ "width", "height", "channels" });
+}
+
+const int DOWNSAMPLING_FACTOR = 20;  // default of the node
+
+std::vector<uint8_t> randomImage(const std::size_t& size)
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, 255);
+    std::vector<uint8_t> data(size);
+    for ( uint8_t& value : data )
+    {
+        value = static_cast<uint8_t>(dist(gen));
+    }
+    return data;
+}
+
+sensor_msgs::Image imageMsg(const benchmark::State& state)
+{
+    sensor_msgs::Image msg;
+    msg.width = state.range(0);
+    msg.height = state.range(1);
+    msg.encoding = state.range(2) == 1 ? sensor_msgs::image_encodings::MONO8
+                                       : sensor_msgs::image_encodings::RGB8;
+    msg.step = msg.width * state.range(2);
+    msg.data = randomImage(msg.step * msg.height);
+    return msg;
+}
+
+void setBytesProcessed(benchmark::State& state)
+{
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                            state.range(0) * state.range(1) * state.range(2));
+}
+
+// previous implementations as baseline for the comparison
+
+float referenceSampledMean(const std::vector<uint8_t>& data,
+                           const std::vector<std::size_t>& indices)
+{
+    float sum = 0.0;
+    for ( const std::size_t& idx : indices )
+    {
+       sum += data.at(idx);
+    }
+    if ( sum > 0.0 )
+    {
+        sum /= static_cast<float>(indices.size());
+    }
+    return sum;
+}
+
+float referenceMean(const std::vector<uint8_t>& data)
+{
+    float sum = std::accumulate(data.begin(), data.end(), 0);
+    if ( sum > 0.0 )
+    {
+        sum /= static_cast<float>(data.size());
+    }
+    return sum;
+}
+
+// scalar per-pixel decimation as baseline of the SIMD version
+void referenceDecimate(const std::vector<uint8_t>& src,
+                       const std::size_t& rows,
+                       const std::size_t& cols,
+                       const std::size_t& bytes_per_pixel,
+                       const std::size_t& decimation,
+                       std::vector<uint8_t>& dst)
+{
+    const std::size_t out_cols = cols / decimation;
+    std::size_t i = 0;
+    for ( std::size_t row = 0; row < rows; row += decimation )
+    {
+        for ( std::size_t col = 0; col < out_cols * decimation; col += decimation )
+        {
+            for ( std::size_t byte = 0; byte < bytes_per_pixel; ++byte )
+            {
+                dst[i++] = src[(row * cols + col) * bytes_per_pixel + byte];
+            }
+        }
+    }
+}
+
+// scalar Laplacian variance of every row as baseline of the SIMD version
+double referenceLaplacianVariance(const std::vector<uint8_t>& data,
+                                  const std::size_t& rows,
+                                  const std::size_t& row_bytes,
+                                  const std::size_t& dx)
+{
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    std::size_t count = 0;
+    for ( std::size_t row = 1; row + 1 < rows; ++row )
+    {
+        for ( std::size_t col = dx; col + dx < row_bytes; ++col )
+        {
+            const std::size_t idx = row * row_bytes + col;
+            const double laplacian = data[idx - row_bytes] + data[idx + row_bytes] +
+                                     data[idx - dx] + data[idx + dx] - 4.0 * data[idx];
+            sum += laplacian;
+            sum_sq += laplacian * laplacian;
+            ++count;
+        }
+    }
+    const double mean = sum / count;
+    return sum_sq / count - mean * mean;
+}
+
+// scalar mean absolute difference as baseline of the SIMD version
+float referenceSampledRowsMeanAbsDiff(const std::vector<uint8_t>& data,
+                                      const std::size_t& rows,
+                                      const std::size_t& row_bytes,
+                                      const std::size_t& row_step,
+                                      const std::vector<uint8_t>& reference)
+{
+    uint64_t sad = 0;
+    std::size_t count = 0;
+    for ( std::size_t row = 0; row < rows; row += row_step )
+    {
+        for ( std::size_t col = 0; col < row_bytes; ++col )
+        {
+            sad += std::abs(data[row * row_bytes + col] - reference[count]);
+            ++count;
+        }
+    }
+    return static_cast<float>(sad) / static_cast<float>(count);
+}
+
+const int CHANGE_ROW_STEP = 8;  // default of the node
+
+// scalar per-pixel box average as baseline of the SIMD version
+void referenceBoxDownscale(const std::vector<uint8_t>& src,
+                           const std::size_t& rows,
+                           const std::size_t& cols,
+                           const std::size_t& channels,
+                           const std::size_t& factor,
+                           std::vector<uint8_t>& dst)
+{
+    const std::size_t out_cols = cols / factor;
+    for ( std::size_t row = 0; row < rows / factor; ++row )
+    {
+        for ( std::size_t col = 0; col < out_cols; ++col )
+        {
+            for ( std::size_t ch = 0; ch < channels; ++ch )
+            {
+                uint32_t sum = 0;
+                for ( std::size_t i = 0; i < factor; ++i )
+                {
+                    for ( std::size_t j = 0; j < factor; ++j )
+                    {
+                        sum += src[((row * factor + i) * cols + col * factor + j) * channels + ch];
+                    }
+                }
+                dst[(row * out_cols + col) * channels + ch] =
+                                        (sum + factor * factor / 2) / (factor * factor);
+            }
+        }
+    }
+}
+
+const int PREVIEW_FACTOR = 4;
+
+}  // namespace
+
+static void BM_SetupSamplingIndices(benchmark::State& state)
+{
+    std::vector<std::size_t> indices;
+    for ( auto _ : state )
+    {
+        pylon_camera::image_kernels::setupSamplingIndices(indices,
+                                                          state.range(1),
+                                                          state.range(0),
+                                                          DOWNSAMPLING_FACTOR);
+        benchmark::DoNotOptimize(indices.data());
+    }
+    state.counters["indices"] = indices.size();
+}
+BENCHMARK(BM_SetupSamplingIndices)->Apply(imageSizes);
+
+static void BM_SampledMean_Reference(benchmark::State& state)
+{
+    const sensor_msgs::Image msg = imageMsg(state);
+    std::vector<std::size_t> indices;
+    pylon_camera::image_kernels::setupSamplingIndices(indices,
+                                                      msg.height,
+                                                      msg.width,
+                                                      DOWNSAMPLING_FACTOR);
+    for ( auto _ : state )
+    {
+        benchmark::DoNotOptimize(referenceSampledMean(msg.data, indices));
+        // the input is invariant, prevent hoisting the kernel out of the loop
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_SampledMean_Reference)->Apply(imageSizes);
+
+static void BM_SampledMean(benchmark::State& state)
+{
+    const sensor_msgs::Image msg = imageMsg(state);
+    std::vector<std::size_t> indices;
+    pylon_camera::image_kernels::setupSamplingIndices(indices,
+                                                      msg.height,
+                                                      msg.width,
+                                                      DOWNSAMPLING_FACTOR);
+    for ( auto _ : state )
+    {
+        benchmark::DoNotOptimize(
+                pylon_camera::image_kernels::sampledMean(msg.data, indices));
+        // the input is invariant, prevent hoisting the kernel out of the loop
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_SampledMean)->Apply(imageSizes);
+
+static void BM_Mean_Reference(benchmark::State& state)
+{
+    const sensor_msgs::Image msg = imageMsg(state);
+    for ( auto _ : state )
+    {
+        benchmark::DoNotOptimize(referenceMean(msg.data));
+        // the input is invariant, prevent hoisting the kernel out of the loop
+        benchmark::ClobberMemory();
+    }
+    setBytesProcessed(state);
+}
+BENCHMARK(BM_Mean_Reference)->Apply(imageSizes);
+
+static void BM_Mean(benchmark::State& state)
+{
+    const sensor_msgs::Image msg = imageMsg(state);
+    for ( auto _ : state )
+    {
+        benchmark::DoNotOptimize(pylon_camera::image_kernels::mean(msg.data));
+        // the input is invariant, prevent hoisting the kernel out of the loop
+        benchmark::ClobberMemory();
+    }
+    setBytesProcessed(state);
+}
+BENCHMARK(BM_Mean)->Apply(imageSizes);
+
+// the copy of the grab result buffer in PylonCamera::grab(std::vector<uint8_t>&)
+static void BM_GrabCopy(benchmark::State& state)
+{
+    const sensor_msgs::Image msg = imageMsg(state);
+    std::vector<uint8_t> image;
+    for ( auto _ : state )
+    {
+        image.assign(msg.data.data(), msg.data.data() + msg.data.size());
+        benchmark::DoNotOptimize(image.data());
+    }
+    setBytesProcessed(state);
+}
+BENCHMARK(BM_GrabCopy)->Apply(imageSizes);
+
+// the software decimation by 2 x 2 in PylonCamera::grab()
+static void BM_Decimate_Reference(benchmark::State& state)
+{
+    const sensor_msgs::Image msg = imageMsg(state);
+    std::vector<uint8_t> image(msg.data.size() / 4);
+    for ( auto _ : state )
+    {
+        referenceDecimate(msg.data, msg.height, msg.width, state.range(2), 2, image);
+        benchmark::DoNotOptimize(image.data());
+        benchmark::ClobberMemory();
+    }
+    setBytesProcessed(state);
+}
+BENCHMARK(BM_Decimate_Reference)->Apply(imageSizes);
+
+static void BM_Decimate(benchmark::State& state)
+{
+    const sensor_msgs::Image msg = imageMsg(state);
+    std::vector<uint8_t> image(msg.data.size() / 4);
+    for ( auto _ : state )
+    {
+        pylon_camera::image_kernels::decimate(msg.data.data(),
+                                              msg.height,
+                                              msg.width,
+                                              state.range(2),
+                                              1,
+                                              2,
+                                              2,
+                                              image.data());
+        benchmark::DoNotOptimize(image.data());
+        benchmark::ClobberMemory();
+    }
+    setBytesProcessed(state);
+}
+BENCHMARK(BM_Decimate)->Apply(imageSizes);
+
+// the sharpness of the whole image, every row
+static void BM_LaplacianVariance_Reference(benchmark::State& state)
+{
+    const sensor_msgs::Image msg = imageMsg(state);
+    for ( auto _ : state )
+    {
+        benchmark::DoNotOptimize(
+                referenceLaplacianVariance(msg.data, msg.height, msg.step, state.range(2)));
+        // the input is invariant, prevent hoisting the kernel out of the loop
+        benchmark::ClobberMemory();
+    }
+    setBytesProcessed(state);
+}
+BENCHMARK(BM_LaplacianVariance_Reference)->Apply(imageSizes);
+
+static void BM_LaplacianVariance(benchmark::State& state)
+{
+    const sensor_msgs::Image msg = imageMsg(state);
+    const cv::Rect roi(0, 0, msg.step, msg.height);
+    for ( auto _ : state )
+    {
+        benchmark::DoNotOptimize(
+                pylon_camera::image_kernels::laplacianVariance(msg.data.data(),
+                                                               msg.height,
+                                                               msg.step,
+                                                               roi,
+                                                               state.range(2),
+                                                               1,
+                                                               1));
+        // the input is invariant, prevent hoisting the kernel out of the loop
+        benchmark::ClobberMemory();
+    }
+    setBytesProcessed(state);
+}
+BENCHMARK(BM_LaplacianVariance)->Apply(imageSizes);
+
+// the change detection against the last published image
+static void BM_SampledRowsMeanAbsDiff_Reference(benchmark::State& state)
+{
+    const sensor_msgs::Image msg = imageMsg(state);
+    std::vector<uint8_t> reference;
+    pylon_camera::image_kernels::copySampledRows(msg.data.data(), msg.height, msg.step,
+                                                 CHANGE_ROW_STEP, reference);
+    for ( auto _ : state )
+    {
+        benchmark::DoNotOptimize(referenceSampledRowsMeanAbsDiff(msg.data, msg.height, msg.step,
+                                                                 CHANGE_ROW_STEP, reference));
+        // the input is invariant, prevent hoisting the kernel out of the loop
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_SampledRowsMeanAbsDiff_Reference)->Apply(imageSizes);
+
+static void BM_SampledRowsMeanAbsDiff(benchmark::State& state)
+{
+    const sensor_msgs::Image msg = imageMsg(state);
+    std::vector<uint8_t> reference;
+    pylon_camera::image_kernels::copySampledRows(msg.data.data(), msg.height, msg.step,
+                                                 CHANGE_ROW_STEP, reference);
+    for ( auto _ : state )
+    {
+        benchmark::DoNotOptimize(pylon_camera::image_kernels::sampledRowsMeanAbsDiff(
+                                        msg.data.data(), msg.height, msg.step,
+                                        CHANGE_ROW_STEP, reference));
+        // the input is invariant, prevent hoisting the kernel out of the loop
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_SampledRowsMeanAbsDiff)->Apply(imageSizes);
+
+// the downscale of the preview
+static void BM_BoxDownscale_Reference(benchmark::State& state)
+{
+    const sensor_msgs::Image msg = imageMsg(state);
+    std::vector<uint8_t> image(msg.data.size() / (PREVIEW_FACTOR * PREVIEW_FACTOR));
+    for ( auto _ : state )
+    {
+        referenceBoxDownscale(msg.data, msg.height, msg.width, state.range(2),
+                              PREVIEW_FACTOR, image);
+        benchmark::DoNotOptimize(image.data());
+        benchmark::ClobberMemory();
+    }
+    setBytesProcessed(state);
+}
+BENCHMARK(BM_BoxDownscale_Reference)->Apply(imageSizes);
+
+static void BM_BoxDownscale(benchmark::State& state)
+{
+    const sensor_msgs::Image msg = imageMsg(state);
+    std::vector<uint8_t> image(msg.data.size() / (PREVIEW_FACTOR * PREVIEW_FACTOR));
+    std::vector<uint32_t> column_sums;
+    for ( auto _ : state )
+    {
+        pylon_camera::image_kernels::boxDownscale(msg.data.data(), msg.height, msg.width,
+                                                  state.range(2), PREVIEW_FACTOR,
+                                                  column_sums, image.data());
+        benchmark::DoNotOptimize(image.data());
+        benchmark::ClobberMemory();
+    }
+    setBytesProcessed(state);
+}
+BENCHMARK(BM_BoxDownscale)->Apply(imageSizes);
+
+static void BM_ToCvCopy(benchmark::State& state)
+{
+    const sensor_msgs::Image msg = imageMsg(state);
+    for ( auto _ : state )
+    {
+        cv_bridge::CvImagePtr cv_img = cv_bridge::toCvCopy(msg, msg.encoding);
+        benchmark::DoNotOptimize(cv_img->image.data);
+    }
+    setBytesProcessed(state);
+}
+BENCHMARK(BM_ToCvCopy)->Apply(imageSizes);
+
+// toCvCopy + rectifyImage as done by PylonCameraNode::grabImage()
+static void BM_Rectify(benchmark::State& state)
+{
+    const sensor_msgs::Image msg = imageMsg(state);
+    sensor_msgs::CameraInfo cam_info;
+    cam_info.width = msg.width;
+    cam_info.height = msg.height;
+    cam_info.distortion_model = "plumb_bob";
+    cam_info.D = { -0.3, 0.1, 0.001, -0.001, 0.0 };
+    const double fx = msg.width, cx = 0.5 * msg.width, cy = 0.5 * msg.height;
+    cam_info.K = { fx, 0.0, cx, 0.0, fx, cy, 0.0, 0.0, 1.0 };
+    cam_info.R = { 1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0 };
+    cam_info.P = { fx, 0.0, cx, 0.0, 0.0, fx, cy, 0.0, 0.0, 0.0, 1.0, 0.0 };
+
+    image_geometry::PinholeCameraModel pinhole_model;
+    pinhole_model.fromCameraInfo(cam_info);
+    cv::Mat rect;
+    for ( auto _ : state )
+    {
+        cv_bridge::CvImagePtr cv_img = cv_bridge::toCvCopy(msg, msg.encoding);
+        pinhole_model.fromCameraInfo(cam_info);
+        pinhole_model.rectifyImage(cv_img->image, rect);
+        benchmark::DoNotOptimize(rect.data);
+    }
+    setBytesProcessed(state);
+}
+BENCHMARK(BM_Rectify)->Apply(imageSizes);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,411 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+/*
+ * End-to-end benchmark of the PylonCameraNode on top of the SoftwareCamera.
+ * For each combination of resolution, encoding and frame rate the node is
+ * spun like in main.cpp while a subscriber of image_raw measures the
+ * achieved frame rate and the trigger-to-receive latency. CPU time and heap
+ * allocations are measured process wide, hence they include the subscriber.
+ *
+ * Usage (with a running roscore):
+ *   rosrun pylon_camera pylon_camera_benchmark _duration:=5.0 _output:=/tmp/bench
+ * writes /tmp/bench.json and /tmp/bench.csv. Exits with failure if a
+ * GrabImages goal in steady state allocates more than
+ * _grab_images_max_allocations (default 0) times.
+ */
+
+#include <ros/ros.h>
+#include <sensor_msgs/Image.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <pylon_camera/latency_stats.h>
+#include <pylon_camera/pylon_camera_node.h>
+#include "software_camera.h"
+
+namespace
+{
+
+std::atomic<uint64_t> g_num_allocations(0);
+
+}  // namespace
+
+void* operator new(std::size_t size)
+{
+    g_num_allocations.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = std::malloc(size);
+    if ( ptr == nullptr )
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+namespace pylon_camera
+{
+
+struct BenchmarkConfig
+{
+    size_t width;
+    size_t height;
+    std::string encoding;
+    double frame_rate;
+};
+
+struct BenchmarkResult
+{
+    BenchmarkConfig config;
+    double duration;
+    uint64_t frames_grabbed;
+    uint64_t frames_received;
+    double fps;
+    LatencySummary latency;
+    double cpu_us_per_frame;
+    double allocations_per_frame;
+};
+
+/**
+ * Subscriber of the image_raw topic which records the latency of each frame
+ */
+class FrameReceiver
+{
+public:
+    FrameReceiver() : num_received_(0), latency_() {}
+
+    void imageCB(const sensor_msgs::ImageConstPtr& msg)
+    {
+        const uint64_t trigger_ns = SoftwareCamera::triggerTime(msg->data);
+        if ( trigger_ns != 0 )
+        {
+            latency_.record(LatencyStats::now() - trigger_ns);
+        }
+        num_received_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> num_received_;
+    LatencyHistogram latency_;
+};
+
+double cpuTimeUs()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e6
+         + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+BenchmarkResult runBenchmark(const BenchmarkConfig& config,
+                             const double& duration)
+{
+    ros::NodeHandle pnh("~");
+    pnh.setParam("image_encoding", config.encoding);
+    pnh.setParam("frame_rate", config.frame_rate);
+
+    SoftwareCamera* camera = new SoftwareCamera(config.width,
+                                                config.height,
+                                                1000.0);
+    PylonCameraNode* node = new PylonCameraNode(camera);
+
+    FrameReceiver receiver;
+    ros::Subscriber sub = pnh.subscribe(pnh.resolveName("image_raw"),
+                                        10,
+                                        &FrameReceiver::imageCB,
+                                        &receiver);
+    ros::Time connect_timeout = ros::Time::now() + ros::Duration(5.0);
+    while ( ros::ok() && node->getNumSubscribersRaw() == 0 &&
+            ros::Time::now() < connect_timeout )
+    {
+        ros::Duration(0.01).sleep();
+    }
+
+    // warm up, so the first allocations of the publisher are not counted
+    ros::Rate r(node->frameRate());
+    for ( size_t i = 0; i < 5 && ros::ok(); ++i )
+    {
+        node->spin();
+        r.sleep();
+    }
+    ros::Duration(0.1).sleep();
+    receiver.latency_.snapshotAndReset();
+
+    const uint64_t frames_start = camera->numFrames();
+    const uint64_t received_start = receiver.num_received_.load();
+    const uint64_t allocs_start = g_num_allocations.load();
+    const double cpu_start = cpuTimeUs();
+    const ros::WallTime start = ros::WallTime::now();
+
+    while ( ros::ok() && (ros::WallTime::now() - start).toSec() < duration )
+    {
+        node->spin();
+        r.sleep();
+    }
+    // let the last frames arrive
+    ros::Duration(0.1).sleep();
+
+    BenchmarkResult result;
+    result.config = config;
+    result.duration = (ros::WallTime::now() - start).toSec();
+    result.frames_grabbed = camera->numFrames() - frames_start;
+    result.frames_received = receiver.num_received_.load() - received_start;
+    result.fps = result.frames_received / result.duration;
+    result.latency = receiver.latency_.snapshotAndReset();
+    const double frames = std::max(static_cast<double>(result.frames_grabbed), 1.0);
+    result.cpu_us_per_frame = (cpuTimeUs() - cpu_start) / frames;
+    result.allocations_per_frame = (g_num_allocations.load() - allocs_start) / frames;
+
+    sub.shutdown();
+    delete node;
+    return result;
+}
+
+/**
+ * Gives the benchmark access to the GrabImages implementation of the node,
+ * without the actionlib transport around it
+ */
+class GrabImagesNode : public PylonCameraNode
+{
+public:
+    explicit GrabImagesNode(PylonCamera* pylon_camera)
+        : PylonCameraNode(pylon_camera)
+    {}
+
+    bool grabImages(const camera_control_msgs::GrabImagesGoal::ConstPtr& goal)
+    {
+        grabImagesRaw(goal, nullptr, grab_imgs_raw_result_);
+        return grab_imgs_raw_result_.success;
+    }
+};
+
+/**
+ * Heap allocations per GrabImages goal in steady state, i.e. after the
+ * frame buffer pool is warm
+ */
+double runGrabImagesBenchmark(const BenchmarkConfig& config,
+                              const int& num_goals,
+                              const int& images_per_goal)
+{
+    ros::NodeHandle pnh("~");
+    pnh.setParam("image_encoding", config.encoding);
+
+    SoftwareCamera* camera = new SoftwareCamera(config.width,
+                                                config.height,
+                                                1000.0);
+    GrabImagesNode* node = new GrabImagesNode(camera);
+
+    camera_control_msgs::GrabImagesGoal::Ptr goal(
+                                    new camera_control_msgs::GrabImagesGoal());
+    goal->exposure_given = true;
+    goal->exposure_times.assign(images_per_goal, 5000.0);
+
+    for ( int i = 0; i < 5 && ros::ok(); ++i )
+    {
+        node->grabImages(goal);
+    }
+
+    const uint64_t allocs_start = g_num_allocations.load();
+    int goals = 0;
+    for ( ; goals < num_goals && ros::ok(); ++goals )
+    {
+        if ( !node->grabImages(goal) )
+        {
+            ROS_ERROR("GrabImages goal failed");
+            break;
+        }
+    }
+    const double allocations = static_cast<double>(
+                                    g_num_allocations.load() - allocs_start);
+
+    delete node;
+    return allocations / std::max(goals, 1);
+}
+
+std::vector<std::string> split(const std::string& str, const char& delim)
+{
+    std::vector<std::string> tokens;
+    std::stringstream ss(str);
+    std::string token;
+    while ( std::getline(ss, token, delim) )
+    {
+        if ( !token.empty() )
+        {
+            tokens.push_back(token);
+        }
+    }
+    return tokens;
+}
+
+void writeResults(const std::vector<BenchmarkResult>& results,
+                  const std::string& output)
+{
+    std::ofstream csv((output + ".csv").c_str());
+    csv << "width,height,encoding,frame_rate,duration,frames_grabbed,"
+        << "frames_received,fps,latency_mean_us,latency_p50_us,latency_p90_us,"
+        << "latency_p99_us,latency_max_us,cpu_us_per_frame,allocations_per_frame\n";
+    std::ofstream json((output + ".json").c_str());
+    json << "{\n  \"benchmark\": \"pylon_camera_node\",\n  \"results\": [\n";
+    for ( size_t i = 0; i < results.size(); ++i )
+    {
+        const BenchmarkResult& r = results[i];
+        csv << r.config.width << "," << r.config.height << ","
+            << r.config.encoding << "," << r.config.frame_rate << ","
+            << r.duration << "," << r.frames_grabbed << ","
+            << r.frames_received << "," << r.fps << ","
+            << r.latency.mean * 1e-3 << "," << r.latency.p50 * 1e-3 << ","
+            << r.latency.p90 * 1e-3 << "," << r.latency.p99 * 1e-3 << ","
+            << r.latency.max * 1e-3 << "," << r.cpu_us_per_frame << ","
+            << r.allocations_per_frame << "\n";
+        json << "    {\"name\": \"" << r.config.width << "x" << r.config.height
+             << "/" << r.config.encoding << "/" << r.config.frame_rate << "Hz\", "
+             << "\"width\": " << r.config.width << ", "
+             << "\"height\": " << r.config.height << ", "
+             << "\"encoding\": \"" << r.config.encoding << "\", "
+             << "\"frame_rate\": " << r.config.frame_rate << ", "
+             << "\"duration\": " << r.duration << ", "
+             << "\"frames_grabbed\": " << r.frames_grabbed << ", "
+             << "\"frames_received\": " << r.frames_received << ", "
+             << "\"fps\": " << r.fps << ", "
+             << "\"latency_mean_us\": " << r.latency.mean * 1e-3 << ", "
+             << "\"latency_p50_us\": " << r.latency.p50 * 1e-3 << ", "
+             << "\"latency_p90_us\": " << r.latency.p90 * 1e-3 << ", "
+             << "\"latency_p99_us\": " << r.latency.p99 * 1e-3 << ", "
+             << "\"latency_max_us\": " << r.latency.max * 1e-3 << ", "
+             << "\"cpu_us_per_frame\": " << r.cpu_us_per_frame << ", "
+             << "\"allocations_per_frame\": " << r.allocations_per_frame << "}"
+             << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+}
+
+}  // namespace pylon_camera
+
+int main(int argc, char **argv)
+{
+    using pylon_camera::BenchmarkConfig;
+    using pylon_camera::BenchmarkResult;
+
+    ros::init(argc, argv, "pylon_camera_benchmark");
+    ros::NodeHandle pnh("~");
+
+    double duration;
+    std::string output, resolutions, encodings, frame_rates;
+    pnh.param<double>("duration", duration, 5.0);
+    pnh.param<std::string>("output", output, "pylon_camera_benchmark");
+    pnh.param<std::string>("resolutions", resolutions, "640x480,1280x1024,2592x2048");
+    pnh.param<std::string>("encodings", encodings, "mono8,rgb8");
+    pnh.param<std::string>("frame_rates", frame_rates, "10,30,100");
+    int grab_images_goals, grab_images_per_goal;
+    pnh.param<int>("grab_images_goals", grab_images_goals, 100);
+    pnh.param<int>("grab_images_per_goal", grab_images_per_goal, 4);
+    // GrabImages goals in steady state must not allocate, a negative value
+    // disables the check
+    double grab_images_max_allocations;
+    pnh.param<double>("grab_images_max_allocations", grab_images_max_allocations, 0.0);
+    bool success = true;
+
+    // the subscriber runs in the spinner, the node is spun by this thread
+    ros::AsyncSpinner spinner(2);
+    spinner.start();
+
+    std::vector<BenchmarkResult> results;
+    for ( const std::string& resolution : pylon_camera::split(resolutions, ',') )
+    {
+        std::vector<std::string> size = pylon_camera::split(resolution, 'x');
+        if ( size.size() != 2 )
+        {
+            ROS_ERROR_STREAM("Invalid resolution '" << resolution << "'");
+            continue;
+        }
+        for ( const std::string& encoding : pylon_camera::split(encodings, ',') )
+        {
+            if ( grab_images_goals > 0 && ros::ok() )
+            {
+                BenchmarkConfig config;
+                config.width = std::stoul(size[0]);
+                config.height = std::stoul(size[1]);
+                config.encoding = encoding;
+                config.frame_rate = 0.0;
+                double allocations = pylon_camera::runGrabImagesBenchmark(
+                                                        config,
+                                                        grab_images_goals,
+                                                        grab_images_per_goal);
+                ROS_INFO_STREAM(resolution << " " << encoding << " GrabImages "
+                        << "with " << grab_images_per_goal << " images: "
+                        << allocations << " allocations / goal");
+                if ( grab_images_max_allocations >= 0.0 &&
+                     allocations > grab_images_max_allocations )
+                {
+                    ROS_ERROR_STREAM(resolution << " " << encoding << " GrabImages "
+                            << "exceeds the limit of " << grab_images_max_allocations
+                            << " allocations / goal");
+                    success = false;
+                }
+            }
+            for ( const std::string& rate : pylon_camera::split(frame_rates, ',') )
+            {
+                BenchmarkConfig config;
+                config.width = std::stoul(size[0]);
+                config.height = std::stoul(size[1]);
+                config.encoding = encoding;
+                config.frame_rate = std::stod(rate);
+                if ( !ros::ok() )
+                {
+                    break;
+                }
+                BenchmarkResult result = pylon_camera::runBenchmark(config, duration);
+                ROS_INFO_STREAM(resolution << " " << encoding << " @ "
+                        << config.frame_rate << " Hz: " << result.fps << " fps, "
+                        << "latency p50 = " << result.latency.p50 * 1e-3 << " us, "
+                        << "p99 = " << result.latency.p99 * 1e-3 << " us, "
+                        << result.cpu_us_per_frame << " us CPU / frame, "
+                        << result.allocations_per_frame << " allocations / frame");
+                results.push_back(result);
+            }
+        }
+    }
+
+    pylon_camera::writeResults(results, output);
+    ROS_INFO_STREAM("Wrote results to " << output << ".json and " << output << ".csv");
+
+    spinner.stop();
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,428 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include "software_camera.h"
+
+#include <pylon/PylonIncludes.h>
+#include <sensor_msgs/image_encodings.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pylon_camera
+{
+
+SoftwareCamera::SoftwareCamera(const size_t& width,
+                               const size_t& height,
+                               const float& max_framerate)
+    : PylonCamera(),
+      sensor_width_(width),
+      sensor_height_(height),
+      max_framerate_(max_framerate),
+      binning_x_(1),
+      binning_y_(1),
+      encoding_(sensor_msgs::image_encodings::MONO8),
+      exposure_(1000.0),
+      gain_(0.0),
+      gamma_(1.0),
+      frame_(),
+      num_frames_(0)
+{
+    // the PylonCamera destructor releases the pylon runtime
+    Pylon::PylonInitialize();
+    device_user_id_ = "software_camera";
+    grab_timeout_ = 1.0;
+    updateImageSize();
+}
+
+SoftwareCamera::~SoftwareCamera()
+{}
+
+uint64_t SoftwareCamera::triggerTime(const std::vector<uint8_t>& data)
+{
+    uint64_t trigger_ns = 0;
+    if ( data.size() >= sizeof(trigger_ns) )
+    {
+        std::memcpy(&trigger_ns, data.data(), sizeof(trigger_ns));
+    }
+    return trigger_ns;
+}
+
+uint64_t SoftwareCamera::numFrames() const
+{
+    return num_frames_.load();
+}
+
+bool SoftwareCamera::registerCameraConfiguration()
+{
+    return true;
+}
+
+bool SoftwareCamera::openCamera()
+{
+    return true;
+}
+
+bool SoftwareCamera::setupSequencer(const std::vector<float>& exposure_times)
+{
+    return false;
+}
+
+bool SoftwareCamera::applyCamSpecificStartupSettings(const PylonCameraSettings& parameters)
+{
+    return true;
+}
+
+bool SoftwareCamera::loadFeatures(const PylonCameraSettings& parameters)
+{
+    // nothing persisted, the benchmark always starts cold
+    return false;
+}
+
+bool SoftwareCamera::saveFeatures(const PylonCameraSettings& parameters)
+{
+    return false;
+}
+
+std::string SoftwareCamera::deviceIdentity()
+{
+    return "Software";
+}
+
+bool SoftwareCamera::startGrabbing(const PylonCameraSettings& parameters)
+{
+    if ( !setImageEncoding(parameters.imageEncoding()) )
+    {
+        return false;
+    }
+    is_ready_ = true;
+    return true;
+}
+
+bool SoftwareCamera::pauseGrabbing()
+{
+    // the frames are generated on demand, there is nothing to stop
+    return true;
+}
+
+bool SoftwareCamera::resumeGrabbing()
+{
+    return true;
+}
+
+void SoftwareCamera::expose()
+{
+    const uint64_t trigger_ns = LatencyStats::now();
+    if ( latency_stats_ )
+    {
+        latency_stats_->record(LS_TRIGGER_WAIT, trigger_ns);
+    }
+
+    // a new frame is ready after the exposure, but never faster than the
+    // sensor can read out
+    const double frame_time_us = std::max(static_cast<double>(exposure_),
+                                          1e6 / max_framerate_);
+    std::this_thread::sleep_until(
+            std::chrono::steady_clock::time_point(
+                    std::chrono::nanoseconds(trigger_ns)) +
+            std::chrono::microseconds(static_cast<int64_t>(frame_time_us)));
+
+    // change one row per frame, so consecutive frames differ
+    const size_t row_size = img_cols_ * imagePixelDepth();
+    const size_t row = num_frames_.load() % img_rows_;
+    std::memset(&frame_[row * row_size],
+                static_cast<int>(num_frames_.load() & 0xff),
+                row_size);
+    std::memcpy(frame_.data(), &trigger_ns, sizeof(trigger_ns));
+    ++num_frames_;
+    // a software frame is never lost, the block ID is the frame number
+    trackFrame(num_frames_.load(), 0, 0);
+
+    if ( latency_stats_ )
+    {
+        latency_stats_->record(LS_RETRIEVE, trigger_ns);
+    }
+}
+
+bool SoftwareCamera::grab(std::vector<uint8_t>& image)
+{
+    expose();
+    uint64_t copy_start = latency_stats_ ? LatencyStats::now() : 0;
+    image.assign(frame_.begin(), frame_.end());
+    if ( latency_stats_ )
+    {
+        latency_stats_->record(LS_COPY, copy_start);
+    }
+    return true;
+}
+
+bool SoftwareCamera::grab(uint8_t* image)
+{
+    expose();
+    uint64_t copy_start = latency_stats_ ? LatencyStats::now() : 0;
+    std::memcpy(image, frame_.data(), img_size_byte_);
+    if ( latency_stats_ )
+    {
+        latency_stats_->record(LS_COPY, copy_start);
+    }
+    return true;
+}
+
+bool SoftwareCamera::setShutterMode(const pylon_camera::SHUTTER_MODE& mode)
+{
+    return true;
+}
+
+bool SoftwareCamera::setBinningX(const size_t& target_binning_x,
+                                 size_t& reached_binning_x)
+{
+    binning_x_ = std::max(static_cast<size_t>(1),
+                          std::min(target_binning_x, static_cast<size_t>(4)));
+    reached_binning_x = binning_x_;
+    updateImageSize();
+    return true;
+}
+
+bool SoftwareCamera::setBinningY(const size_t& target_binning_y,
+                                 size_t& reached_binning_y)
+{
+    binning_y_ = std::max(static_cast<size_t>(1),
+                          std::min(target_binning_y, static_cast<size_t>(4)));
+    reached_binning_y = binning_y_;
+    updateImageSize();
+    return true;
+}
+
+bool SoftwareCamera::setGeometry(const ImageGeometry& target, ImageGeometry& reached)
+{
+    binning_x_ = std::max(static_cast<size_t>(1),
+                          std::min(target.binning_x, static_cast<size_t>(4)));
+    binning_y_ = std::max(static_cast<size_t>(1),
+                          std::min(target.binning_y, static_cast<size_t>(4)));
+    updateImageSize();
+    reached = currentGeometry();
+    return true;
+}
+
+ImageGeometry SoftwareCamera::currentGeometry()
+{
+    ImageGeometry geometry;
+    geometry.binning_x = binning_x_;
+    geometry.binning_y = binning_y_;
+    // the software camera has no AOI, it always delivers the full sensor
+    geometry.roi_width = sensor_width_;
+    geometry.roi_height = sensor_height_;
+    return geometry;
+}
+
+bool SoftwareCamera::setAutoFunctionAOI(const size_t& offset_x,
+                                        const size_t& offset_y,
+                                        const size_t& width,
+                                        const size_t& height)
+{
+    // no auto functions, the node meters in software
+    return false;
+}
+
+std::vector<std::string> SoftwareCamera::detectAvailableImageEncodings()
+{
+    std::vector<std::string> encodings;
+    encodings.push_back(sensor_msgs::image_encodings::MONO8);
+    encodings.push_back(sensor_msgs::image_encodings::RGB8);
+    encodings.push_back(sensor_msgs::image_encodings::BGR8);
+    return encodings;
+}
+
+bool SoftwareCamera::setImageEncoding(const std::string& target_ros_encoding)
+{
+    std::vector<std::string> encodings = detectAvailableImageEncodings();
+    if ( std::find(encodings.begin(), encodings.end(), target_ros_encoding)
+            == encodings.end() )
+    {
+        ROS_ERROR_STREAM("SoftwareCamera does not support the encoding '"
+                << target_ros_encoding << "'");
+        return false;
+    }
+    encoding_ = target_ros_encoding;
+    updateImageSize();
+    return true;
+}
+
+void SoftwareCamera::updateImageSize()
+{
+    img_cols_ = sensor_width_ / binning_x_;
+    img_rows_ = sensor_height_ / binning_y_;
+    img_size_byte_ = img_cols_ * img_rows_ * imagePixelDepth();
+    frame_.assign(img_size_byte_, 0);
+}
+
+bool SoftwareCamera::setExposure(const float& target_exposure, float& reached_exposure)
+{
+    exposure_ = std::max(target_exposure, 10.0f);
+    reached_exposure = exposure_;
+    return true;
+}
+
+bool SoftwareCamera::setGain(const float& target_gain, float& reached_gain)
+{
+    gain_ = std::max(0.0f, std::min(target_gain, 1.0f));
+    reached_gain = gain_;
+    return true;
+}
+
+bool SoftwareCamera::setGamma(const float& target_gamma, float& reached_gamma)
+{
+    gamma_ = target_gamma;
+    reached_gamma = gamma_;
+    return true;
+}
+
+bool SoftwareCamera::setBrightness(const int& target_brightness,
+                                   const float& current_brightness,
+                                   const bool& exposure_auto,
+                                   const bool& gain_auto)
+{
+    return false;
+}
+
+bool SoftwareCamera::setExtendedBrightness(const int& target_brightness,
+                                           const float& current_brightness)
+{
+    return false;
+}
+
+std::vector<int> SoftwareCamera::detectAndCountNumUserOutputs()
+{
+    return std::vector<int>();
+}
+
+bool SoftwareCamera::setUserOutput(const int& output_id, const bool& value)
+{
+    return false;
+}
+
+size_t SoftwareCamera::currentBinningX()
+{
+    return binning_x_;
+}
+
+size_t SoftwareCamera::currentBinningY()
+{
+    return binning_y_;
+}
+
+std::string SoftwareCamera::currentROSEncoding() const
+{
+    return encoding_;
+}
+
+int SoftwareCamera::imagePixelDepth() const
+{
+    return encoding_ == sensor_msgs::image_encodings::MONO8 ? 1 : 3;
+}
+
+float SoftwareCamera::currentExposure()
+{
+    return exposure_;
+}
+
+float SoftwareCamera::currentAutoExposureTimeLowerLimit()
+{
+    return 10.0;
+}
+
+float SoftwareCamera::currentAutoExposureTimeUpperLimit()
+{
+    return 1e6;
+}
+
+float SoftwareCamera::currentGain()
+{
+    return gain_;
+}
+
+float SoftwareCamera::currentAutoGainLowerLimit()
+{
+    return 0.0;
+}
+
+float SoftwareCamera::currentAutoGainUpperLimit()
+{
+    return 1.0;
+}
+
+float SoftwareCamera::currentGamma()
+{
+    return gamma_;
+}
+
+float SoftwareCamera::currentTemperature()
+{
+    return std::numeric_limits<float>::quiet_NaN();
+}
+
+bool SoftwareCamera::isBrightnessSearchRunning()
+{
+    return false;
+}
+
+bool SoftwareCamera::isPylonAutoBrightnessFunctionRunning()
+{
+    return false;
+}
+
+void SoftwareCamera::disableAllRunningAutoBrightessFunctions()
+{}
+
+void SoftwareCamera::enableContinuousAutoExposure()
+{}
+
+void SoftwareCamera::enableContinuousAutoGain()
+{}
+
+std::string SoftwareCamera::typeName() const
+{
+    return "Software";
+}
+
+float SoftwareCamera::exposureStep()
+{
+    return 1.0;
+}
+
+float SoftwareCamera::maxPossibleFramerate()
+{
+    return max_framerate_;
+}
+
+}  // namespace pylon_camera
@@ -0,0 +1,203 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_BENCHMARK_SOFTWARE_CAMERA_H
+#define PYLON_CAMERA_BENCHMARK_SOFTWARE_CAMERA_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <pylon_camera/pylon_camera.h>
+
+namespace pylon_camera
+{
+
+/**
+ * PylonCamera backend which does not need any device. Each software trigger
+ * creates a frame after the current exposure time has elapsed. The first
+ * bytes of every frame contain the trigger time (LatencyStats::now()), so
+ * that subscribers can measure the trigger-to-receive latency.
+ */
+class SoftwareCamera : public PylonCamera
+{
+public:
+    /**
+     * @param width sensor width in pixels
+     * @param height sensor height in pixels
+     * @param max_framerate the max possible frame rate of the sensor
+     */
+    SoftwareCamera(const size_t& width,
+                   const size_t& height,
+                   const float& max_framerate);
+
+    virtual ~SoftwareCamera();
+
+    /**
+     * Extracts the trigger time a frame has been stamped with
+     * @param data the image data as published
+     * @return the trigger time in ns or 0 if the frame is too small
+     */
+    static uint64_t triggerTime(const std::vector<uint8_t>& data);
+
+    /**
+     * Number of frames grabbed since the construction
+     */
+    uint64_t numFrames() const;
+
+    virtual bool registerCameraConfiguration();
+
+    virtual bool openCamera();
+
+    virtual bool setupSequencer(const std::vector<float>& exposure_times);
+
+    virtual bool applyCamSpecificStartupSettings(const PylonCameraSettings& parameters);
+
+    virtual bool loadFeatures(const PylonCameraSettings& parameters);
+
+    virtual bool saveFeatures(const PylonCameraSettings& parameters);
+
+    virtual std::string deviceIdentity();
+
+    virtual bool startGrabbing(const PylonCameraSettings& parameters);
+
+    virtual bool pauseGrabbing();
+
+    virtual bool resumeGrabbing();
+
+    virtual bool grab(std::vector<uint8_t>& image);
+
+    virtual bool grab(uint8_t* image);
+
+    virtual bool setShutterMode(const pylon_camera::SHUTTER_MODE& mode);
+
+    virtual bool setBinningX(const size_t& target_binning_x,
+                             size_t& reached_binning_x);
+
+    virtual bool setBinningY(const size_t& target_binning_y,
+                             size_t& reached_binning_y);
+
+    virtual bool setGeometry(const ImageGeometry& target, ImageGeometry& reached);
+
+    virtual ImageGeometry currentGeometry();
+
+    virtual bool setAutoFunctionAOI(const size_t& offset_x,
+                                    const size_t& offset_y,
+                                    const size_t& width,
+                                    const size_t& height);
+
+    virtual std::vector<std::string> detectAvailableImageEncodings();
+
+    virtual bool setImageEncoding(const std::string& target_ros_encoding);
+
+    virtual bool setExposure(const float& target_exposure, float& reached_exposure);
+
+    virtual bool setGain(const float& target_gain, float& reached_gain);
+
+    virtual bool setGamma(const float& target_gamma, float& reached_gamma);
+
+    virtual bool setBrightness(const int& target_brightness,
+                               const float& current_brightness,
+                               const bool& exposure_auto,
+                               const bool& gain_auto);
+
+    virtual std::vector<int> detectAndCountNumUserOutputs();
+
+    virtual bool setUserOutput(const int& output_id, const bool& value);
+
+    virtual size_t currentBinningX();
+
+    virtual size_t currentBinningY();
+
+    virtual std::string currentROSEncoding() const;
+
+    virtual int imagePixelDepth() const;
+
+    virtual float currentExposure();
+
+    virtual float currentAutoExposureTimeLowerLimit();
+
+    virtual float currentAutoExposureTimeUpperLimit();
+
+    virtual float currentGain();
+
+    virtual float currentAutoGainLowerLimit();
+
+    virtual float currentAutoGainUpperLimit();
+
+    virtual float currentGamma();
+
+    virtual float currentTemperature();
+
+    virtual bool isBrightnessSearchRunning();
+
+    virtual bool isPylonAutoBrightnessFunctionRunning();
+
+    virtual void disableAllRunningAutoBrightessFunctions();
+
+    virtual void enableContinuousAutoExposure();
+
+    virtual void enableContinuousAutoGain();
+
+    virtual std::string typeName() const;
+
+    virtual float exposureStep();
+
+    virtual float maxPossibleFramerate();
+
+protected:
+    virtual bool setExtendedBrightness(const int& target_brightness,
+                                       const float& current_brightness);
+
+    /**
+     * Waits for the exposure and renders the frame into frame_
+     */
+    void expose();
+
+    /**
+     * Updates the image size after changing the binning or the encoding
+     */
+    void updateImageSize();
+
+    size_t sensor_width_;
+    size_t sensor_height_;
+    float max_framerate_;
+    size_t binning_x_;
+    size_t binning_y_;
+    std::string encoding_;
+    float exposure_;
+    float gain_;
+    float gamma_;
+    std::vector<uint8_t> frame_;
+    std::atomic<uint64_t> num_frames_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_BENCHMARK_SOFTWARE_CAMERA_H
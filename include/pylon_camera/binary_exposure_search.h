@@ -30,7 +30,7 @@
 #ifndef PYLON_CAMERA_BINARY_EXPOSURE_SEARCH_H
 #define PYLON_CAMERA_BINARY_EXPOSURE_SEARCH_H
 
-#include <ros/ros.h>
+#include <cstddef>
 
 namespace pylon_camera
 {
@@ -0,0 +1,101 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_FRAME_BUFFER_POOL_H
+#define PYLON_CAMERA_FRAME_BUFFER_POOL_H
+
+#include <boost/thread/mutex.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pylon_camera
+{
+
+/**
+ * Keeps the image buffers of finished GrabImages goals, such that the next
+ * goals can grab into memory which is already allocated. Buffers are moved
+ * in and out by swapping, hence neither acquire() nor release() copy or
+ * allocate once the pool is warm.
+ */
+class FrameBufferPool
+{
+public:
+    /**
+     * @param max_buffers the number of buffers the pool keeps at most, the
+     *        memory of further released buffers is freed
+     */
+    explicit FrameBufferPool(const size_t& max_buffers);
+
+    virtual ~FrameBufferPool();
+
+    /**
+     * Swaps the largest pooled buffer into buffer, the memory buffer held
+     * before goes into the pool. If the pool has no larger buffer, buffer
+     * is left as is.
+     * @param buffer the buffer to fill
+     */
+    void acquire(std::vector<uint8_t>& buffer);
+
+    /**
+     * Moves the memory of buffer into the pool, buffer is empty afterwards
+     * @param buffer the buffer to release
+     */
+    void release(std::vector<uint8_t>& buffer);
+
+    /**
+     * Number of buffers currently kept in the pool
+     */
+    size_t size() const;
+
+    /**
+     * Memory currently kept in the pool in bytes
+     */
+    size_t capacityBytes() const;
+
+protected:
+    /**
+     * Pushes buffer into the pool, the caller has to hold the mutex
+     */
+    void push(std::vector<uint8_t>& buffer);
+
+    mutable boost::mutex mutex_;
+
+    size_t max_buffers_;
+
+    /**
+     * The pooled buffers, reserved to max_buffers_ so that pushing does not
+     * allocate
+     */
+    std::vector<std::vector<uint8_t> > buffers_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_FRAME_BUFFER_POOL_H
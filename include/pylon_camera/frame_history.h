@@ -0,0 +1,158 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_FRAME_HISTORY_H
+#define PYLON_CAMERA_FRAME_HISTORY_H
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <cstddef>
+#include <vector>
+#include <ros/ros.h>
+#include <sensor_msgs/Image.h>
+
+namespace pylon_camera
+{
+
+/**
+ * Ring buffer of the most recent frames, such that the frames preceding an
+ * external event can be retrieved afterwards. The history is limited by a
+ * number of frames, an age and a memory budget, whichever is reached first.
+ * The slots are allocated once, pushing a frame of the same size only copies
+ * the pixels. A slot which a query still copies from is replaced by a new
+ * one instead, hence queries copy the frames without blocking push().
+ */
+class FrameHistory
+{
+public:
+    /**
+     * @param max_frames the number of frames to keep at most
+     * @param max_age frames older than the newest frame minus max_age are
+     *        dropped, 0 for no limit
+     * @param max_bytes the memory the pixel buffers may use at most
+     */
+    FrameHistory(const size_t& max_frames,
+                 const double& max_age,
+                 const size_t& max_bytes);
+
+    virtual ~FrameHistory();
+
+    /**
+     * Copies the frame into the slot of the oldest frame and wakes up the
+     * threads in waitFor(). If the size of the frames changes, the history
+     * is restarted.
+     * @param image the frame, its stamp has to be newer than the previous one
+     */
+    void push(const sensor_msgs::Image& image);
+
+    /**
+     * Blocks until a frame with a stamp of at least stamp has been pushed
+     * @param stamp the stamp to wait for
+     * @param timeout the time to wait at most in seconds (wall time)
+     * @return false if the timeout expired before
+     */
+    bool waitFor(const ros::Time& stamp, const double& timeout) const;
+
+    /**
+     * Copies all frames with a stamp in [start, end] in temporal order. Only
+     * the references to the slots are taken under the lock, the pixels are
+     * copied after releasing it.
+     * @param start begin of the time window
+     * @param end end of the time window
+     * @param images the frames found, appended
+     * @return the number of frames found
+     */
+    size_t query(const ros::Time& start,
+                 const ros::Time& end,
+                 std::vector<sensor_msgs::Image>& images) const;
+
+    /**
+     * Number of frames currently in the history
+     */
+    size_t size() const;
+
+    /**
+     * Number of frames the history can hold with the current frame size
+     */
+    size_t capacity() const;
+
+    /**
+     * Memory allocated by the pixel buffers of the history in bytes
+     */
+    size_t memoryBytes() const;
+
+    /**
+     * Stamps of the oldest and the newest frame, zero if empty
+     */
+    ros::Time oldestStamp() const;
+    ros::Time newestStamp() const;
+
+protected:
+    /**
+     * Index of the i-th oldest frame in slots_, the caller has to hold the
+     * mutex
+     */
+    size_t slotIndex(const size_t& i) const;
+
+    /**
+     * Drops the frames which are older than max_age_, the caller has to hold
+     * the mutex
+     */
+    void dropExpired();
+
+    mutable boost::mutex mutex_;
+
+    /**
+     * Signalled by push()
+     */
+    mutable boost::condition_variable pushed_;
+
+    size_t max_frames_;
+    double max_age_;
+    size_t max_bytes_;
+
+    /**
+     * The ring of frames, next_ is the slot the next frame is written to and
+     * count_ the number of valid frames before it. Shared with the running
+     * queries, push() only writes into slots it holds alone.
+     */
+    std::vector<sensor_msgs::ImagePtr> slots_;
+    size_t next_;
+    size_t count_;
+
+    /**
+     * Size of the frames in the history, a different size restarts it
+     */
+    size_t frame_bytes_;
+    size_t memory_bytes_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_FRAME_HISTORY_H
@@ -0,0 +1,129 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_GIGE_BANDWIDTH_PLANNER_H
+#define PYLON_CAMERA_GIGE_BANDWIDTH_PLANNER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pylon_camera
+{
+
+/**
+ * Plans the packet timing of GigE cameras which share one network link, see
+ * Basler AW000649 'Controlling Packet Timing with Delays'. All functions are
+ * pure, hence the plan can be verified without a camera.
+ */
+namespace gige_bandwidth
+{
+    /**
+     * Bytes of the IP, UDP and GVSP headers inside each stream packet
+     */
+    const std::size_t PACKET_HEADER_BYTES = 36;
+
+    /**
+     * Bytes each Ethernet frame additionally occupies on the wire: MAC
+     * header, FCS, preamble and inter-frame gap
+     */
+    const std::size_t ETHERNET_OVERHEAD_BYTES = 38;
+
+    /**
+     * Bytes of the GVSP leader and trailer packet of each frame, including
+     * their headers
+     */
+    const std::size_t LEADER_TRAILER_BYTES = 132;
+
+    struct Request
+    {
+        Request();
+
+        /** Image width in pixels, after binning. */
+        std::size_t width;
+        /** Image height in pixels, after binning. */
+        std::size_t height;
+        /** Bytes per pixel of the pixel format. */
+        double bytes_per_pixel;
+        /** Desired frame rate of each camera, <= 0 for as fast as possible. */
+        double target_fps;
+        /** Number of cameras streaming over the link. */
+        std::size_t num_cameras;
+        /** Index of this camera in [0, num_cameras). */
+        std::size_t camera_index;
+        /** Speed of the shared link in bit/s. */
+        double link_speed_bps;
+        /** Fraction of the link the cameras may use in total, in (0, 1]. */
+        double headroom;
+        /** The MTU of the network card, upper bound of the packet size. */
+        std::size_t mtu;
+        /** Max and increment of GevSCPSPacketSize of the camera. */
+        std::size_t max_packet_size;
+        std::size_t packet_size_increment;
+        /** Frequency of the camera ticks GevSCPD and GevSCFTD are given in. */
+        double tick_frequency_hz;
+    };
+
+    struct Plan
+    {
+        Plan();
+
+        /** GevSCPSPacketSize in bytes, including IP, UDP and GVSP header. */
+        std::size_t packet_size;
+        /** GevSCPD: delay between two packets of this camera in ticks. */
+        int64_t inter_packet_delay;
+        /** GevSCFTD: delay before the first packet of a frame in ticks. */
+        int64_t frame_transmission_delay;
+        /** Number of packets of one frame, including leader and trailer. */
+        std::size_t packets_per_frame;
+        /** Bytes of one frame on the wire. */
+        double wire_bytes_per_frame;
+        /** Share of the link bandwidth of each camera in bit/s. */
+        double bandwidth_share_bps;
+        /** Max frame rate each camera can send within its share. */
+        double max_fps;
+        /** Frame rate to run with: the target_fps limited by max_fps. */
+        double planned_fps;
+    };
+
+    /**
+     * Computes the largest packet size which fits into the MTU, the
+     * inter-packet delay which limits each camera to its share of the link
+     * and a frame transmission delay which staggers the cameras by one packet
+     * time each.
+     * @param request description of the image stream and the link.
+     * @param plan the resulting packet timing.
+     * @return false if the request is invalid, e.g. has no cameras, a zero
+     *         sized image or a link speed of 0.
+     */
+    bool plan(const Request& request, Plan& plan);
+
+}  // namespace gige_bandwidth
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_GIGE_BANDWIDTH_PLANNER_H
@@ -0,0 +1,253 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_IMAGE_KERNELS_H
+#define PYLON_CAMERA_IMAGE_KERNELS_H
+
+#include <opencv2/core/core.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace pylon_camera
+{
+
+/**
+ * The per-pixel kernels of the brightness search. They are kept apart from
+ * the PylonCameraNode, so they can be benchmarked and replaced in isolation.
+ */
+namespace image_kernels
+{
+    /**
+     * Generates the subset of points on which the brightness search will be
+     * executed in order to speed it up. The subset are the sorted indices of
+     * the one-dimensional image data vector. The base generation is done in a
+     * recursive manner, by calling genSamplingIndicesRec
+     * @param indices the generated indices
+     * @param rows the number of image rows
+     * @param cols the number of image columns
+     * @param downsampling_factor the image height divided by this factor is
+     *        the min window height of the recursion
+     */
+    void setupSamplingIndices(std::vector<std::size_t>& indices,
+                              const std::size_t& rows,
+                              const std::size_t& cols,
+                              const int& downsampling_factor);
+
+    /**
+     * This funcion will recursivly be called from above setupSamplingIndices()
+     * to generate the indices of pixels given the actual window.
+     * @param indices the generated indices
+     * @param min_window_height abort criteria of the recursion
+     * @param cols the number of image columns
+     * @param start upper left corner of the window
+     * @param end lower right corner of the window
+     */
+    void genSamplingIndicesRec(std::vector<std::size_t>& indices,
+                               const std::size_t& min_window_height,
+                               const std::size_t& cols,
+                               const cv::Point2i& start,
+                               const cv::Point2i& end);
+
+    /**
+     * Generates the weighted subset of bytes on which the brightness search
+     * is executed if metering regions are given. Each region is sampled with
+     * the pattern of setupSamplingIndices() on its own, but as dense as the
+     * whole image, hence the number of samples of a region grows with its
+     * area and the weights act per pixel. A pixel covered by several regions
+     * gets the largest of their weights, only pixels outside all regions are
+     * sampled with the background weight. Pixels with zero weight are left
+     * out.
+     * @param indices the generated byte indices, sorted
+     * @param weights the weight of each index
+     * @param rows the number of image rows
+     * @param cols the number of image columns
+     * @param bytes_per_pixel all bytes of a sampled pixel are indexed
+     * @param downsampling_factor see setupSamplingIndices()
+     * @param regions the metering regions in image pixels
+     * @param region_weights the weight of each region
+     * @param background_weight the weight of the pixels outside the regions
+     */
+    void setupWeightedSamplingIndices(std::vector<std::size_t>& indices,
+                                      std::vector<float>& weights,
+                                      const std::size_t& rows,
+                                      const std::size_t& cols,
+                                      const std::size_t& bytes_per_pixel,
+                                      const int& downsampling_factor,
+                                      const std::vector<cv::Rect>& regions,
+                                      const std::vector<float>& region_weights,
+                                      const float& background_weight);
+
+    /**
+     * Calculates the mean of the given subset of the image data
+     * @param data the image data
+     * @param indices the sorted indices of the subset
+     * @return the mean value or 0 if the subset is empty or exceeds the data,
+     *         e.g. if it was generated for a larger image
+     */
+    float sampledMean(const std::vector<uint8_t>& data,
+                      const std::vector<std::size_t>& indices);
+
+    /**
+     * Calculates the mean of all bytes of the image data, i.e. over all
+     * pixels and channels
+     * @param data the image data
+     * @return the mean value or 0 if the data is empty
+     */
+    float mean(const std::vector<uint8_t>& data);
+
+    /**
+     * Calculates the weighted mean of the given subset of the image data
+     * @param data the image data
+     * @param indices the sorted indices of the subset
+     * @param weights the weight of each index
+     * @return the mean value or 0 if the subset is empty or exceeds the data
+     */
+    float weightedSampledMean(const std::vector<uint8_t>& data,
+                              const std::vector<std::size_t>& indices,
+                              const std::vector<float>& weights);
+
+    /**
+     * The length of an image dimension after decimate()
+     * @param length the number of pixels before the decimation
+     * @param cell_size see decimate()
+     * @param decimation the decimation factor, >= 1
+     * @return the number of pixels after the decimation
+     */
+    std::size_t decimatedLength(const std::size_t& length,
+                                const std::size_t& cell_size,
+                                const std::size_t& decimation);
+
+    /**
+     * Keeps every decimation_x-th cell of every decimation_y-th row of
+     * cells, the software fallback for cameras without decimation. A cell
+     * has cell_size x cell_size pixels and is kept whole, which keeps the
+     * color pattern of Bayer images (cell_size 2) intact. The output has
+     * decimatedLength(rows, cell_size, decimation_y) x
+     * decimatedLength(cols, cell_size, decimation_x) pixels. Uses SSE2 for
+     * 8 and 16 bit mono images and 8 bit Bayer images if available.
+     * @param src the image, rows x cols pixels without padding
+     * @param rows the number of image rows
+     * @param cols the number of image columns
+     * @param bytes_per_pixel the number of bytes of each pixel
+     * @param cell_size the edge length of the cells in pixels, >= 1
+     * @param decimation_x the horizontal decimation factor, >= 1
+     * @param decimation_y the vertical decimation factor, >= 1
+     * @param dst the decimated image, must not overlap with src
+     */
+    void decimate(const uint8_t* src,
+                  const std::size_t& rows,
+                  const std::size_t& cols,
+                  const std::size_t& bytes_per_pixel,
+                  const std::size_t& cell_size,
+                  const std::size_t& decimation_x,
+                  const std::size_t& decimation_y,
+                  uint8_t* dst);
+
+    /**
+     * Calculates the variance of the Laplacian of the image as measure of
+     * its sharpness, on every row_step-th row of the region. The Laplacian
+     * of a byte is taken from the neighbours dx bytes left and right and dy
+     * rows above and below, such that it stays within one channel (dx = 3
+     * for rgb8) or one color of the Bayer pattern (dx = dy = 2). Uses SSE2
+     * if available.
+     * @param data the image, 8 bit per channel
+     * @param rows the number of image rows
+     * @param row_bytes the number of bytes of each row
+     * @param roi the region, x and width in bytes, y and height in rows.
+     *        It is shrinked to the bytes with all neighbours in the image.
+     * @param dx the horizontal distance of the neighbours in bytes, >= 1
+     * @param dy the vertical distance of the neighbours in rows, >= 1
+     * @param row_step only every row_step-th row is sampled, >= 1
+     * @return the variance or 0 if the region is empty
+     */
+    double laplacianVariance(const uint8_t* data,
+                             const std::size_t& rows,
+                             const std::size_t& row_bytes,
+                             const cv::Rect& roi,
+                             const std::size_t& dx,
+                             const std::size_t& dy,
+                             const std::size_t& row_step);
+
+    /**
+     * Copies every row_step-th row of the image into a compact buffer, the
+     * reference of sampledRowsMeanAbsDiff()
+     * @param data the image
+     * @param rows the number of image rows
+     * @param row_bytes the number of bytes of each row
+     * @param row_step only every row_step-th row is copied, >= 1
+     * @param reference the copied rows, resized as needed
+     */
+    void copySampledRows(const uint8_t* data,
+                         const std::size_t& rows,
+                         const std::size_t& row_bytes,
+                         const std::size_t& row_step,
+                         std::vector<uint8_t>& reference);
+
+    /**
+     * Calculates the mean absolute difference of the bytes of every
+     * row_step-th row of the image and of the reference. Uses SSE2 if
+     * available.
+     * @param data the image
+     * @param rows the number of image rows
+     * @param row_bytes the number of bytes of each row
+     * @param row_step only every row_step-th row is compared, >= 1
+     * @param reference the rows of an earlier image of the same size, as
+     *        copied by copySampledRows()
+     * @return the mean absolute difference or 0 if no row is sampled
+     */
+    float sampledRowsMeanAbsDiff(const uint8_t* data,
+                                 const std::size_t& rows,
+                                 const std::size_t& row_bytes,
+                                 const std::size_t& row_step,
+                                 const std::vector<uint8_t>& reference);
+
+    /**
+     * Downscales the image by averaging blocks of factor x factor pixels,
+     * each channel on its own. The output has (rows / factor) x
+     * (cols / factor) pixels, remaining rows and columns are dropped. Uses
+     * SSE2 for the vertical sums if available.
+     * @param src the image, rows x cols pixels with 8 bit per channel
+     * @param rows the number of image rows
+     * @param cols the number of image columns
+     * @param channels the number of channels of each pixel
+     * @param factor the downscale factor, >= 1
+     * @param column_sums buffer for the vertical sums, resized as needed
+     * @param dst the downscaled image, must not overlap with src
+     */
+    void boxDownscale(const uint8_t* src,
+                      const std::size_t& rows,
+                      const std::size_t& cols,
+                      const std::size_t& channels,
+                      const std::size_t& factor,
+                      std::vector<uint32_t>& column_sums,
+                      uint8_t* dst);
+
+}  // namespace image_kernels
+}  // namespace pylon_camera
+#endif  // PYLON_CAMERA_IMAGE_KERNELS_H
@@ -0,0 +1,189 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_IMAGE_VIEW_H
+#define PYLON_CAMERA_IMAGE_VIEW_H
+
+#include <cstring>
+#include <string>
+#include <ros/ros.h>
+#include <sensor_msgs/Image.h>
+#include <std_msgs/Header.h>
+
+namespace pylon_camera
+{
+
+/**
+ * A rectangular window into an image buffer which is published as
+ * sensor_msgs/Image. The pixels are not copied into a message of their own,
+ * the serialization writes them directly from the buffer into the outgoing
+ * message buffer of roscpp: a view spanning whole rows is one contiguous
+ * block, otherwise each row is written on its own.
+ * The buffer is only referenced, hence the view has to be published with
+ * ros::Publisher::publish(const ImageView&), which serializes right away.
+ */
+struct ImageView
+{
+    ImageView();
+
+    std_msgs::Header header;
+    uint32_t height;
+    uint32_t width;
+    std::string encoding;
+    uint8_t is_bigendian;
+
+    /**
+     * Row length of the view in bytes
+     */
+    uint32_t step;
+
+    /**
+     * First byte of the view inside the buffer
+     */
+    const uint8_t* data;
+
+    /**
+     * Row length of the buffer in bytes
+     */
+    uint32_t data_step;
+};
+
+inline ImageView::ImageView()
+    : header(),
+      height(0),
+      width(0),
+      encoding(),
+      is_bigendian(0),
+      step(0),
+      data(nullptr),
+      data_step(0)
+{}
+
+}  // namespace pylon_camera
+
+namespace ros
+{
+namespace message_traits
+{
+
+// on the wire, an ImageView is a sensor_msgs/Image
+template<> struct IsMessage<pylon_camera::ImageView> : TrueType {};
+template<> struct HasHeader<pylon_camera::ImageView> : TrueType {};
+
+template<>
+struct MD5Sum<pylon_camera::ImageView>
+{
+    static const char* value()
+    {
+        return MD5Sum<sensor_msgs::Image>::value();
+    }
+    static const char* value(const pylon_camera::ImageView&)
+    {
+        return value();
+    }
+};
+
+template<>
+struct DataType<pylon_camera::ImageView>
+{
+    static const char* value()
+    {
+        return DataType<sensor_msgs::Image>::value();
+    }
+    static const char* value(const pylon_camera::ImageView&)
+    {
+        return value();
+    }
+};
+
+template<>
+struct Definition<pylon_camera::ImageView>
+{
+    static const char* value()
+    {
+        return Definition<sensor_msgs::Image>::value();
+    }
+    static const char* value(const pylon_camera::ImageView&)
+    {
+        return value();
+    }
+};
+
+}  // namespace message_traits
+
+namespace serialization
+{
+
+template<>
+struct Serializer<pylon_camera::ImageView>
+{
+    template<typename Stream>
+    inline static void write(Stream& stream, const pylon_camera::ImageView& view)
+    {
+        stream.next(view.header);
+        stream.next(view.height);
+        stream.next(view.width);
+        stream.next(view.encoding);
+        stream.next(view.is_bigendian);
+        stream.next(view.step);
+        const uint32_t size = view.step * view.height;
+        stream.next(size);
+        if ( size == 0 )
+        {
+            return;
+        }
+        uint8_t* dst = stream.advance(size);
+        if ( view.data_step == view.step )
+        {
+            // whole rows, a single block
+            std::memcpy(dst, view.data, size);
+            return;
+        }
+        const uint8_t* src = view.data;
+        for ( uint32_t row = 0; row < view.height; ++row )
+        {
+            std::memcpy(dst, src, view.step);
+            dst += view.step;
+            src += view.data_step;
+        }
+    }
+
+    inline static uint32_t serializedLength(const pylon_camera::ImageView& view)
+    {
+        return serializationLength(view.header) +
+               serializationLength(view.encoding) +
+               4 + 4 + 1 + 4 +             // height, width, is_bigendian, step
+               4 + view.step * view.height;  // data
+    }
+};
+
+}  // namespace serialization
+}  // namespace ros
+
+#endif  // PYLON_CAMERA_IMAGE_VIEW_H
@@ -30,13 +30,15 @@
 #ifndef PYLON_CAMERA_INTERNAL_BASE_HPP_
 #define PYLON_CAMERA_INTERNAL_BASE_HPP_
 
+#include <algorithm>
 #include <cmath>
 #include <string>
 #include <vector>
 
 #include <pylon_camera/internal/pylon_camera.h>
 #include <pylon_camera/encoding_conversions.h>
-#include <sensor_msgs/image_encodings.h>
+#include <pylon_camera/image_kernels.h>
+#include <pylon_camera/logging.h>
 
 namespace pylon_camera
 {
@@ -44,7 +46,10 @@ namespace pylon_camera
 template <typename CameraTraitT>
 PylonCameraImpl<CameraTraitT>::PylonCameraImpl(Pylon::IPylonDevice* device) :
     PylonCamera(),
-    cam_(new CBaslerInstantCameraT(device))
+    cam_(new CBaslerInstantCameraT(device)),
+    bandwidth_request_(),
+    plan_bandwidth_(false),
+    given_inter_pkg_delay_(-1)
 {}
 
 template <typename CameraTraitT>
@@ -72,7 +77,7 @@ bool PylonCameraImpl<CameraTraitT>::registerCameraConfiguration()
     }
     catch ( const GenICam::GenericException &e )
     {
-        ROS_ERROR_STREAM(e.GetDescription());
+        PYLON_CAMERA_ERROR_STREAM(e.GetDescription());
         return false;
     }
 }
@@ -87,11 +92,142 @@ bool PylonCameraImpl<CameraTraitT>::openCamera()
     }
     catch ( const GenICam::GenericException &e )
     {
-        ROS_ERROR_STREAM(e.GetDescription());
+        PYLON_CAMERA_ERROR_STREAM(e.GetDescription());
         return false;
     }
 }
 
+template <typename CameraTraitT>
+bool PylonCameraImpl<CameraTraitT>::loadFeatures(const PylonCameraSettings& parameters)
+{
+    try
+    {
+        GenApi::INodeMap& node_map = cam_->GetNodeMap();
+        if ( parameters.feature_persistence_ == FP_USER_SET )
+        {
+            GenApi::CEnumerationPtr selector(node_map.GetNode("UserSetSelector"));
+            GenApi::CCommandPtr load(node_map.GetNode("UserSetLoad"));
+            if ( !GenApi::IsWritable(selector) || !GenApi::IsWritable(load) )
+            {
+                PYLON_CAMERA_WARN_STREAM("Camera does not support user sets, can't warm start");
+                return false;
+            }
+            selector->FromString(parameters.feature_persistence_user_set_.c_str());
+            load->Execute();
+        }
+        else if ( parameters.feature_persistence_ == FP_FILE )
+        {
+            Pylon::CFeaturePersistence::Load(
+                        parameters.feature_persistence_file_.c_str(),
+                        &node_map,
+                        true);
+        }
+        else
+        {
+            return false;
+        }
+        // the software decimation is done on the host, hence not part of
+        // the feature set. The decimation of the camera is restored already.
+        if ( parameters.decimation_x_given_ &&
+             !GenApi::IsWritable(cam_->DecimationHorizontal) )
+        {
+            sw_decimation_x_ = std::max<size_t>(parameters.decimation_x_, 1);
+        }
+        if ( parameters.decimation_y_given_ &&
+             !GenApi::IsWritable(cam_->DecimationVertical) )
+        {
+            sw_decimation_y_ = std::max<size_t>(parameters.decimation_y_, 1);
+        }
+        if ( !restoreHostState(parameters) )
+        {
+            return false;
+        }
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        PYLON_CAMERA_WARN_STREAM("Could not load the feature set ("
+                << parameters.featurePersistenceString() << "): "
+                << e.GetDescription());
+        return false;
+    }
+    is_warm_started_ = true;
+    return true;
+}
+
+template <typename CameraTraitT>
+bool PylonCameraImpl<CameraTraitT>::saveFeatures(const PylonCameraSettings& parameters)
+{
+    try
+    {
+        GenApi::INodeMap& node_map = cam_->GetNodeMap();
+        if ( parameters.feature_persistence_ == FP_USER_SET )
+        {
+            GenApi::CEnumerationPtr selector(node_map.GetNode("UserSetSelector"));
+            GenApi::CCommandPtr save(node_map.GetNode("UserSetSave"));
+            if ( !GenApi::IsAvailable(selector) || !GenApi::IsAvailable(save) )
+            {
+                PYLON_CAMERA_WARN_STREAM("Camera does not support user sets, can't save the "
+                         "feature set");
+                return false;
+            }
+            // user sets can only be saved while not grabbing
+            const bool was_grabbing = cam_->IsGrabbing();
+            if ( was_grabbing )
+            {
+                cam_->StopGrabbing();
+            }
+            selector->FromString(parameters.feature_persistence_user_set_.c_str());
+            save->Execute();
+            if ( was_grabbing )
+            {
+                cam_->StartGrabbing();
+                resetFrameTracking();
+            }
+        }
+        else if ( parameters.feature_persistence_ == FP_FILE )
+        {
+            Pylon::CFeaturePersistence::Save(
+                        parameters.feature_persistence_file_.c_str(),
+                        &node_map);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        PYLON_CAMERA_WARN_STREAM("Could not save the feature set ("
+                << parameters.featurePersistenceString() << "): "
+                << e.GetDescription());
+        return false;
+    }
+    return true;
+}
+
+template <typename CameraTraitT>
+std::string PylonCameraImpl<CameraTraitT>::deviceIdentity()
+{
+    const Pylon::CDeviceInfo& info = cam_->GetDeviceInfo();
+    std::string identity = std::string(info.GetModelName().c_str()) + " " +
+                           std::string(info.GetSerialNumber().c_str());
+    try
+    {
+        GenApi::CStringPtr firmware(
+                        cam_->GetNodeMap().GetNode("DeviceFirmwareVersion"));
+        if ( GenApi::IsReadable(firmware) )
+        {
+            identity += " " + std::string(firmware->GetValue().c_str());
+        }
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        PYLON_CAMERA_WARN_STREAM("Could not read the firmware version: "
+                << e.GetDescription());
+    }
+    return identity;
+}
+
 template <typename CameraTraitT>
 size_t PylonCameraImpl<CameraTraitT>::currentBinningX()
 {
@@ -213,7 +349,7 @@ void PylonCameraImpl<CameraTraitT>::enableContinuousAutoExposure()
     }
     else
     {
-        ROS_ERROR_STREAM("Trying to enable ExposureAuto_Continuous mode, but "
+        PYLON_CAMERA_ERROR_STREAM("Trying to enable ExposureAuto_Continuous mode, but "
             << "the camera has no Auto Exposure");
     }
 }
@@ -227,7 +363,7 @@ void PylonCameraImpl<CameraTraitT>::enableContinuousAutoGain()
     }
     else
     {
-        ROS_ERROR_STREAM("Trying to enable GainAuto_Continuous mode, but "
+        PYLON_CAMERA_ERROR_STREAM("Trying to enable GainAuto_Continuous mode, but "
             << "the camera has no Auto Gain");
     }
 }
@@ -262,7 +398,7 @@ bool PylonCameraImpl<CameraTraitT>::setupSequencer(const std::vector<float>& exp
                 ss << ", ";
             }
         }
-        ROS_INFO_STREAM(ss.str());
+        PYLON_CAMERA_INFO_STREAM(ss.str());
         return true;
     }
     else
@@ -272,27 +408,51 @@ bool PylonCameraImpl<CameraTraitT>::setupSequencer(const std::vector<float>& exp
 }
 
 template <typename CameraTraitT>
-bool PylonCameraImpl<CameraTraitT>::startGrabbing(const PylonCameraParameter& parameters)
+void PylonCameraImpl<CameraTraitT>::setGrabEngineThreadPriority(const int& priority)
+{
+    // has to be set before StartGrabbing() creates the thread
+    if ( !GenApi::IsWritable(cam_->InternalGrabEngineThreadPriorityOverride) ||
+         !GenApi::IsWritable(cam_->InternalGrabEngineThreadPriority) )
+    {
+        PYLON_CAMERA_WARN_STREAM("The priority of the grab engine thread can't be set, "
+                << "will keep the default of pylon");
+        return;
+    }
+    int64_t reached = std::max<int64_t>(priority,
+                                        cam_->InternalGrabEngineThreadPriority.GetMin());
+    reached = std::min<int64_t>(reached, cam_->InternalGrabEngineThreadPriority.GetMax());
+    cam_->InternalGrabEngineThreadPriorityOverride.SetValue(true);
+    cam_->InternalGrabEngineThreadPriority.SetValue(reached);
+    PYLON_CAMERA_INFO_STREAM("Grab engine thread priority set to " << reached);
+}
+
+template <typename CameraTraitT>
+bool PylonCameraImpl<CameraTraitT>::startGrabbing(const PylonCameraSettings& parameters)
 {
     try
     {
-        if ( GenApi::IsAvailable(cam_->ShutterMode) )
+        // a restored feature set already contains shutter mode and encoding
+        if ( !is_warm_started_ && GenApi::IsAvailable(cam_->ShutterMode) )
         {
             setShutterMode(parameters.shutter_mode_);
         }
 
         available_image_encodings_ = detectAvailableImageEncodings();
-        if ( !setImageEncoding(parameters.imageEncoding()) )
+        if ( !is_warm_started_ && !setImageEncoding(parameters.imageEncoding()) )
         {
             return false;
         }
 
+        if ( parameters.grab_engine_thread_priority_ > 0 )
+        {
+            setGrabEngineThreadPriority(parameters.grab_engine_thread_priority_);
+        }
+
         cam_->StartGrabbing();
+        resetFrameTracking();
         user_output_selector_enums_ = detectAndCountNumUserOutputs();
         device_user_id_ = cam_->DeviceUserID.GetValue();
-        img_rows_ = static_cast<size_t>(cam_->Height.GetValue());
-        img_cols_ = static_cast<size_t>(cam_->Width.GetValue());
-        img_size_byte_ =  img_cols_ * img_rows_ * imagePixelDepth();
+        updateImageSize();
 
         grab_timeout_ = exposureTime().GetMax() * 1.05;
 
@@ -305,12 +465,57 @@ bool PylonCameraImpl<CameraTraitT>::startGrabbing(const PylonCameraParameter& pa
         }
         else
         {
-            ROS_ERROR("PylonCamera not ready because the result of the initial grab is invalid");
+            PYLON_CAMERA_ERROR_STREAM("PylonCamera not ready because the result of the initial grab is invalid");
+        }
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        PYLON_CAMERA_ERROR_STREAM("startGrabbing: " << e.GetDescription());
+        return false;
+    }
+    return true;
+}
+
+template <typename CameraTraitT>
+bool PylonCameraImpl<CameraTraitT>::pauseGrabbing()
+{
+    try
+    {
+        if ( cam_->IsGrabbing() )
+        {
+            cam_->StopGrabbing();
+            is_grabbing_paused_ = true;
         }
     }
     catch ( const GenICam::GenericException &e )
     {
-        ROS_ERROR_STREAM("startGrabbing: " << e.GetDescription());
+        PYLON_CAMERA_ERROR_STREAM("An exception while stopping the grabbing occurred: "
+                << e.GetDescription());
+        return false;
+    }
+    return true;
+}
+
+template <typename CameraTraitT>
+bool PylonCameraImpl<CameraTraitT>::resumeGrabbing()
+{
+    if ( !is_grabbing_paused_ )
+    {
+        return true;
+    }
+    is_grabbing_paused_ = false;
+    try
+    {
+        if ( !cam_->IsGrabbing() )
+        {
+            cam_->StartGrabbing();
+            resetFrameTracking();
+        }
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        PYLON_CAMERA_ERROR_STREAM("An exception while restarting the grabbing occurred: "
+                << e.GetDescription());
         return false;
     }
     return true;
@@ -322,12 +527,19 @@ bool PylonCameraImpl<CameraTrait>::grab(std::vector<uint8_t>& image)
     Pylon::CGrabResultPtr ptr_grab_result;
     if ( !grab(ptr_grab_result) )
     {
-        ROS_ERROR("Error: Grab was not successful");
+        PYLON_CAMERA_ERROR_STREAM_AGGREGATED(1.0, "Error: Grab was not successful");
         return false;
     }
 
+    uint64_t copy_start = latency_stats_ ? LatencyStats::now() : 0;
     const uint8_t *pImageBuffer = reinterpret_cast<uint8_t*>(ptr_grab_result->GetBuffer());
-    image.assign(pImageBuffer, pImageBuffer + img_size_byte_);
+    image.resize(img_size_byte_);
+    copyImage(pImageBuffer, image.data());
+    PYLON_CAMERA_TRACE1(copy_done, img_size_byte_);
+    if ( latency_stats_ )
+    {
+        latency_stats_->record(LS_COPY, copy_start);
+    }
 
     if ( !is_ready_ )
         is_ready_ = true;
@@ -341,12 +553,39 @@ bool PylonCameraImpl<CameraTrait>::grab(uint8_t* image)
     Pylon::CGrabResultPtr ptr_grab_result;
     if ( !grab(ptr_grab_result) )
     {
-        ROS_ERROR("Error: Grab was not successful");
+        PYLON_CAMERA_ERROR_STREAM_AGGREGATED(1.0, "Error: Grab was not successful");
         return false;
     }
 
-    memcpy(image, ptr_grab_result->GetBuffer(), img_size_byte_);
+    uint64_t copy_start = latency_stats_ ? LatencyStats::now() : 0;
+    copyImage(reinterpret_cast<uint8_t*>(ptr_grab_result->GetBuffer()), image);
+    PYLON_CAMERA_TRACE1(copy_done, img_size_byte_);
+    if ( latency_stats_ )
+    {
+        latency_stats_->record(LS_COPY, copy_start);
+    }
+
+    return true;
+}
+
+template <typename CameraTrait>
+bool PylonCameraImpl<CameraTrait>::executeSoftwareTrigger()
+{
+    int timeout = 5000;  // ms
 
+    // WaitForFrameTriggerReady to prevent trigger signal to get lost
+    // this could happen, if 2xExecuteSoftwareTrigger() is only followed by 1xgrabResult()
+    // -> 2nd trigger might get lost
+    if ( cam_->WaitForFrameTriggerReady(timeout, Pylon::TimeoutHandling_ThrowException) )
+    {
+        cam_->ExecuteSoftwareTrigger();
+    }
+    else
+    {
+        PYLON_CAMERA_ERROR_STREAM_AGGREGATED(1.0, "Error WaitForFrameTriggerReady() timed out, "
+                << "impossible to ExecuteSoftwareTrigger()");
+        return false;
+    }
     return true;
 }
 
@@ -355,45 +594,79 @@ bool PylonCameraImpl<CameraTrait>::grab(Pylon::CGrabResultPtr& grab_result)
 {
     try
     {
-        int timeout = 5000;  // ms
-
-        // WaitForFrameTriggerReady to prevent trigger signal to get lost
-        // this could happen, if 2xExecuteSoftwareTrigger() is only followed by 1xgrabResult()
-        // -> 2nd trigger might get lost
-        if ( cam_->WaitForFrameTriggerReady(timeout, Pylon::TimeoutHandling_ThrowException) )
+        PYLON_CAMERA_TRACE(grab_start);
+        uint64_t stage_start = latency_stats_ ? LatencyStats::now() : 0;
+        if ( !executeSoftwareTrigger() )
         {
-            cam_->ExecuteSoftwareTrigger();
+            grab_failures_.fetch_add(1, std::memory_order_relaxed);
+            PYLON_CAMERA_TRACE(grab_failed);
+            return false;
         }
-        else
+        PYLON_CAMERA_TRACE(trigger_done);
+        if ( latency_stats_ )
         {
-            ROS_ERROR("Error WaitForFrameTriggerReady() timed out, impossible to ExecuteSoftwareTrigger()");
-            return false;
+            stage_start = latency_stats_->record(LS_TRIGGER_WAIT, stage_start);
         }
         cam_->RetrieveResult(grab_timeout_, grab_result, Pylon::TimeoutHandling_ThrowException);
+        PYLON_CAMERA_TRACE(retrieve_done);
+        if ( latency_stats_ )
+        {
+            latency_stats_->record(LS_RETRIEVE, stage_start);
+        }
+    }
+    catch ( const Pylon::TimeoutException &e )
+    {
+        grab_failures_.fetch_add(1, std::memory_order_relaxed);
+        PYLON_CAMERA_TRACE(grab_failed);
+        // a GigE camera which disappears only shows up as timeouts
+        if ( cam_->IsCameraDeviceRemoved() )
+        {
+            is_cam_removed_ = true;
+            PYLON_CAMERA_ERROR_STREAM("Camera was removed, trying to re-open . . .");
+            return false;
+        }
+        grab_timeouts_.fetch_add(1, std::memory_order_relaxed);
+        PYLON_CAMERA_ERROR_STREAM_AGGREGATED(1.0, "A timeout occurred while grabbing an image: "
+                << e.GetDescription());
+        return false;
     }
     catch ( const GenICam::GenericException &e )
     {
+        grab_failures_.fetch_add(1, std::memory_order_relaxed);
+        PYLON_CAMERA_TRACE(grab_failed);
         if ( cam_->IsCameraDeviceRemoved() )
         {
             is_cam_removed_ = true;
-            ROS_ERROR("Camera was removed, trying to re-open . . .");
+            PYLON_CAMERA_ERROR_STREAM("Camera was removed, trying to re-open . . .");
         }
         else
         {
-            ROS_ERROR_STREAM("An image grabbing exception in pylon camera occurred: "
-                    << e.GetDescription());
+            PYLON_CAMERA_ERROR_STREAM_AGGREGATED(1.0, "An image grabbing exception in pylon camera "
+                    << "occurred: " << e.GetDescription());
         }
         return false;
     }
     catch (...)
     {
-        ROS_ERROR("An unspecified image grabbing exception in pylon camera occurred");
+        grab_failures_.fetch_add(1, std::memory_order_relaxed);
+        PYLON_CAMERA_TRACE(grab_failed);
+        PYLON_CAMERA_ERROR_STREAM_AGGREGATED(1.0, "An unspecified image grabbing exception in "
+                << "pylon camera occurred");
         return false;
     }
 
+    // incomplete buffers still carry the block ID, hence a failed grab does
+    // not show up as lost frame of the next successful one
+    trackFrame(grab_result->GetBlockID(),
+               maxBlockID(),
+               grab_result->GetNumberOfSkippedImages());
+
     if ( !grab_result->GrabSucceeded() )
     {
-        ROS_ERROR_STREAM("Error: " << grab_result->GetErrorCode() << " "
+        grab_failures_.fetch_add(1, std::memory_order_relaxed);
+        PYLON_CAMERA_TRACE(grab_failed);
+        incomplete_buffers_.fetch_add(1, std::memory_order_relaxed);
+        PYLON_CAMERA_ERROR_STREAM_AGGREGATED(1.0, "Error: " << grab_result->GetErrorCode() << " "
                 << grab_result->GetErrorDescription());
         return false;
     }
@@ -425,7 +698,7 @@ std::vector<std::string> PylonCameraImpl<CameraTraitT>::detectAvailableImageEnco
             available_encodings.push_back(encoding_gen_api);
         }
     }
-    ROS_INFO_STREAM(ss.str().c_str());
+    PYLON_CAMERA_INFO_STREAM(ss.str().c_str());
     return available_encodings;
 }
 
@@ -438,12 +711,12 @@ bool PylonCameraImpl<CameraTraitT>::setImageEncoding(const std::string& ros_enco
     {
         if ( ros_encoding.empty() )
         {
-            ROS_WARN_STREAM("No image encoding provided. Will use 'mono8' or "
+            PYLON_CAMERA_WARN_STREAM("No image encoding provided. Will use 'mono8' or "
                 << "'rgb8' as fallback!");
         }
         else
         {
-            ROS_ERROR_STREAM("Can't convert ROS encoding '" << ros_encoding
+            PYLON_CAMERA_ERROR_STREAM("Can't convert ROS encoding '" << ros_encoding
                 << "' to a corresponding GenAPI encoding! Will use 'mono8' or "
                 << "'rgb8' as fallback!");
         }
@@ -459,7 +732,7 @@ bool PylonCameraImpl<CameraTraitT>::setImageEncoding(const std::string& ros_enco
         }
         if ( !fallback_found )
         {
-            ROS_ERROR_STREAM("Couldn't find a fallback solution!");
+            PYLON_CAMERA_ERROR_STREAM("Couldn't find a fallback solution!");
             return false;
         }
     }
@@ -475,28 +748,50 @@ bool PylonCameraImpl<CameraTraitT>::setImageEncoding(const std::string& ros_enco
     }
     if ( !supports_desired_encoding )
     {
-        ROS_WARN_STREAM("Camera does not support the desired image pixel "
+        PYLON_CAMERA_WARN_STREAM("Camera does not support the desired image pixel "
             << "encoding '" << ros_encoding << "'!");
         return false;
     }
+    // the pixel format can only be changed while not grabbing
+    const bool was_grabbing = cam_->IsGrabbing();
     try
     {
         if ( GenApi::IsAvailable(cam_->PixelFormat) )
         {
+            if ( was_grabbing )
+            {
+                cam_->StopGrabbing();
+            }
             GenApi::INodeMap& node_map = cam_->GetNodeMap();
-            GenApi::CEnumerationPtr(node_map.GetNode("PixelFormat"))->FromString(gen_api_encoding.c_str());
+            GenApi::CEnumerationPtr pixel_format(node_map.GetNode("PixelFormat"));
+            pixel_format->FromString(gen_api_encoding.c_str());
+            // the PFNC value of the pixel format, e.g. 0x01080001 for Mono8
+            PYLON_CAMERA_TRACE_PARAM("pixel_format", pixel_format->GetIntValue());
+            // the software decimation depends on the pixel format
+            updateImageSize();
+            replanBandwidth();
+            if ( was_grabbing )
+            {
+                cam_->StartGrabbing();
+                resetFrameTracking();
+            }
         }
         else
         {
-            ROS_WARN_STREAM("Camera does not support variable image pixel "
+            PYLON_CAMERA_WARN_STREAM("Camera does not support variable image pixel "
                 << "encoding!");
             return false;
         }
     }
     catch ( const GenICam::GenericException &e )
     {
-        ROS_ERROR_STREAM("An exception while setting target image encoding to '"
+        PYLON_CAMERA_ERROR_STREAM("An exception while setting target image encoding to '"
             << ros_encoding << "' occurred: " << e.GetDescription());
+        if ( was_grabbing && !cam_->IsGrabbing() )
+        {
+            cam_->StartGrabbing();
+            resetFrameTracking();
+        }
         return false;
     }
     return true;
@@ -514,7 +809,7 @@ int PylonCameraImpl<CameraTraitT>::imagePixelDepth() const
     }
     catch ( const GenICam::GenericException &e )
     {
-        ROS_ERROR_STREAM("An exception while reading image pixel size occurred: "
+        PYLON_CAMERA_ERROR_STREAM("An exception while reading image pixel size occurred: "
                 << e.GetDescription());
     }
     return pixel_depth;
@@ -523,92 +818,297 @@ int PylonCameraImpl<CameraTraitT>::imagePixelDepth() const
 template <typename CameraTraitT>
 bool PylonCameraImpl<CameraTraitT>::setBinningX(const size_t& target_binning_x,
                                                 size_t& reached_binning_x)
+{
+    ImageGeometry target = currentGeometry();
+    target.binning_x = target_binning_x;
+    ImageGeometry reached;
+    bool success = setGeometry(target, reached);
+    reached_binning_x = reached.binning_x;
+    return success;
+}
+
+template <typename CameraTraitT>
+bool PylonCameraImpl<CameraTraitT>::setBinningY(const size_t& target_binning_y,
+                                                size_t& reached_binning_y)
+{
+    ImageGeometry target = currentGeometry();
+    target.binning_y = target_binning_y;
+    ImageGeometry reached;
+    bool success = setGeometry(target, reached);
+    reached_binning_y = reached.binning_y;
+    return success;
+}
+
+template <typename CameraTraitT>
+ImageGeometry PylonCameraImpl<CameraTraitT>::currentGeometry()
+{
+    ImageGeometry geometry;
+    geometry.binning_x = currentBinningX();
+    geometry.binning_y = currentBinningY();
+    const size_t hw_decimation_x = GenApi::IsAvailable(cam_->DecimationHorizontal) ?
+            static_cast<size_t>(cam_->DecimationHorizontal.GetValue()) : 1;
+    const size_t hw_decimation_y = GenApi::IsAvailable(cam_->DecimationVertical) ?
+            static_cast<size_t>(cam_->DecimationVertical.GetValue()) : 1;
+    geometry.decimation_x = hw_decimation_x * sw_decimation_x_;
+    geometry.decimation_y = hw_decimation_y * sw_decimation_y_;
+    // the AOI of the camera is given in binned and decimated pixels
+    const size_t subsampling_x = geometry.binning_x * hw_decimation_x;
+    const size_t subsampling_y = geometry.binning_y * hw_decimation_y;
+    geometry.roi_offset_x = static_cast<size_t>(cam_->OffsetX.GetValue()) * subsampling_x;
+    geometry.roi_offset_y = static_cast<size_t>(cam_->OffsetY.GetValue()) * subsampling_y;
+    geometry.roi_width = static_cast<size_t>(cam_->Width.GetValue()) * subsampling_x;
+    geometry.roi_height = static_cast<size_t>(cam_->Height.GetValue()) * subsampling_y;
+    return geometry;
+}
+
+template <typename CameraTraitT>
+void PylonCameraImpl<CameraTraitT>::setAOI(GenApi::IInteger& offset,
+                                           GenApi::IInteger& size,
+                                           const size_t& target_offset,
+                                           const size_t& target_size)
+{
+    // with offset 0 the size can grow up to the full (binned) sensor
+    offset.SetValue(offset.GetMin());
+    const int64_t max_size = size.GetMax();
+    int64_t size_to_set = target_size == 0 ? max_size
+                        : std::min(static_cast<int64_t>(target_size), max_size);
+    size_to_set -= (size_to_set - size.GetMin()) % size.GetInc();
+    size_to_set = std::max(size_to_set, size.GetMin());
+    size.SetValue(size_to_set);
+
+    int64_t offset_to_set = std::min(static_cast<int64_t>(target_offset),
+                                     max_size - size_to_set);
+    offset_to_set -= (offset_to_set - offset.GetMin()) % offset.GetInc();
+    offset.SetValue(std::max(offset_to_set, offset.GetMin()));
+}
+
+template <typename CameraTraitT>
+bool PylonCameraImpl<CameraTraitT>::setAutoFunctionAOI(const size_t& offset_x,
+                                                       const size_t& offset_y,
+                                                       const size_t& width,
+                                                       const size_t& height)
 {
     try
     {
-        if ( GenApi::IsAvailable(cam_->BinningHorizontal) )
+        if ( !selectBrightnessAutoFunctionAOI() ||
+             !GenApi::IsWritable(cam_->AutoFunctionAOIWidth) ||
+             !GenApi::IsWritable(cam_->AutoFunctionAOIHeight) )
         {
-            cam_->StopGrabbing();
-            size_t binning_x_to_set = target_binning_x;
-            if ( binning_x_to_set < cam_->BinningHorizontal.GetMin() )
-            {
-                ROS_WARN_STREAM("Desired horizontal binning_x factor("
-                        << binning_x_to_set << ") unreachable! Setting to lower "
-                        << "limit: " << cam_->BinningHorizontal.GetMin());
-                binning_x_to_set = cam_->BinningHorizontal.GetMin();
-            }
-            else if ( binning_x_to_set > cam_->BinningHorizontal.GetMax() )
-            {
-                ROS_WARN_STREAM("Desired horizontal binning_x factor("
-                        << binning_x_to_set << ") unreachable! Setting to upper "
-                        << "limit: " << cam_->BinningHorizontal.GetMax());
-                binning_x_to_set = cam_->BinningHorizontal.GetMax();
-            }
-            cam_->BinningHorizontal.SetValue(binning_x_to_set);
-            reached_binning_x = currentBinningX();
-            cam_->StartGrabbing();
-            img_cols_ = static_cast<size_t>(cam_->Width.GetValue());
-            img_size_byte_ =  img_cols_ * img_rows_ * imagePixelDepth();
-        }
-        else
-        {
-            ROS_WARN_STREAM("Camera does not support binning. Will keep the "
-                    << "current settings");
-            reached_binning_x = currentBinningX();
+            PYLON_CAMERA_WARN_STREAM("Camera has no auto function AOI, the auto "
+                << "functions meter the whole image");
+            return false;
         }
+        setAOI(cam_->AutoFunctionAOIOffsetX, cam_->AutoFunctionAOIWidth,
+               offset_x, width);
+        setAOI(cam_->AutoFunctionAOIOffsetY, cam_->AutoFunctionAOIHeight,
+               offset_y, height);
+        PYLON_CAMERA_TRACE_PARAM("auto_function_aoi_width",
+                                 cam_->AutoFunctionAOIWidth.GetValue());
+        PYLON_CAMERA_TRACE_PARAM("auto_function_aoi_height",
+                                 cam_->AutoFunctionAOIHeight.GetValue());
+        PYLON_CAMERA_INFO_STREAM("Auto function AOI set to ["
+            << cam_->AutoFunctionAOIOffsetX.GetValue() << ", "
+            << cam_->AutoFunctionAOIOffsetY.GetValue() << ", "
+            << cam_->AutoFunctionAOIWidth.GetValue() << ", "
+            << cam_->AutoFunctionAOIHeight.GetValue() << "]");
     }
     catch ( const GenICam::GenericException &e )
     {
-        ROS_ERROR_STREAM("An exception while setting target horizontal "
-                << "binning_x factor to " << target_binning_x << " occurred: "
-                << e.GetDescription());
+        PYLON_CAMERA_ERROR_STREAM("An exception while setting the auto function AOI to ["
+                << offset_x << ", " << offset_y << ", " << width << ", "
+                << height << "] occurred: " << e.GetDescription());
         return false;
     }
     return true;
 }
 
 template <typename CameraTraitT>
-bool PylonCameraImpl<CameraTraitT>::setBinningY(const size_t& target_binning_y,
-                                                size_t& reached_binning_y)
+size_t PylonCameraImpl<CameraTraitT>::setDecimation(GenApi::IInteger& decimation,
+                                                    const size_t& target_decimation,
+                                                    const std::string& name)
 {
+    if ( GenApi::IsWritable(decimation) )
+    {
+        size_t decimation_to_set = limitBinning(decimation, target_decimation, name);
+        decimation.SetValue(decimation_to_set);
+        PYLON_CAMERA_TRACE_PARAM(name.c_str(), decimation_to_set);
+        return 1;
+    }
+    if ( target_decimation > 1 )
+    {
+        PYLON_CAMERA_INFO_STREAM("Camera does not support " << name << ", will "
+                << "decimate by " << target_decimation << " in software");
+    }
+    return std::max<size_t>(target_decimation, 1);
+}
+
+template <typename CameraTraitT>
+size_t PylonCameraImpl<CameraTraitT>::softwareDecimationCellSize() const
+{
+    const std::string pixel_format(cam_->PixelFormat.ToString().c_str());
+    // packed formats share bytes between pixels, YUV 4:2:2 shares the
+    // chroma between two pixels
+    if ( cam_->PixelSize.GetIntValue() % 8 != 0 ||
+         pixel_format.compare(0, 5, "YCbCr") == 0 ||
+         pixel_format.compare(0, 3, "YUV") == 0 )
+    {
+        return 0;
+    }
+    if ( pixel_format.compare(0, 5, "Bayer") == 0 )
+    {
+        return 2;
+    }
+    return 1;
+}
+
+template <typename CameraTraitT>
+void PylonCameraImpl<CameraTraitT>::updateImageSize()
+{
+    camera_img_rows_ = static_cast<size_t>(cam_->Height.GetValue());
+    camera_img_cols_ = static_cast<size_t>(cam_->Width.GetValue());
+    const size_t cell_size = softwareDecimationCellSize();
+    if ( cell_size == 0 )
+    {
+        if ( sw_decimation_x_ > 1 || sw_decimation_y_ > 1 )
+        {
+            PYLON_CAMERA_WARN_STREAM("Can not decimate the pixel format '"
+                    << cam_->PixelFormat.ToString() << "' in software, will "
+                    << "not decimate");
+        }
+        sw_decimation_x_ = 1;
+        sw_decimation_y_ = 1;
+        sw_decimation_cell_ = 1;
+    }
+    else
+    {
+        sw_decimation_cell_ = cell_size;
+    }
+    img_rows_ = image_kernels::decimatedLength(camera_img_rows_,
+                                               sw_decimation_cell_,
+                                               sw_decimation_y_);
+    img_cols_ = image_kernels::decimatedLength(camera_img_cols_,
+                                               sw_decimation_cell_,
+                                               sw_decimation_x_);
+    img_size_byte_ =  img_cols_ * img_rows_ * imagePixelDepth();
+}
+
+template <typename CameraTraitT>
+void PylonCameraImpl<CameraTraitT>::copyImage(const uint8_t* src, uint8_t* dst) const
+{
+    if ( sw_decimation_x_ == 1 && sw_decimation_y_ == 1 )
+    {
+        memcpy(dst, src, img_size_byte_);
+        return;
+    }
+    image_kernels::decimate(src,
+                            camera_img_rows_,
+                            camera_img_cols_,
+                            imagePixelDepth(),
+                            sw_decimation_cell_,
+                            sw_decimation_x_,
+                            sw_decimation_y_,
+                            dst);
+}
+
+template <typename CameraTraitT>
+size_t PylonCameraImpl<CameraTraitT>::limitBinning(GenApi::IInteger& binning,
+                                                   const size_t& target_binning,
+                                                   const std::string& name)
+{
+    size_t binning_to_set = target_binning;
+    if ( binning_to_set < binning.GetMin() )
+    {
+        PYLON_CAMERA_WARN_STREAM("Desired " << name << " factor(" << binning_to_set
+                << ") unreachable! Setting to lower limit: " << binning.GetMin());
+        binning_to_set = binning.GetMin();
+    }
+    else if ( binning_to_set > binning.GetMax() )
+    {
+        PYLON_CAMERA_WARN_STREAM("Desired " << name << " factor(" << binning_to_set
+                << ") unreachable! Setting to upper limit: " << binning.GetMax());
+        binning_to_set = binning.GetMax();
+    }
+    return binning_to_set;
+}
+
+template <typename CameraTraitT>
+bool PylonCameraImpl<CameraTraitT>::setGeometry(const ImageGeometry& target,
+                                                ImageGeometry& reached)
+{
+    const bool was_grabbing = cam_->IsGrabbing();
     try
     {
-        if ( GenApi::IsAvailable(cam_->BinningVertical) )
+        // the geometry can only be changed while not grabbing, hence stop
+        // only once for all values
+        if ( was_grabbing )
         {
             cam_->StopGrabbing();
-            size_t binning_y_to_set = target_binning_y;
-            if ( binning_y_to_set < cam_->BinningVertical.GetMin() )
-            {
-                ROS_WARN_STREAM("Desired vertical binning_y factor("
-                        << binning_y_to_set << ") unreachable! Setting to lower "
-                        << "limit: " << cam_->BinningVertical.GetMin());
-                binning_y_to_set = cam_->BinningVertical.GetMin();
-            }
-            else if ( binning_y_to_set > cam_->BinningVertical.GetMax() )
-            {
-                ROS_WARN_STREAM("Desired vertical binning_y factor("
-                        << binning_y_to_set << ") unreachable! Setting to upper "
-                        << "limit: " << cam_->BinningVertical.GetMax());
-                binning_y_to_set = cam_->BinningVertical.GetMax();
-            }
+        }
+
+        if ( GenApi::IsAvailable(cam_->BinningHorizontal) &&
+             GenApi::IsAvailable(cam_->BinningVertical) )
+        {
+            size_t binning_x_to_set = limitBinning(cam_->BinningHorizontal,
+                                                   target.binning_x,
+                                                   "horizontal binning_x");
+            size_t binning_y_to_set = limitBinning(cam_->BinningVertical,
+                                                   target.binning_y,
+                                                   "vertical binning_y");
+            cam_->BinningHorizontal.SetValue(binning_x_to_set);
+            PYLON_CAMERA_TRACE_PARAM("binning_x", binning_x_to_set);
             cam_->BinningVertical.SetValue(binning_y_to_set);
-            reached_binning_y = currentBinningY();
-            cam_->StartGrabbing();
-            img_rows_ = static_cast<size_t>(cam_->Height.GetValue());
-            img_size_byte_ =  img_cols_ * img_rows_ * imagePixelDepth();
+            PYLON_CAMERA_TRACE_PARAM("binning_y", binning_y_to_set);
         }
-        else
+        else if ( target.binning_x != currentBinningX() ||
+                  target.binning_y != currentBinningY() )
         {
-            ROS_WARN_STREAM("Camera does not support binning. Will keep the "
+            PYLON_CAMERA_WARN_STREAM("Camera does not support binning. Will keep the "
                     << "current settings");
-            reached_binning_y = currentBinningY();
+        }
+
+        sw_decimation_x_ = setDecimation(cam_->DecimationHorizontal,
+                                         target.decimation_x,
+                                         "decimation_x");
+        sw_decimation_y_ = setDecimation(cam_->DecimationVertical,
+                                         target.decimation_y,
+                                         "decimation_y");
+
+        // the AOI is given in binned and decimated pixels on the camera,
+        // the software decimation is done afterwards
+        const ImageGeometry current = currentGeometry();
+        const size_t subsampling_x = current.binning_x * current.decimation_x / sw_decimation_x_;
+        const size_t subsampling_y = current.binning_y * current.decimation_y / sw_decimation_y_;
+        setAOI(cam_->OffsetX, cam_->Width,
+               target.roi_offset_x / subsampling_x, target.roi_width / subsampling_x);
+        setAOI(cam_->OffsetY, cam_->Height,
+               target.roi_offset_y / subsampling_y, target.roi_height / subsampling_y);
+        PYLON_CAMERA_TRACE_PARAM("roi_width", cam_->Width.GetValue());
+        PYLON_CAMERA_TRACE_PARAM("roi_height", cam_->Height.GetValue());
+
+        updateImageSize();
+        reached = currentGeometry();
+        replanBandwidth();
+
+        if ( was_grabbing )
+        {
+            cam_->StartGrabbing();
+            resetFrameTracking();
         }
     }
     catch ( const GenICam::GenericException &e )
     {
-        ROS_ERROR_STREAM("An exception while setting target vertical "
-                << "binning_y factor to " << target_binning_y << " occurred: "
-                << e.GetDescription());
+        PYLON_CAMERA_ERROR_STREAM("An exception while setting the image geometry "
+                << "(binning = [" << target.binning_x << ", " << target.binning_y
+                << "], decimation = [" << target.decimation_x << ", "
+                << target.decimation_y << "], roi = [" << target.roi_offset_x << ", "
+                << target.roi_offset_y << ", " << target.roi_width << ", "
+                << target.roi_height << "]) occurred: " << e.GetDescription());
+        reached = currentGeometry();
+        if ( was_grabbing && !cam_->IsGrabbing() )
+        {
+            cam_->StartGrabbing();
+            resetFrameTracking();
+        }
         return false;
     }
     return true;
@@ -625,19 +1125,20 @@ bool PylonCameraImpl<CameraTraitT>::setExposure(const float& target_exposure,
         float exposure_to_set = target_exposure;
         if ( exposure_to_set < exposureTime().GetMin() )
         {
-            ROS_WARN_STREAM("Desired exposure (" << exposure_to_set << ") "
+            PYLON_CAMERA_WARN_STREAM("Desired exposure (" << exposure_to_set << ") "
                 << "time unreachable! Setting to lower limit: "
                 << exposureTime().GetMin());
             exposure_to_set = exposureTime().GetMin();
         }
         else if ( exposure_to_set > exposureTime().GetMax() )
         {
-            ROS_WARN_STREAM("Desired exposure (" << exposure_to_set << ") "
+            PYLON_CAMERA_WARN_STREAM("Desired exposure (" << exposure_to_set << ") "
                 << "time unreachable! Setting to upper limit: "
                 << exposureTime().GetMax());
             exposure_to_set = exposureTime().GetMax();
         }
         exposureTime().SetValue(exposure_to_set);
+        PYLON_CAMERA_TRACE_PARAM("exposure", exposure_to_set);
         reached_exposure = currentExposure();
 
         if ( std::fabs(reached_exposure - exposure_to_set) > exposureStep() )
@@ -649,9 +1150,9 @@ bool PylonCameraImpl<CameraTraitT>::setExposure(const float& target_exposure,
     }
     catch ( const GenICam::GenericException &e )
     {
-        ROS_ERROR_STREAM("An exception while setting target exposure to "
-                         << target_exposure << " occurred:"
-                         << e.GetDescription());
+        PYLON_CAMERA_ERROR_STREAM("An exception while setting target exposure to "
+                                  << target_exposure << " occurred:"
+                                  << e.GetDescription());
         return false;
     }
     return true;
@@ -667,14 +1168,14 @@ bool PylonCameraImpl<CameraTraitT>::setGain(const float& target_gain,
         float truncated_gain = target_gain;
         if ( truncated_gain < 0.0 )
         {
-            ROS_WARN_STREAM("Desired gain (" << target_gain << ") in "
+            PYLON_CAMERA_WARN_STREAM("Desired gain (" << target_gain << ") in "
                 << "percent out of range [0.0 - 1.0]! Setting to lower "
                 << "limit: 0.0");
             truncated_gain = 0.0;
         }
         else if ( truncated_gain > 1.0 )
         {
-            ROS_WARN_STREAM("Desired gain (" << target_gain << ") in "
+            PYLON_CAMERA_WARN_STREAM("Desired gain (" << target_gain << ") in "
                 << "percent out of range [0.0 - 1.0]! Setting to upper "
                 << "limit: 1.0");
             truncated_gain = 1.0;
@@ -683,11 +1184,12 @@ bool PylonCameraImpl<CameraTraitT>::setGain(const float& target_gain,
         float gain_to_set = gain().GetMin() +
                             truncated_gain * (gain().GetMax() - gain().GetMin());
         gain().SetValue(gain_to_set);
+        PYLON_CAMERA_TRACE_PARAM("gain", gain_to_set);
         reached_gain = currentGain();
     }
     catch ( const GenICam::GenericException &e )
     {
-        ROS_ERROR_STREAM("An exception while setting target gain to "
+        PYLON_CAMERA_ERROR_STREAM("An exception while setting target gain to "
                << target_gain << " occurred: " << e.GetDescription());
         return false;
     }
@@ -733,7 +1235,7 @@ bool PylonCameraImpl<CameraTraitT>::setBrightness(const int& target_brightness,
         }
 
 #if DEBUG
-        ROS_INFO("pylon auto finished . . .");
+        PYLON_CAMERA_INFO_STREAM("pylon auto finished . . .");
 #endif
 
         if ( autoTargetBrightness().GetMin() <= brightness_to_set &&
@@ -742,6 +1244,7 @@ bool PylonCameraImpl<CameraTraitT>::setBrightness(const int& target_brightness,
             // Use Pylon Auto Function, whenever in possible range
             // -> Own binary exposure search not necessary
             autoTargetBrightness().SetValue(brightness_to_set, true);
+            PYLON_CAMERA_TRACE_PARAM("auto_target_brightness", brightness_to_set);
             if ( exposure_auto )
             {
                 cam_->ExposureAuto.SetValue(ExposureAutoEnums::ExposureAuto_Once);
@@ -804,7 +1307,7 @@ bool PylonCameraImpl<CameraTraitT>::setBrightness(const int& target_brightness,
     }
     catch (const GenICam::GenericException &e)
     {
-        ROS_ERROR_STREAM("An generic exception while setting target brightness to "
+        PYLON_CAMERA_ERROR_STREAM("An generic exception while setting target brightness to "
                 << target_brightness << " (= "
                 << CameraTraitT::convertBrightness(std::min(255, target_brightness))
                 <<  ") occurred: " << e.GetDescription());
@@ -843,7 +1346,7 @@ bool PylonCameraImpl<CameraTraitT>::setExtendedBrightness(const int& target_brig
     if ( binary_exp_search_->isLimitReached() )
     {
         disableAllRunningAutoBrightessFunctions();
-        ROS_ERROR_STREAM("BinaryExposureSearach reached the exposure limits that "
+        PYLON_CAMERA_ERROR_STREAM("BinaryExposureSearach reached the exposure limits that "
                       << "the camera is able to set, but the target_brightness "
                       << "was not yet reached.");
         return false;
@@ -895,7 +1398,7 @@ bool PylonCameraImpl<CameraTraitT>::setShutterMode(const SHUTTER_MODE &shutter_m
     }
     catch ( const GenICam::GenericException &e )
     {
-        ROS_ERROR_STREAM("An exception while setting shutter mode to "
+        PYLON_CAMERA_ERROR_STREAM("An exception while setting shutter mode to "
                << shutter_mode << " occurred: " << e.GetDescription());
         return false;
     }
@@ -911,7 +1414,12 @@ float PylonCameraImpl<CameraTraitT>::exposureStep()
 template <typename CameraTraitT>
 float PylonCameraImpl<CameraTraitT>::maxPossibleFramerate()
 {
-    return static_cast<float>(resultingFrameRate().GetValue());
+    float max_framerate = static_cast<float>(resultingFrameRate().GetValue());
+    if ( bandwidth_limited_framerate_ > 0.0 )
+    {
+        max_framerate = std::min(max_framerate, bandwidth_limited_framerate_);
+    }
+    return max_framerate;
 }
 
 template <typename CameraTraitT>
@@ -948,7 +1456,7 @@ template <typename CameraTraitT>
 bool PylonCameraImpl<CameraTraitT>::setUserOutput(const int& output_id,
                                                   const bool& value)
 {
-    ROS_DEBUG_STREAM("Setting user_output " << output_id << " to " << value);
+    PYLON_CAMERA_DEBUG_STREAM("Setting user_output " << output_id << " to " << value);
     try
     {
         cam_->UserOutputSelector.SetValue(static_cast<UserOutputSelectorEnums>(
@@ -957,13 +1465,13 @@ bool PylonCameraImpl<CameraTraitT>::setUserOutput(const int& output_id,
     }
     catch ( const std::exception& ex )
     {
-        ROS_ERROR_STREAM("Could not set user output "  << output_id << ": "
+        PYLON_CAMERA_ERROR_STREAM("Could not set user output "  << output_id << ": "
                 << ex.what());
         return false;
     }
     if ( value != cam_->UserOutputValue.GetValue() )
     {
-        ROS_ERROR_STREAM("Value " << value << " could not be set to output "
+        PYLON_CAMERA_ERROR_STREAM("Value " << value << " could not be set to output "
                 << output_id);
         return false;
     }
@@ -30,10 +30,13 @@
 #ifndef PYLON_CAMERA_INTERNAL_GIGE_H_
 #define PYLON_CAMERA_INTERNAL_GIGE_H_
 
+#include <algorithm>
+#include <limits>
 #include <string>
 #include <vector>
 
 #include <pylon_camera/internal/pylon_camera.h>
+#include <pylon_camera/gige_bandwidth_planner.h>
 
 #include <pylon/gige/BaslerGigEInstantCamera.h>
 
@@ -62,7 +65,7 @@ struct GigECameraTrait
 typedef PylonCameraImpl<GigECameraTrait> PylonGigECamera;
 
 template <>
-bool PylonGigECamera::applyCamSpecificStartupSettings(const PylonCameraParameter& parameters)
+bool PylonGigECamera::applyCamSpecificStartupSettings(const PylonCameraSettings& parameters)
 {
     try
     {
@@ -97,7 +100,7 @@ bool PylonGigECamera::applyCamSpecificStartupSettings(const PylonCameraParameter
         if ( GenApi::IsAvailable(cam_->BinningHorizontal) &&
              GenApi::IsAvailable(cam_->BinningVertical) )
         {
-            ROS_INFO_STREAM("Cam has binning range: x(hz) = ["
+            PYLON_CAMERA_INFO_STREAM("Cam has binning range: x(hz) = ["
                     << cam_->BinningHorizontal.GetMin() << " - "
                     << cam_->BinningHorizontal.GetMax() << "], y(vt) = ["
                     << cam_->BinningVertical.GetMin() << " - "
@@ -105,14 +108,14 @@ bool PylonGigECamera::applyCamSpecificStartupSettings(const PylonCameraParameter
         }
         else
         {
-            ROS_INFO_STREAM("Cam does not support binning.");
+            PYLON_CAMERA_INFO_STREAM("Cam does not support binning.");
         }
 
-        ROS_INFO_STREAM("Cam has exposure time range: ["
+        PYLON_CAMERA_INFO_STREAM("Cam has exposure time range: ["
                 << cam_->ExposureTimeAbs.GetMin()
                 << " - " << cam_->ExposureTimeAbs.GetMax()
                 << "] measured in microseconds.");
-        ROS_INFO_STREAM("Cam has gain range: ["
+        PYLON_CAMERA_INFO_STREAM("Cam has gain range: ["
                 << cam_->GainRaw.GetMin() << " - "
                 << cam_->GainRaw.GetMax()
                 << "] measured in device specific units.");
@@ -120,16 +123,16 @@ bool PylonGigECamera::applyCamSpecificStartupSettings(const PylonCameraParameter
         // Check if gamma is available, print range
         if ( !GenApi::IsAvailable(cam_->Gamma) )
         {
-            ROS_WARN("Cam gamma not available, will keep the default (auto).");
+            PYLON_CAMERA_WARN_STREAM("Cam gamma not available, will keep the default (auto).");
         }
         else
         {
-            ROS_INFO_STREAM("Cam has gammma range: ["
+            PYLON_CAMERA_INFO_STREAM("Cam has gammma range: ["
                 << cam_->Gamma.GetMin() << " - "
                 << cam_->Gamma.GetMax() << "].");
         }
 
-        ROS_INFO_STREAM("Cam has pylon auto brightness range: ["
+        PYLON_CAMERA_INFO_STREAM("Cam has pylon auto brightness range: ["
                 << cam_->AutoTargetValue.GetMin() << " - "
                 << cam_->AutoTargetValue.GetMax()
                 << "] which is the average pixel intensity.");
@@ -139,24 +142,109 @@ bool PylonGigECamera::applyCamSpecificStartupSettings(const PylonCameraParameter
         // also in ubuntu settings -> network -> options -> MTU Size
         // from 'automatic' to 3000 if card supports it
         // Raspberry PI has MTU = 1500, max value for some cards: 9000
-        cam_->GevSCPSPacketSize.SetValue(parameters.mtu_size_);
-
-        // http://www.baslerweb.com/media/documents/AW00064902000%20Control%20Packet%20Timing%20With%20Delays.pdf
-        // inter package delay in ticks (? -> mathi said in nanosec) -> prevent lost frames
-        // package size * n_cams + 5% overhead = inter package size
-        // int n_cams = 1;
-        // int inter_package_delay_in_ticks = n_cams * imageSize() * 1.05;
-        cam_->GevSCPD.SetValue(parameters.inter_pkg_delay_);
+        if ( !parameters.plan_bandwidth_ || !applyBandwidthPlan(parameters) )
+        {
+            cam_->GevSCPSPacketSize.SetValue(parameters.mtu_size_);
+            cam_->GevSCPD.SetValue(parameters.inter_pkg_delay_);
+        }
     }
     catch ( const GenICam::GenericException &e )
     {
-        ROS_ERROR_STREAM("Error applying cam specific startup setting for GigE cameras: "
+        PYLON_CAMERA_ERROR_STREAM("Error applying cam specific startup setting for GigE cameras: "
                 << e.GetDescription());
         return false;
     }
     return true;
 }
 
+template <>
+bool PylonGigECamera::applyBandwidthPlan(const PylonCameraSettings& parameters)
+{
+    // the image size and the encoding are read from the camera on each plan,
+    // as they change with the geometry and the encoding later on
+    bandwidth_request_ = gige_bandwidth::Request();
+    bandwidth_request_.target_fps = parameters.frameRate();
+    bandwidth_request_.num_cameras = static_cast<size_t>(parameters.num_cameras_on_link_);
+    bandwidth_request_.camera_index = static_cast<size_t>(parameters.camera_index_on_link_);
+    bandwidth_request_.link_speed_bps = parameters.link_speed_ * 1e6;
+    bandwidth_request_.headroom = parameters.link_headroom_;
+    bandwidth_request_.mtu = static_cast<size_t>(parameters.mtu_size_);
+    bandwidth_request_.max_packet_size = static_cast<size_t>(cam_->GevSCPSPacketSize.GetMax());
+    bandwidth_request_.packet_size_increment = static_cast<size_t>(cam_->GevSCPSPacketSize.GetInc());
+    if ( GenApi::IsAvailable(cam_->GevTimestampTickFrequency) )
+    {
+        bandwidth_request_.tick_frequency_hz = static_cast<double>(
+                                    cam_->GevTimestampTickFrequency.GetValue());
+    }
+    given_inter_pkg_delay_ = parameters.inter_pkg_delay_given_ ? parameters.inter_pkg_delay_ : -1;
+    plan_bandwidth_ = true;
+    return replanBandwidth();
+}
+
+template <>
+bool PylonGigECamera::replanBandwidth()
+{
+    if ( !plan_bandwidth_ )
+    {
+        return true;
+    }
+    gige_bandwidth::Request request = bandwidth_request_;
+    gige_bandwidth::Plan plan;
+    try
+    {
+        // the AOI is given after binning and decimation of the camera, the
+        // software decimation is done on the host and doesn't save bandwidth
+        request.width = static_cast<size_t>(cam_->Width.GetValue());
+        request.height = static_cast<size_t>(cam_->Height.GetValue());
+        // PixelSize is given in bit, e.g. 12 for the packed formats
+        request.bytes_per_pixel = cam_->PixelSize.GetIntValue() / 8.0;
+
+        if ( !gige_bandwidth::plan(request, plan) )
+        {
+            PYLON_CAMERA_WARN_STREAM("Could not plan the GigE bandwidth, will keep the "
+                    << "current mtu size and inter-package delay");
+            bandwidth_limited_framerate_ = -1.0;
+            return false;
+        }
+
+        const int64_t inter_pkg_delay = given_inter_pkg_delay_ >= 0
+                                      ? given_inter_pkg_delay_
+                                      : plan.inter_packet_delay;
+        cam_->GevSCPSPacketSize.SetValue(plan.packet_size);
+        cam_->GevSCPD.SetValue(std::min(inter_pkg_delay, cam_->GevSCPD.GetMax()));
+        if ( GenApi::IsAvailable(cam_->GevSCFTD) )
+        {
+            cam_->GevSCFTD.SetValue(std::min(plan.frame_transmission_delay,
+                                             cam_->GevSCFTD.GetMax()));
+        }
+        bandwidth_limited_framerate_ = static_cast<float>(plan.max_fps);
+
+        PYLON_CAMERA_INFO_STREAM("GigE bandwidth plan for camera " << request.camera_index
+                << " of " << request.num_cameras << " on a "
+                << request.link_speed_bps * 1e-6 << " Mbit/s link with "
+                << request.width << " x " << request.height << " pixels: packet size = "
+                << plan.packet_size << ", inter-package delay = " << inter_pkg_delay
+                << (given_inter_pkg_delay_ >= 0 ? " (given)" : "")
+                << ", frame transmission delay = " << plan.frame_transmission_delay
+                << " ticks, " << plan.packets_per_frame << " packets per frame, "
+                << "max frame rate = " << plan.max_fps << " Hz");
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        PYLON_CAMERA_ERROR_STREAM("An exception while planning the GigE bandwidth "
+                << "occurred: " << e.GetDescription());
+        bandwidth_limited_framerate_ = -1.0;
+        return false;
+    }
+    if ( request.target_fps > plan.max_fps )
+    {
+        PYLON_CAMERA_WARN_STREAM("Desired frame rate " << request.target_fps << " Hz "
+                << "exceeds the bandwidth share of the camera, will limit it "
+                << "to " << plan.max_fps << " Hz");
+    }
+    return true;
+}
+
 template <>
 bool PylonGigECamera::setupSequencer(const std::vector<float>& exposure_times,
                                      std::vector<float>& exposure_times_set)
@@ -169,7 +257,7 @@ bool PylonGigECamera::setupSequencer(const std::vector<float>& exposure_times,
         }
         else
         {
-            ROS_ERROR("Sequence mode not enabled.");
+            PYLON_CAMERA_ERROR_STREAM("Sequence mode not enabled.");
             return false;
         }
 
@@ -191,7 +279,7 @@ bool PylonGigECamera::setupSequencer(const std::vector<float>& exposure_times,
     }
     catch ( const GenICam::GenericException &e )
     {
-        ROS_ERROR("%s", e.GetDescription());
+        PYLON_CAMERA_ERROR_STREAM(e.GetDescription());
         return false;
     }
     return true;
@@ -235,7 +323,7 @@ float PylonGigECamera::currentGamma()
 {
     if ( !GenApi::IsAvailable(cam_->Gamma) )
     {
-        ROS_WARN_STREAM("Error while trying to access gamma: cam.Gamma NodeMap"
+        PYLON_CAMERA_WARN_STREAM("Error while trying to access gamma: cam.Gamma NodeMap"
                 << " is not available!");
         return -1.;
     }
@@ -256,7 +344,7 @@ bool PylonGigECamera::setGamma(const float& target_gamma, float& reached_gamma)
 
     if ( !GenApi::IsAvailable(cam_->Gamma) )
     {
-        ROS_WARN_STREAM("Error while trying to set gamma: cam.Gamma NodeMap is"
+        PYLON_CAMERA_WARN_STREAM("Error while trying to set gamma: cam.Gamma NodeMap is"
                 << " not available!");
         return true;
     }
@@ -270,7 +358,7 @@ bool PylonGigECamera::setGamma(const float& target_gamma, float& reached_gamma)
         }
         catch ( const GenICam::GenericException &e )
         {
-            ROS_ERROR_STREAM("An exception while setting gamma selector to"
+            PYLON_CAMERA_ERROR_STREAM("An exception while setting gamma selector to"
                     << " USER occurred: " << e.GetDescription());
             return false;
         }
@@ -282,21 +370,22 @@ bool PylonGigECamera::setGamma(const float& target_gamma, float& reached_gamma)
         if ( gamma().GetMin() > gamma_to_set )
         {
             gamma_to_set = gamma().GetMin();
-            ROS_WARN_STREAM("Desired gamma unreachable! Setting to lower limit: "
-                                  << gamma_to_set);
+            PYLON_CAMERA_WARN_STREAM("Desired gamma unreachable! Setting to lower limit: "
+                                           << gamma_to_set);
         }
         else if ( gamma().GetMax() < gamma_to_set )
         {
             gamma_to_set = gamma().GetMax();
-            ROS_WARN_STREAM("Desired gamma unreachable! Setting to upper limit: "
-                                  << gamma_to_set);
+            PYLON_CAMERA_WARN_STREAM("Desired gamma unreachable! Setting to upper limit: "
+                                           << gamma_to_set);
         }
         gamma().SetValue(gamma_to_set);
+        PYLON_CAMERA_TRACE_PARAM("gamma", gamma_to_set);
         reached_gamma = currentGamma();
     }
     catch ( const GenICam::GenericException &e )
     {
-        ROS_ERROR_STREAM("An exception while setting target gamma to "
+        PYLON_CAMERA_ERROR_STREAM("An exception while setting target gamma to "
                 << target_gamma << " occurred: " << e.GetDescription());
         return false;
     }
@@ -381,6 +470,60 @@ GigECameraTrait::AutoTargetBrightnessType& PylonGigECamera::autoTargetBrightness
     }
 }
 
+template <>
+uint64_t PylonGigECamera::maxBlockID() const
+{
+    // GVSP block IDs are 16 bit and skip 0 on wrap around
+    return 0xFFFF;
+}
+
+template <>
+bool PylonGigECamera::selectBrightnessAutoFunctionAOI()
+{
+    if ( !GenApi::IsWritable(cam_->AutoFunctionAOISelector) )
+    {
+        return false;
+    }
+    // AOI1 is assigned to exposure and gain auto by default
+    cam_->AutoFunctionAOISelector.SetValue(Basler_GigECameraParams::AutoFunctionAOISelector_AOI1);
+    if ( GenApi::IsWritable(cam_->AutoFunctionAOIUsageIntensity) )
+    {
+        cam_->AutoFunctionAOIUsageIntensity.SetValue(true);
+    }
+    return true;
+}
+
+template <>
+bool PylonGigECamera::restoreHostState(const PylonCameraSettings& parameters)
+{
+    // the packet settings are part of the feature set, but the frame rate
+    // limit of the bandwidth plan is not. Planning again for the restored
+    // geometry writes the same packet settings and restores the limit.
+    if ( parameters.plan_bandwidth_ )
+    {
+        applyBandwidthPlan(parameters);
+    }
+    return true;
+}
+
+template <>
+float PylonGigECamera::currentTemperature()
+{
+    try
+    {
+        if ( GenApi::IsAvailable(cam_->TemperatureAbs) )
+        {
+            return static_cast<float>(cam_->TemperatureAbs.GetValue());
+        }
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        PYLON_CAMERA_DEBUG_STREAM("An exception while reading the device temperature "
+                << "occurred: " << e.GetDescription());
+    }
+    return std::numeric_limits<float>::quiet_NaN();
+}
+
 template <>
 std::string PylonGigECamera::typeName() const
 {
@@ -30,6 +30,7 @@
 #ifndef PYLON_CAMERA_INTERNAL_USB_H_
 #define PYLON_CAMERA_INTERNAL_USB_H_
 
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -62,7 +63,7 @@ struct USBCameraTrait
 typedef PylonCameraImpl<USBCameraTrait> PylonUSBCamera;
 
 template <>
-bool PylonUSBCamera::applyCamSpecificStartupSettings(const PylonCameraParameter& parameters)
+bool PylonUSBCamera::applyCamSpecificStartupSettings(const PylonCameraSettings& parameters)
 {
     try
     {
@@ -94,7 +95,7 @@ bool PylonUSBCamera::applyCamSpecificStartupSettings(const PylonCameraParameter&
         if ( GenApi::IsAvailable(cam_->BinningHorizontal) &&
              GenApi::IsAvailable(cam_->BinningVertical) )
         {
-            ROS_INFO_STREAM("Cam has binning range: x(hz) = ["
+            PYLON_CAMERA_INFO_STREAM("Cam has binning range: x(hz) = ["
                     << cam_->BinningHorizontal.GetMin() << " - "
                     << cam_->BinningHorizontal.GetMax() << "], y(vt) = ["
                     << cam_->BinningVertical.GetMin() << " - "
@@ -102,26 +103,26 @@ bool PylonUSBCamera::applyCamSpecificStartupSettings(const PylonCameraParameter&
         }
         else
         {
-            ROS_INFO_STREAM("Cam does not support binning.");
+            PYLON_CAMERA_INFO_STREAM("Cam does not support binning.");
         }
 
-        ROS_INFO_STREAM("Cam has exposure time range: [" << cam_->ExposureTime.GetMin()
+        PYLON_CAMERA_INFO_STREAM("Cam has exposure time range: [" << cam_->ExposureTime.GetMin()
                 << " - " << cam_->ExposureTime.GetMax()
                 << "] measured in microseconds.");
-        ROS_INFO_STREAM("Cam has gain range: [" << cam_->Gain.GetMin()
+        PYLON_CAMERA_INFO_STREAM("Cam has gain range: [" << cam_->Gain.GetMin()
                 << " - " << cam_->Gain.GetMax()
                 << "] measured in dB.");
-        ROS_INFO_STREAM("Cam has gammma range: ["
+        PYLON_CAMERA_INFO_STREAM("Cam has gammma range: ["
                 << cam_->Gamma.GetMin() << " - "
                 << cam_->Gamma.GetMax() << "].");
-        ROS_INFO_STREAM("Cam has pylon auto brightness range: ["
+        PYLON_CAMERA_INFO_STREAM("Cam has pylon auto brightness range: ["
                 << cam_->AutoTargetBrightness.GetMin() * 255 << " - "
                 << cam_->AutoTargetBrightness.GetMax() * 255
                 << "] which is the average pixel intensity.");
     }
     catch ( const GenICam::GenericException &e )
     {
-        ROS_ERROR_STREAM("Error applying cam specific startup setting for USB cameras: "
+        PYLON_CAMERA_ERROR_STREAM("Error applying cam specific startup setting for USB cameras: "
                 << e.GetDescription());
         return false;
     }
@@ -141,7 +142,7 @@ bool PylonUSBCamera::setupSequencer(const std::vector<float>& exposure_times,
         }
         else
         {
-            ROS_ERROR("Sequencer Mode not writable");
+            PYLON_CAMERA_ERROR_STREAM("Sequencer Mode not writable");
         }
 
         cam_->SequencerConfigurationMode.SetValue(Basler_UsbCameraParams::SequencerConfigurationMode_On);
@@ -185,7 +186,7 @@ bool PylonUSBCamera::setupSequencer(const std::vector<float>& exposure_times,
     }
     catch ( const GenICam::GenericException &e )
     {
-        ROS_ERROR_STREAM("ERROR while initializing pylon sequencer: "
+        PYLON_CAMERA_ERROR_STREAM("ERROR while initializing pylon sequencer: "
                 << e.GetDescription());
         return false;
     }
@@ -223,7 +224,7 @@ bool PylonUSBCamera::setGamma(const float& target_gamma, float& reached_gamma)
 {
     if ( !GenApi::IsAvailable(cam_->Gamma) )
     {
-        ROS_ERROR_STREAM("Error while trying to set gamma: cam.Gamma NodeMap is"
+        PYLON_CAMERA_ERROR_STREAM("Error while trying to set gamma: cam.Gamma NodeMap is"
                << " not available!");
         return false;
     }
@@ -234,21 +235,22 @@ bool PylonUSBCamera::setGamma(const float& target_gamma, float& reached_gamma)
         if ( gamma().GetMin() > gamma_to_set )
         {
             gamma_to_set = gamma().GetMin();
-            ROS_WARN_STREAM("Desired gamma unreachable! Setting to lower limit: "
-                                  << gamma_to_set);
+            PYLON_CAMERA_WARN_STREAM("Desired gamma unreachable! Setting to lower limit: "
+                                           << gamma_to_set);
         }
         else if ( gamma().GetMax() < gamma_to_set )
         {
             gamma_to_set = gamma().GetMax();
-            ROS_WARN_STREAM("Desired gamma unreachable! Setting to upper limit: "
-                                  << gamma_to_set);
+            PYLON_CAMERA_WARN_STREAM("Desired gamma unreachable! Setting to upper limit: "
+                                           << gamma_to_set);
         }
         gamma().SetValue(gamma_to_set);
+        PYLON_CAMERA_TRACE_PARAM("gamma", gamma_to_set);
         reached_gamma = currentGamma();
     }
     catch ( const GenICam::GenericException &e )
     {
-        ROS_ERROR_STREAM("An exception while setting target gamma to "
+        PYLON_CAMERA_ERROR_STREAM("An exception while setting target gamma to "
                 << target_gamma << " occurred: " << e.GetDescription());
         return false;
     }
@@ -333,6 +335,61 @@ USBCameraTrait::AutoTargetBrightnessType& PylonUSBCamera::autoTargetBrightness()
     }
 }
 
+template <>
+uint64_t PylonUSBCamera::maxBlockID() const
+{
+    // USB3 Vision block IDs are 64 bit
+    return 0;
+}
+
+template <>
+bool PylonUSBCamera::selectBrightnessAutoFunctionAOI()
+{
+    if ( !GenApi::IsWritable(cam_->AutoFunctionAOISelector) )
+    {
+        return false;
+    }
+    // AOI1 is assigned to exposure and gain auto by default
+    cam_->AutoFunctionAOISelector.SetValue(Basler_UsbCameraParams::AutoFunctionAOISelector_AOI1);
+    if ( GenApi::IsWritable(cam_->AutoFunctionAOIUseBrightness) )
+    {
+        cam_->AutoFunctionAOIUseBrightness.SetValue(true);
+    }
+    return true;
+}
+
+template <>
+bool PylonUSBCamera::replanBandwidth()
+{
+    // USB cameras have the link on their own
+    return true;
+}
+
+template <>
+bool PylonUSBCamera::restoreHostState(const PylonCameraSettings& parameters)
+{
+    // all startup settings of USB cameras are part of the feature set
+    return true;
+}
+
+template <>
+float PylonUSBCamera::currentTemperature()
+{
+    try
+    {
+        if ( GenApi::IsAvailable(cam_->DeviceTemperature) )
+        {
+            return static_cast<float>(cam_->DeviceTemperature.GetValue());
+        }
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        PYLON_CAMERA_DEBUG_STREAM("An exception while reading the device temperature "
+                << "occurred: " << e.GetDescription());
+    }
+    return std::numeric_limits<float>::quiet_NaN();
+}
+
 template <>
 std::string PylonUSBCamera::typeName() const
 {
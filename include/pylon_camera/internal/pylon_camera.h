@@ -38,8 +38,11 @@
 #include <string>
 #include <vector>
 
-#include <pylon_camera/pylon_camera_parameter.h>
+#include <pylon_camera/pylon_camera_settings.h>
 #include <pylon_camera/pylon_camera.h>
+#include <pylon_camera/gige_bandwidth_planner.h>
+#include <pylon_camera/logging.h>
+#include <pylon_camera/internal/tracepoints.h>
 
 namespace pylon_camera
 {
@@ -58,9 +61,19 @@ public:
 
     virtual bool setupSequencer(const std::vector<float>& exposure_times);
 
-    virtual bool applyCamSpecificStartupSettings(const PylonCameraParameter& parameters);
+    virtual bool applyCamSpecificStartupSettings(const PylonCameraSettings& parameters);
 
-    virtual bool startGrabbing(const PylonCameraParameter& parameters);
+    virtual bool loadFeatures(const PylonCameraSettings& parameters);
+
+    virtual bool saveFeatures(const PylonCameraSettings& parameters);
+
+    virtual std::string deviceIdentity();
+
+    virtual bool startGrabbing(const PylonCameraSettings& parameters);
+
+    virtual bool pauseGrabbing();
+
+    virtual bool resumeGrabbing();
 
     virtual bool grab(std::vector<uint8_t>& image);
 
@@ -74,6 +87,15 @@ public:
     virtual bool setBinningY(const size_t& target_binning_y,
                              size_t& reached_binning_y);
 
+    virtual bool setGeometry(const ImageGeometry& target, ImageGeometry& reached);
+
+    virtual ImageGeometry currentGeometry();
+
+    virtual bool setAutoFunctionAOI(const size_t& offset_x,
+                                    const size_t& offset_y,
+                                    const size_t& width,
+                                    const size_t& height);
+
     virtual bool setImageEncoding(const std::string& target_ros_encoding);
 
     virtual bool setExposure(const float& target_exposure, float& reached_exposure);
@@ -115,6 +137,8 @@ public:
 
     virtual float currentGamma();
 
+    virtual float currentTemperature();
+
     virtual float maxPossibleFramerate();
 
     virtual bool isPylonAutoBrightnessFunctionRunning();
@@ -144,6 +168,19 @@ protected:
 
     CBaslerInstantCameraT* cam_;
 
+    /**
+     * The link part of the GigE bandwidth plan, kept for re-planning after
+     * the geometry or the encoding changed. The image part is read from the
+     * camera on each plan. Only used if plan_bandwidth_ is set.
+     */
+    gige_bandwidth::Request bandwidth_request_;
+    bool plan_bandwidth_;
+
+    /**
+     * The inter-package delay which overrides the planned one, -1 if none
+     */
+    int64_t given_inter_pkg_delay_;
+
     // Each camera has it's own getter for GenApi accessors that are named
     // differently for USB and GigE
     GenApi::IFloat& exposureTime();
@@ -156,13 +193,126 @@ protected:
     GenApi::IFloat& resultingFrameRate();
     AutoTargetBrightnessType& autoTargetBrightness();
 
+    /**
+     * The block ID after which the block ID of the stream wraps around to 1,
+     * 0 if it never wraps.
+     */
+    uint64_t maxBlockID() const;
+
+    /**
+     * Selects the auto function AOI which is used by the brightness auto
+     * functions, such that the AutoFunctionAOI* nodes refer to it
+     * @return false if the camera has no auto function AOI
+     */
+    bool selectBrightnessAutoFunctionAOI();
+
     virtual bool setExtendedBrightness(const int& target_brightness,
                                        const float& current_brightness);
 
+    /**
+     * Limits the target binning factor to the range of the camera
+     * @param binning the binning node of the camera
+     * @param target_binning the desired binning factor
+     * @param name of the binning, for the log
+     * @return the binning factor to set
+     */
+    size_t limitBinning(GenApi::IInteger& binning,
+                        const size_t& target_binning,
+                        const std::string& name);
+
+    /**
+     * Sets offset and size of the AOI in one dimension, limited to the range
+     * and increments of the camera. Must not be called while grabbing.
+     * @param offset the offset node of the camera (OffsetX or OffsetY)
+     * @param size the size node of the camera (Width or Height)
+     * @param target_offset the desired offset in binned pixels
+     * @param target_size the desired size in binned pixels, 0 for max
+     */
+    void setAOI(GenApi::IInteger& offset,
+                GenApi::IInteger& size,
+                const size_t& target_offset,
+                const size_t& target_size);
+
+    /**
+     * Sets the decimation of the camera in one dimension, limited to its
+     * range. Must not be called while grabbing.
+     * @param decimation the decimation node of the camera
+     * @param target_decimation the desired decimation factor
+     * @param name of the decimation, for the log
+     * @return the factor which has to be done in software, 1 if the camera
+     *         decimates itself
+     */
+    size_t setDecimation(GenApi::IInteger& decimation,
+                         const size_t& target_decimation,
+                         const std::string& name);
+
+    /**
+     * The cell size the software decimation has to keep whole for the
+     * current pixel format, see image_kernels::decimate()
+     * @return 2 for Bayer patterns, 1 for other formats with whole bytes per
+     *         pixel and 0 for packed formats, which can not be decimated in
+     *         software
+     */
+    size_t softwareDecimationCellSize() const;
+
+    /**
+     * Reads the image size from the camera and updates the size of the
+     * images after the software decimation. Turns the software decimation
+     * off if the pixel format does not allow it.
+     */
+    void updateImageSize();
+
+    /**
+     * Copies the grab result to the image buffer, decimating in software
+     * if needed
+     * @param src the buffer of the grab result
+     * @param dst the image buffer, at least img_size_byte_ large
+     */
+    void copyImage(const uint8_t* src, uint8_t* dst) const;
+
     virtual bool grab(Pylon::CGrabResultPtr& grab_result);
 
+    /**
+     * Waits until the camera is ready for the next frame trigger and executes
+     * the software trigger.
+     * @return false if the camera did not get ready in time.
+     */
+    virtual bool executeSoftwareTrigger();
+
     virtual bool setupSequencer(const std::vector<float>& exposure_times,
                                 std::vector<float>& exposure_times_set);
+
+    /**
+     * Keeps the link settings of the parameters and plans the bandwidth with
+     * replanBandwidth(). Only available for GigE cameras.
+     * @return false if no plan could be made.
+     */
+    bool applyBandwidthPlan(const PylonCameraSettings& parameters);
+
+    /**
+     * Computes packet size, inter-package delay and frame transmission delay
+     * for the current image size and encoding of the camera and the cameras
+     * sharing the network link, writes them to the camera and updates the
+     * bandwidth frame rate limit. Must not be called while grabbing. Does
+     * nothing for USB cameras or if the bandwidth is not planned.
+     * @return false if no plan could be made, the limit is removed then.
+     */
+    bool replanBandwidth();
+
+    /**
+     * Restores the state which is derived from the startup settings but kept
+     * on the host, after a feature set was loaded. The software decimation,
+     * common to all cameras, is restored by loadFeatures() before.
+     * @return false if the state could not be restored
+     */
+    bool restoreHostState(const PylonCameraSettings& parameters);
+
+    /**
+     * Overrides the priority of the internal grab engine thread of pylon,
+     * limited to the range of the platform. Must be called before
+     * StartGrabbing().
+     */
+    void setGrabEngineThreadPriority(const int& priority);
 };
 
 }  // namespace pylon_camera
@@ -0,0 +1,108 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_INTERNAL_TRACEPOINTS_H
+#define PYLON_CAMERA_INTERNAL_TRACEPOINTS_H
+
+#include <boost/thread/recursive_mutex.hpp>
+#include <cstdint>
+
+/*
+ * Static USDT tracepoints of the provider 'pylon_camera'. If compiled in
+ * (PYLON_CAMERA_WITH_USDT, needs sys/sdt.h), each probe is a single nop
+ * until a tracer (bpftrace, perf, systemtap) attaches to it, otherwise the
+ * macros expand to nothing. List them with:
+ *   bpftrace -l 'usdt:<path to libpylon_camera.so>:pylon_camera:*'
+ *
+ * Acquisition path (thread of PylonCameraNode::spin()):
+ *   grab_start, trigger_done, retrieve_done, grab_failed, frame_lost(count),
+ *   copy_done(bytes),
+ *   rectify_start, rectify_done, publish_start, publish_done(stamp_ns)
+ * Control path:
+ *   lock_wait(site), lock_acquired(site), lock_released(site) for grab_mutex_
+ *   param_write(name, value * 1000) for each parameter written to the camera
+ */
+#ifdef PYLON_CAMERA_WITH_USDT
+#include <sys/sdt.h>
+#define PYLON_CAMERA_TRACE(name) DTRACE_PROBE(pylon_camera, name)
+#define PYLON_CAMERA_TRACE1(name, arg1) DTRACE_PROBE1(pylon_camera, name, arg1)
+#define PYLON_CAMERA_TRACE2(name, arg1, arg2) DTRACE_PROBE2(pylon_camera, name, arg1, arg2)
+#else
+#define PYLON_CAMERA_TRACE(name) do {} while (0)
+#define PYLON_CAMERA_TRACE1(name, arg1) do {} while (0)
+#define PYLON_CAMERA_TRACE2(name, arg1, arg2) do {} while (0)
+#endif
+
+/**
+ * Traces a parameter write, the value is passed in 1/1000 units as integer
+ */
+#define PYLON_CAMERA_TRACE_PARAM(name, value) \
+    PYLON_CAMERA_TRACE2(param_write, name, static_cast<int64_t>((value) * 1000.0))
+
+namespace pylon_camera
+{
+
+/**
+ * Scoped lock of a recursive mutex which emits the lock_wait, lock_acquired
+ * and lock_released tracepoints, so that the holder of the mutex during a
+ * stall can be identified.
+ */
+class TracedLockGuard
+{
+public:
+    /**
+     * @param mutex the mutex to lock
+     * @param site name of the locking function, must be a string literal
+     */
+    TracedLockGuard(boost::recursive_mutex& mutex, const char* site)
+        : mutex_(mutex),
+          site_(site)
+    {
+        PYLON_CAMERA_TRACE1(lock_wait, site_);
+        mutex_.lock();
+        PYLON_CAMERA_TRACE1(lock_acquired, site_);
+    }
+
+    ~TracedLockGuard()
+    {
+        mutex_.unlock();
+        PYLON_CAMERA_TRACE1(lock_released, site_);
+    }
+
+private:
+    TracedLockGuard(const TracedLockGuard&);
+    TracedLockGuard& operator=(const TracedLockGuard&);
+
+    boost::recursive_mutex& mutex_;
+    const char* site_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_INTERNAL_TRACEPOINTS_H
@@ -0,0 +1,181 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_LATENCY_STATS_H
+#define PYLON_CAMERA_LATENCY_STATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace pylon_camera
+{
+
+/**
+ * The stages of the acquisition pipeline whose latency is measured
+ */
+enum LATENCY_STAGE
+{
+    LS_TRIGGER_WAIT = 0,  // WaitForFrameTriggerReady() + ExecuteSoftwareTrigger()
+    LS_RETRIEVE = 1,      // RetrieveResult()
+    LS_COPY = 2,          // copy of the grab result into the image buffer
+    LS_CONVERT = 3,       // cv_bridge::toCvCopy() of the raw image
+    LS_RECTIFY = 4,       // rectification of the raw image
+    LS_PUBLISH = 5,       // publishing the raw and the rectified image
+    LS_SCHEDULING = 6,    // wake-up delay of the acquisition thread after its deadline
+    LS_TRIGGERED = 7,     // receipt of a ~trigger message to the published image
+    LS_NUM_STAGES = 8,
+};
+
+/**
+ * Summary of the latency distribution of a single stage. All values
+ * in nanoseconds.
+ */
+struct LatencySummary
+{
+    uint64_t count;
+    double mean;
+    uint64_t min;
+    uint64_t max;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+};
+
+/**
+ * Lock-free histogram with logarithmic buckets, each of them linearly divided
+ * into SUB_BUCKETS sub-buckets (HDR-style). The relative error of each
+ * recorded value is hence below 1 / SUB_BUCKETS, independent of its
+ * magnitude. record() can be called concurrently from any thread.
+ */
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    /**
+     * Adds a single value in nanoseconds to the histogram
+     */
+    void record(const uint64_t& value_ns);
+
+    /**
+     * Computes the summary of all values recorded since the last call and
+     * resets the histogram afterwards.
+     * @return the summary of the values recorded in the last period
+     */
+    LatencySummary snapshotAndReset();
+
+    /**
+     * Number of sub-buckets each power of two is divided into
+     */
+    static const uint64_t SUB_BUCKET_BITS = 5;
+    static const uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+    /**
+     * Values larger than 2^MAX_VALUE_BITS ns (~68 s) end up in the last bucket
+     */
+    static const uint64_t MAX_VALUE_BITS = 36;
+    static const uint64_t NUM_BUCKETS = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    /**
+     * Index of the bucket a value is counted in
+     */
+    static std::size_t bucketIndex(const uint64_t& value_ns);
+
+    /**
+     * The smallest value that is counted in the given bucket
+     */
+    static uint64_t bucketLowerBound(const std::size_t& index);
+
+    /**
+     * The largest value that is counted in the given bucket
+     */
+    static uint64_t bucketUpperBound(const std::size_t& index);
+
+private:
+    std::array<std::atomic<uint64_t>, NUM_BUCKETS> buckets_;
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> min_;
+    std::atomic<uint64_t> max_;
+};
+
+/**
+ * One latency histogram per stage of the acquisition pipeline
+ */
+class LatencyStats
+{
+public:
+    LatencyStats();
+
+    virtual ~LatencyStats();
+
+    /**
+     * Monotonic timestamp in nanoseconds, to be used as start time for
+     * record()
+     */
+    static inline uint64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * Records the time elapsed since start_ns for the given stage
+     * @param stage the pipeline stage
+     * @param start_ns the start time of the stage taken from now()
+     * @return the current time, which can be used as start of the next stage
+     */
+    inline uint64_t record(const LATENCY_STAGE& stage, const uint64_t& start_ns)
+    {
+        uint64_t end_ns = now();
+        histograms_[stage].record(end_ns - start_ns);
+        return end_ns;
+    }
+
+    /**
+     * Getter for the histogram of a stage
+     */
+    LatencyHistogram& histogram(const LATENCY_STAGE& stage);
+
+    /**
+     * Human readable name of a stage
+     */
+    static std::string stageName(const LATENCY_STAGE& stage);
+
+private:
+    std::array<LatencyHistogram, LS_NUM_STAGES> histograms_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_LATENCY_STATS_H
@@ -0,0 +1,205 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_LOGGING_H
+#define PYLON_CAMERA_LOGGING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+namespace pylon_camera
+{
+
+/**
+ * Severity of a log message of the camera layer
+ */
+enum LOG_LEVEL
+{
+    LL_DEBUG = 0,
+    LL_INFO = 1,
+    LL_WARN = 2,
+    LL_ERROR = 3,
+};
+
+/**
+ * Receives the log messages of the camera layer. The camera layer does not
+ * depend on ROS, the node forwards the messages to rosconsole with a
+ * RosLogSink, standalone users can install a sink of their own.
+ */
+class LogSink
+{
+public:
+    virtual ~LogSink();
+
+    /**
+     * Called for each message above the log level, possibly concurrently
+     * from several threads
+     */
+    virtual void log(const LOG_LEVEL& level, const std::string& msg) = 0;
+};
+
+/**
+ * Installs the sink all messages are forwarded to. The sink is not owned and
+ * has to outlive its use, nullptr restores the default sink which writes to
+ * stderr. Also starts the worker thread of the asynchronous messages, call
+ * it before switching threads to real-time scheduling.
+ */
+void setLogSink(LogSink* sink);
+
+/**
+ * Messages below this level are dropped before being formatted.
+ * Default: LL_INFO
+ */
+void setLogLevel(const LOG_LEVEL& level);
+
+bool isLogLevelEnabled(const LOG_LEVEL& level);
+
+/**
+ * Forwards the message to the installed sink
+ */
+void logMessage(const LOG_LEVEL& level, const std::string& msg);
+
+/**
+ * Rate limiter for the *_THROTTLE macros
+ * @param last_ns the time of the last message of the call site
+ * @param period_s the minimum time between two messages in seconds
+ * @return true if the message should be logged
+ */
+bool logThrottlePassed(std::atomic<int64_t>& last_ns, const double& period_s);
+
+/**
+ * Hands the message over to a background thread, which forwards it to the
+ * installed sink. Never blocks: the message is copied into a fixed-size slot
+ * of a lock-free queue (truncated to LOG_ASYNC_MAX_LENGTH characters) and
+ * dropped if the queue is full. The number of dropped messages is logged by
+ * the background thread.
+ */
+void logMessageAsync(const LOG_LEVEL& level, const std::string& msg);
+
+const std::size_t LOG_ASYNC_MAX_LENGTH = 511;
+
+/**
+ * State of a call site of the *_AGGREGATED macros
+ */
+struct LogSite
+{
+    LogSite();
+
+    std::atomic<int64_t> last_ns;
+    std::atomic<uint64_t> suppressed;
+};
+
+/**
+ * Rate limiter for the *_AGGREGATED macros, which counts the suppressed
+ * messages of the call site
+ * @param site the state of the call site
+ * @param period_s the minimum time between two messages in seconds
+ * @param suppressed the number of messages suppressed since the last one
+ *        which passed, only set if the message passes
+ * @return true if the message should be logged
+ */
+bool logSitePassed(LogSite& site, const double& period_s, uint64_t& suppressed);
+
+}  // namespace pylon_camera
+
+#define PYLON_CAMERA_LOG_STREAM(level, args) \
+    do \
+    { \
+        if ( ::pylon_camera::isLogLevelEnabled(level) ) \
+        { \
+            std::ostringstream pylon_camera_log_ss; \
+            pylon_camera_log_ss << args; \
+            ::pylon_camera::logMessage(level, pylon_camera_log_ss.str()); \
+        } \
+    } while ( false )
+
+#define PYLON_CAMERA_LOG_STREAM_ONCE(level, args) \
+    do \
+    { \
+        static std::atomic<bool> pylon_camera_log_hit(false); \
+        if ( !pylon_camera_log_hit.exchange(true) ) \
+        { \
+            PYLON_CAMERA_LOG_STREAM(level, args); \
+        } \
+    } while ( false )
+
+#define PYLON_CAMERA_LOG_STREAM_THROTTLE(level, period, args) \
+    do \
+    { \
+        static std::atomic<int64_t> pylon_camera_log_last(0); \
+        if ( ::pylon_camera::isLogLevelEnabled(level) && \
+             ::pylon_camera::logThrottlePassed(pylon_camera_log_last, period) ) \
+        { \
+            PYLON_CAMERA_LOG_STREAM(level, args); \
+        } \
+    } while ( false )
+
+/**
+ * For the acquisition path: at most one message per period and call site is
+ * formatted and logged asynchronously, the ones in between are only counted
+ * and reported with the next one, e.g. "... (41 more in the last 1 s)"
+ */
+#define PYLON_CAMERA_LOG_STREAM_AGGREGATED(level, period, args) \
+    do \
+    { \
+        static ::pylon_camera::LogSite pylon_camera_log_site; \
+        uint64_t pylon_camera_log_suppressed = 0; \
+        if ( ::pylon_camera::isLogLevelEnabled(level) && \
+             ::pylon_camera::logSitePassed(pylon_camera_log_site, period, \
+                                           pylon_camera_log_suppressed) ) \
+        { \
+            std::ostringstream pylon_camera_log_ss; \
+            pylon_camera_log_ss << args; \
+            if ( pylon_camera_log_suppressed > 0 ) \
+            { \
+                pylon_camera_log_ss << " (" << pylon_camera_log_suppressed \
+                                    << " more in the last " << period << " s)"; \
+            } \
+            ::pylon_camera::logMessageAsync(level, pylon_camera_log_ss.str()); \
+        } \
+    } while ( false )
+
+#define PYLON_CAMERA_DEBUG_STREAM(args) PYLON_CAMERA_LOG_STREAM(::pylon_camera::LL_DEBUG, args)
+#define PYLON_CAMERA_INFO_STREAM(args) PYLON_CAMERA_LOG_STREAM(::pylon_camera::LL_INFO, args)
+#define PYLON_CAMERA_WARN_STREAM(args) PYLON_CAMERA_LOG_STREAM(::pylon_camera::LL_WARN, args)
+#define PYLON_CAMERA_ERROR_STREAM(args) PYLON_CAMERA_LOG_STREAM(::pylon_camera::LL_ERROR, args)
+
+#define PYLON_CAMERA_ERROR_STREAM_ONCE(args) \
+    PYLON_CAMERA_LOG_STREAM_ONCE(::pylon_camera::LL_ERROR, args)
+#define PYLON_CAMERA_WARN_STREAM_THROTTLE(period, args) \
+    PYLON_CAMERA_LOG_STREAM_THROTTLE(::pylon_camera::LL_WARN, period, args)
+#define PYLON_CAMERA_WARN_STREAM_AGGREGATED(period, args) \
+    PYLON_CAMERA_LOG_STREAM_AGGREGATED(::pylon_camera::LL_WARN, period, args)
+#define PYLON_CAMERA_ERROR_STREAM_AGGREGATED(period, args) \
+    PYLON_CAMERA_LOG_STREAM_AGGREGATED(::pylon_camera::LL_ERROR, period, args)
+
+#endif  // PYLON_CAMERA_LOGGING_H
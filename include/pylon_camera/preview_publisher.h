@@ -0,0 +1,113 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_PREVIEW_PUBLISHER_H
+#define PYLON_CAMERA_PREVIEW_PUBLISHER_H
+
+#include <boost/thread.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <ros/ros.h>
+#include <image_transport/image_transport.h>
+#include <sensor_msgs/Image.h>
+
+namespace pylon_camera
+{
+
+/**
+ * Publishes a downscaled copy of the images at a low rate for operator UIs.
+ * The acquisition thread only downscales the image, the worker thread
+ * publishes it, hence the JPEG compression of the 'compressed' transport
+ * runs on the worker. Nothing is computed without subscribers.
+ */
+class PreviewPublisher
+{
+public:
+    /**
+     * @param it the image transport the preview topic is advertised with
+     * @param topic the preview topic
+     * @param max_width the preview is downscaled by the smallest integer
+     *        factor that makes it at most max_width wide
+     * @param rate the maximum rate of the preview in Hz
+     */
+    PreviewPublisher(image_transport::ImageTransport& it,
+                     const std::string& topic,
+                     const int& max_width,
+                     const double& rate);
+
+    /**
+     * Stops the worker thread, a pending preview is dropped
+     */
+    virtual ~PreviewPublisher();
+
+    /**
+     * Number of subscribers of the preview topic, over all transports
+     */
+    uint32_t getNumSubscribers() const;
+
+    /**
+     * Downscales the image and hands it over to the worker thread, if the
+     * preview is subscribed and the period of the rate has passed since the
+     * previous one. A preview the worker has not yet published is replaced.
+     * Mono and color images with 8 bit per channel and Bayer images are
+     * supported, the latter are published as mono8.
+     * @param image the full size image
+     */
+    void push(const sensor_msgs::Image& image);
+
+protected:
+    /**
+     * Loop of the worker thread, publishes the pending previews until
+     * shutdown_ is set
+     */
+    void run();
+
+    image_transport::Publisher pub_;
+    int max_width_;
+    ros::Duration period_;
+    ros::Time last_stamp_;
+
+    /**
+     * Buffers of the acquisition thread, swapped with pending_ on push()
+     */
+    sensor_msgs::Image scaled_;
+    std::vector<uint32_t> column_sums_;
+
+    boost::mutex mutex_;
+    boost::condition_variable cond_;
+    sensor_msgs::Image pending_;
+    bool has_pending_;
+    bool shutdown_;
+    boost::thread thread_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_PREVIEW_PUBLISHER_H
@@ -0,0 +1,123 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_PUBLISHER_QUEUE_MONITOR_H
+#define PYLON_CAMERA_PUBLISHER_QUEUE_MONITOR_H
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <ros/ros.h>
+#include <diagnostic_msgs/DiagnosticStatus.h>
+
+namespace pylon_camera
+{
+
+/**
+ * Reports the subscribers of a single topic and the number of messages
+ * enqueued for each of them.
+ * The drops and the backlog of the outgoing queues cannot be observed:
+ * roscpp counts a message as sent as soon as it is enqueued, also if the
+ * full queue pushes out an older one, and it does not expose the queue
+ * itself. Hence the enqueued count of a subscriber only falls behind the
+ * published count for messages published before it connected.
+ */
+class PublisherQueueMonitor
+{
+public:
+    /**
+     * @param topic the fully resolved topic name to monitor
+     * @param queue_size the queue size the topic has been advertised with
+     */
+    PublisherQueueMonitor(const std::string& topic, const uint32_t& queue_size);
+
+    virtual ~PublisherQueueMonitor();
+
+    /**
+     * Has to be called after each publish() on the monitored topic.
+     * Lock-free, hence it can be called from the acquisition thread.
+     */
+    void published();
+
+    /**
+     * Polls the roscpp publication statistics and updates the counters of
+     * each connected subscriber.
+     */
+    void update();
+
+    /**
+     * Writes the current counters as key-value pairs into the status msg
+     * @param status the diagnostic status to fill
+     */
+    void fillStatus(diagnostic_msgs::DiagnosticStatus& status) const;
+
+    /**
+     * Getter for the monitored topic name
+     */
+    const std::string& topic() const;
+
+    /**
+     * Total number of messages published on the topic
+     */
+    uint64_t numPublished() const;
+
+protected:
+    /**
+     * Accounting information of a single subscriber connection
+     */
+    struct SubscriberQueue
+    {
+        std::string caller_id;
+        uint64_t enqueued;
+    };
+
+    /**
+     * The fully resolved topic name
+     */
+    std::string topic_;
+
+    /**
+     * The queue size the topic has been advertised with, 0 for unbounded
+     */
+    uint32_t queue_size_;
+
+    /**
+     * Number of messages published on the topic so far
+     */
+    std::atomic<uint64_t> num_published_;
+
+    /**
+     * The currently connected subscribers, accessed by the connection id
+     */
+    std::map<int, SubscriberQueue> subscribers_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_PUBLISHER_QUEUE_MONITOR_H
@@ -30,11 +30,13 @@
 #ifndef PYLON_CAMERA_PYLON_CAMERA_H
 #define PYLON_CAMERA_PYLON_CAMERA_H
 
+#include <atomic>
 #include <string>
 #include <vector>
 
-#include <pylon_camera/pylon_camera_parameter.h>
+#include <pylon_camera/pylon_camera_settings.h>
 #include <pylon_camera/binary_exposure_search.h>
+#include <pylon_camera/latency_stats.h>
 
 namespace pylon_camera
 {
@@ -43,6 +45,35 @@ namespace pylon_camera
 #define CHANNEL_MONO8 1
 #define CHANNEL_RGB8  3
 
+/**
+ * The settings which determine size and position of the images on the
+ * sensor. Changing them requires to stop the grabbing, hence they are
+ * applied together by PylonCamera::setGeometry().
+ */
+struct ImageGeometry
+{
+    ImageGeometry();
+
+    size_t binning_x;
+    size_t binning_y;
+
+    /**
+     * Decimation factors. If the camera can not decimate, the PylonCamera
+     * decimates in software while copying the grab result.
+     */
+    size_t decimation_x;
+    size_t decimation_y;
+
+    /**
+     * Region of interest (AOI) in unbinned sensor pixels, like the roi of
+     * the CameraInfo. A roi_width or roi_height of 0 means the full sensor.
+     */
+    size_t roi_offset_x;
+    size_t roi_offset_y;
+    size_t roi_width;
+    size_t roi_height;
+};
+
 /**
  * The PylonCamera base class. Create a new instance using the static create() functions.
  */
@@ -86,17 +117,57 @@ public:
      * Configures the camera according to the provided ros parameters.
      * This will use the device specific parameters as e.g. the mtu size for
      * GigE-Cameras
-     * @param parameters The PylonCameraParameter set to use
+     * @param parameters The PylonCameraSettings to use
      * @return true if all parameters could be sent to the camera.
      */
-    virtual bool applyCamSpecificStartupSettings(const PylonCameraParameter& parameters) = 0;
+    virtual bool applyCamSpecificStartupSettings(const PylonCameraSettings& parameters) = 0;
+
+    /**
+     * Restores a feature set saved by saveFeatures() in one step, instead of
+     * applyCamSpecificStartupSettings() and the incremental configuration.
+     * Must be called before startGrabbing().
+     * @param parameters The PylonCameraSettings to use, defines whether
+     *        a camera UserSet or a .pfs file is loaded
+     * @return true if the feature set could be loaded, the camera is in an
+     *         undefined state otherwise and has to be configured from scratch
+     */
+    virtual bool loadFeatures(const PylonCameraSettings& parameters) = 0;
+
+    /**
+     * Saves the current state of the camera into a camera UserSet or a .pfs
+     * file, depending on the parameters.
+     * @param parameters The PylonCameraSettings to use
+     * @return true if the feature set could be saved.
+     */
+    virtual bool saveFeatures(const PylonCameraSettings& parameters) = 0;
+
+    /**
+     * Model name, serial number and firmware version of the camera, which
+     * identify the device a feature set was saved on
+     * @return the identity string
+     */
+    virtual std::string deviceIdentity() = 0;
 
     /**
      * Initializes the internal parameters of the PylonCamera instance.
-     * @param parameters The PylonCameraParameter set to use
+     * @param parameters The PylonCameraSettings to use
      * @return true if all parameters could be sent to the camera.
      */
-    virtual bool startGrabbing(const PylonCameraParameter& parameters) = 0;
+    virtual bool startGrabbing(const PylonCameraSettings& parameters) = 0;
+
+    /**
+     * Stops the grabbing until resumeGrabbing() is called, such that several
+     * changes which need a stopped camera (encoding, geometry) only cause a
+     * single restart. Does nothing if the camera is not grabbing.
+     * @return false if a communication error occurred or true otherwise.
+     */
+    virtual bool pauseGrabbing() = 0;
+
+    /**
+     * Restarts the grabbing stopped by pauseGrabbing()
+     * @return false if a communication error occurred or true otherwise.
+     */
+    virtual bool resumeGrabbing() = 0;
 
     /**
      * Grab a camera frame and copy the result into image
@@ -138,6 +209,41 @@ public:
     virtual bool setBinningY(const size_t& target_binning_y,
                              size_t& reached_binning_y) = 0;
 
+    /**
+     * Changes the geometry of the images in one transaction: the grabbing is
+     * stopped once, all values are applied and the grabbing is restarted.
+     * Values the camera can not reach are limited to its range.
+     * @param target the desired geometry.
+     * @param reached the geometry the camera delivers afterwards.
+     * @return false if a communication error occurred or true otherwise.
+     */
+    virtual bool setGeometry(const ImageGeometry& target,
+                             ImageGeometry& reached) = 0;
+
+    /**
+     * Returns the current geometry of the images.
+     * @return the current geometry.
+     */
+    virtual ImageGeometry currentGeometry() = 0;
+
+    /**
+     * Restricts the area the auto functions of the camera (exposure and gain
+     * auto) meter the brightness on. Given in pixels of the camera, i.e.
+     * binned and decimated by the camera but not by the software, relative
+     * to the sensor and not to the ROI. Values the camera can not reach are
+     * limited to its range.
+     * @param offset_x the left column of the area.
+     * @param offset_y the top row of the area.
+     * @param width the width of the area, 0 for the full image width.
+     * @param height the height of the area, 0 for the full image height.
+     * @return false if the camera has no auto function AOI or a
+     *         communication error occurred.
+     */
+    virtual bool setAutoFunctionAOI(const size_t& offset_x,
+                                    const size_t& offset_y,
+                                    const size_t& width,
+                                    const size_t& height) = 0;
+
     /**
      * Detects the supported image pixel encodings of the camera an stores
      * them in a vector.
@@ -286,6 +392,13 @@ public:
      */
     virtual float currentGamma() = 0;
 
+    /**
+     * Returns the current device temperature.
+     * @return the temperature in degree Celsius or NaN if the camera does not
+     *         provide it.
+     */
+    virtual float currentTemperature() = 0;
+
     /**
      * Checks if the camera currently tries to regulate towards a target brightness.
      * This can either be done by pylon for the range [50 - 205] or the own extendended binary search one
@@ -352,6 +465,18 @@ public:
      */
     const size_t& imageCols() const;
 
+    /**
+     * Getter for the horizontal decimation done in software
+     * @return the factor, 1 if the camera decimates or nothing is decimated
+     */
+    const size_t& softwareDecimationX() const;
+
+    /**
+     * Getter for the vertical decimation done in software
+     * @return the factor, 1 if the camera decimates or nothing is decimated
+     */
+    const size_t& softwareDecimationY() const;
+
     /**
      * Getter for the is_ready_ flag. This is set in case that the
      * grab-result-pointer of the first acquisition contains valid data.
@@ -360,6 +485,12 @@ public:
      */
     const bool& isReady() const;
 
+    /**
+     * Getter for the warm start flag
+     * @return true if the camera was configured by loadFeatures()
+     */
+    const bool& isWarmStarted() const;
+
     /**
      * Returns the number of digital user outputs, which can be set by the the
      * camera. Might be zero for some cameras. The size affects the number of
@@ -398,12 +529,62 @@ public:
      */
     const bool& isCamRemoved() const;
 
+    /**
+     * Number of failed grabs since opening the camera, including timeouts
+     * and incomplete buffers. Can be read from any thread.
+     * @return the number of failed grabs.
+     */
+    uint64_t numGrabFailures() const;
+
+    /**
+     * Number of grabs which failed because RetrieveResult() timed out.
+     * @return the number of timeouts.
+     */
+    uint64_t numGrabTimeouts() const;
+
+    /**
+     * Number of grabs which returned an incomplete or otherwise invalid
+     * buffer.
+     * @return the number of incomplete buffers.
+     */
+    uint64_t numIncompleteBuffers() const;
+
+    /**
+     * Number of frames which never reached the host, detected by gaps in the
+     * block IDs of the stream. Frames dropped in transport or by the camera
+     * (e.g. missed triggers) are counted here.
+     * @return the number of lost frames.
+     */
+    uint64_t numLostFrames() const;
+
+    /**
+     * Number of frames which reached the host but were overwritten in the
+     * stream grabber queue before they could be retrieved.
+     * @return the number of skipped frames.
+     */
+    uint64_t numSkippedFrames() const;
+
+    /**
+     * Sequence number of the last grabbed frame. It counts every frame the
+     * camera sent since the grabbing started including the lost and skipped
+     * ones, hence consumers can detect the loss by gaps in the sequence.
+     * @return the sequence number of the last frame.
+     */
+    uint64_t frameSequence() const;
+
     /**
      * Getter for the sequencer exposure times.
      * @return the list of exposure times
      */
     const std::vector<float>& sequencerExposureTimes() const;
 
+    /**
+     * Sets the latency statistics the grab stages are recorded into.
+     * @param latency_stats the statistics, NULL disables the recording.
+     *        The ownership remains with the caller.
+     */
+    void setLatencyStats(LatencyStats* latency_stats);
+
     virtual ~PylonCamera();
 protected:
     /**
@@ -424,6 +605,47 @@ protected:
      */
     BinaryExposureSearch* binary_exp_search_;
 
+    /**
+     * Per-stage latency statistics of the grab, NULL if disabled
+     */
+    LatencyStats* latency_stats_;
+
+    /**
+     * Error counters of the grab. Atomic, because they are read by the
+     * diagnostics while grabbing.
+     */
+    std::atomic<uint64_t> grab_failures_;
+    std::atomic<uint64_t> grab_timeouts_;
+    std::atomic<uint64_t> incomplete_buffers_;
+    std::atomic<uint64_t> lost_frames_;
+    std::atomic<uint64_t> skipped_frames_;
+
+    /**
+     * Updates the frame sequence and the loss counters with the block ID of
+     * the frame just retrieved.
+     * @param block_id the block ID of the frame, UINT64_MAX if not available
+     * @param max_block_id the block ID after which the block ID wraps around
+     *        to 1, 0 if it never wraps
+     * @param num_skipped number of frames the stream grabber skipped before
+     *        this frame
+     */
+    void trackFrame(const uint64_t& block_id,
+                    const uint64_t& max_block_id,
+                    const size_t& num_skipped);
+
+    /**
+     * Forgets the last block ID, has to be called after (re-)starting the
+     * grabbing, because the block IDs start again.
+     */
+    void resetFrameTracking();
+
+    /**
+     * Frame tracking state of the grabbing thread
+     */
+    uint64_t last_block_id_;
+    bool last_block_id_valid_;
+    uint64_t frame_seq_;
+
     /**
      * The DeviceUserID of the found camera
      */
@@ -444,6 +666,32 @@ protected:
      */
     size_t img_size_byte_;
 
+    /**
+     * Size of the images the camera delivers, before the software
+     * decimation
+     */
+    size_t camera_img_rows_;
+    size_t camera_img_cols_;
+
+    /**
+     * Decimation factors done in software for cameras without decimation,
+     * 1 if off
+     */
+    size_t sw_decimation_x_;
+    size_t sw_decimation_y_;
+
+    /**
+     * Edge length in pixels of the cells the software decimation keeps
+     * whole, 2 for Bayer patterns
+     */
+    size_t sw_decimation_cell_;
+
+    /**
+     * Frame rate limit of the bandwidth the camera may use on its link,
+     * -1 if not limited
+     */
+    float bandwidth_limited_framerate_;
+
     /**
      * The max time a single grab is allwed to take. This value should always
      * be greater then the max possible exposure time of the camera
@@ -456,11 +704,22 @@ protected:
      */
     bool is_ready_;
 
+    /**
+     * True if the feature set was restored by loadFeatures(), the startup
+     * configuration must not be applied again then
+     */
+    bool is_warm_started_;
+
     /**
      * True if the camera device removal from the PC has been detected.
      */
     bool is_cam_removed_;
 
+    /**
+     * True if the grabbing was stopped by pauseGrabbing()
+     */
+    bool is_grabbing_paused_;
+
     /**
      * True if the extended binary exposure search is running.
      */
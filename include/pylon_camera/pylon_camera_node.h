@@ -31,8 +31,12 @@
 #define PYLON_CAMERA_PYLON_CAMERA_NODE_H
 
 #include <boost/thread.hpp>
+#include <atomic>
+#include <map>
 #include <string>
 #include <ros/ros.h>
+#include <ros/callback_queue.h>
+#include <ros/spinner.h>
 #include <actionlib/server/simple_action_server.h>
 #include <camera_info_manager/camera_info_manager.h>
 #include <cv_bridge/cv_bridge.h>
@@ -40,10 +44,33 @@
 #include <image_transport/image_transport.h>
 #include <sensor_msgs/CameraInfo.h>
 #include <sensor_msgs/image_encodings.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
+#include <diagnostic_updater/diagnostic_updater.h>
+#include <diagnostic_updater/publisher.h>
+#include <dynamic_reconfigure/server.h>
 
 #include <pylon_camera/pylon_camera_parameter.h>
 #include <pylon_camera/pylon_camera.h>
-
+#include <pylon_camera/publisher_queue_monitor.h>
+#include <pylon_camera/image_kernels.h>
+#include <pylon_camera/latency_stats.h>
+#include <pylon_camera/image_view.h>
+#include <pylon_camera/roi_registry.h>
+#include <pylon_camera/frame_buffer_pool.h>
+#include <pylon_camera/frame_history.h>
+#include <pylon_camera/preview_publisher.h>
+#include <pylon_camera/realtime.h>
+#include <pylon_camera/ros_log_sink.h>
+#include <pylon_camera/PipelineLatency.h>
+#include <pylon_camera/Sharpness.h>
+#include <pylon_camera/ConfigApplied.h>
+#include <pylon_camera/PylonCameraConfig.h>
+#include <pylon_camera/SetDecimation.h>
+#include <pylon_camera/SetROI.h>
+#include <pylon_camera/RegisterROI.h>
+#include <pylon_camera/GetFrameHistory.h>
+
+#include <std_msgs/Empty.h>
 #include <camera_control_msgs/SetBool.h>
 #include <camera_control_msgs/SetBinning.h>
 #include <camera_control_msgs/SetBrightness.h>
@@ -57,6 +84,7 @@ namespace pylon_camera
 {
 
 typedef actionlib::SimpleActionServer<camera_control_msgs::GrabImagesAction> GrabImagesAS;
+typedef dynamic_reconfigure::Server<PylonCameraConfig> ReconfigureServer;
 
 /**
  * The ROS-node of the pylon_camera interface
@@ -65,6 +93,15 @@ class PylonCameraNode
 {
 public:
     PylonCameraNode();
+
+    /**
+     * Creates the node on top of an already created camera instead of
+     * searching for the device given by the device_user_id parameter, e.g.
+     * a software camera for benchmarking.
+     * @param pylon_camera the camera, the node takes the ownership.
+     */
+    explicit PylonCameraNode(PylonCamera* pylon_camera);
+
     virtual ~PylonCameraNode();
 
     /**
@@ -78,6 +115,21 @@ public:
      */
     virtual void spin();
 
+    /**
+     * Applies the real-time priority, the CPU pinning and the memory locking
+     * of the parameters to the calling thread, which has to be the one
+     * calling spin(). Threads started afterwards inherit the priority, hence
+     * call it after the ROS spinner is running.
+     */
+    void setupAcquisitionThread();
+
+    /**
+     * Records how late the acquisition thread woke up after the deadline of
+     * its cycle
+     * @param latency_ns the scheduling latency in ns
+     */
+    void recordSchedulingLatency(const uint64_t& latency_ns);
+
     /**
      * Getter for the frame rate set by the launch script or from the ros parameter
      * server
@@ -126,36 +178,225 @@ protected:
      */
     uint32_t getNumSubscribersRect() const;
 
+    /**
+     * Returns the number of subscribers summed up over the client ROI topics
+     */
+    uint32_t getNumSubscribersROI();
+
+    /**
+     * Advertises the image_raw topic, the publisher statistics and the
+     * latency statistics with the settings read from the ros-parameter
+     * server. Does nothing if the topics are already advertised.
+     */
+    void setupPublishers();
+
+    /**
+     * Timer callback which updates the per-subscriber drop and backlog
+     * counters of the image topics and publishes them
+     * @param event the timer event
+     */
+    void publisherStatsTimerCB(const ros::TimerEvent& event);
+
+    /**
+     * Timer callback which publishes the per-stage latency distributions of
+     * the acquisition pipeline recorded since the last call and resets them
+     * @param event the timer event
+     */
+    void latencyTimerCB(const ros::TimerEvent& event);
+
+    /**
+     * Registers the frequency and timestamp status of the image_raw topic
+     * and the camera status at the diagnostic updater.
+     */
+    void setupDiagnostics();
+
+    /**
+     * Diagnostic task reporting the error counters of the grab, the number of
+     * reconnects, the outcomes of the brightness search as well as the
+     * current exposure, gain and temperature of the camera. Never blocks the
+     * grabbing: if the camera is busy, the last read values are reported.
+     * @param stat the status to fill
+     */
+    void cameraStatusDiagnostics(diagnostic_updater::DiagnosticStatusWrapper& stat);
+
+    /**
+     * Diagnostic task reporting the number of calls and the latency of each
+     * service since the last update
+     * @param stat the status to fill
+     */
+    void serviceLatencyDiagnostics(diagnostic_updater::DiagnosticStatusWrapper& stat);
+
+    /**
+     * The latency histogram of a service, created on first use
+     */
+    LatencyHistogram* serviceLatencyHistogram(const std::string& service);
+
+    /**
+     * Advertises a service whose calls are timed into the
+     * serviceLatencyHistogram() of the service
+     * @param nh the node handle, which determines the callback queue
+     * @param service the name of the service
+     * @param callback the callback, called with this
+     */
+    template <typename RequestT, typename ResponseT>
+    ros::ServiceServer advertiseTimedService(ros::NodeHandle& nh,
+                                             const std::string& service,
+                                             bool (PylonCameraNode::*callback)(RequestT&,
+                                                                               ResponseT&));
+
+    /**
+     * Wraps the callback of a service, such that its calls are timed into
+     * the serviceLatencyHistogram() of the service
+     */
+    template <typename RequestT, typename ResponseT>
+    boost::function<bool(RequestT&, ResponseT&)> timedServiceCallback(
+                        const std::string& service,
+                        const boost::function<bool(RequestT&, ResponseT&)>& callback);
+
+    /**
+     * Deletes the current camera and installs the new one, holding the
+     * camera_mutex_ exclusively
+     * @param camera the new camera, might be nullptr
+     */
+    void replaceCamera(PylonCamera* camera);
+
+    /**
+     * Timer callback which updates the diagnostics
+     * @param event the timer event
+     */
+    void diagnosticsTimerCB(const ros::TimerEvent& event);
+
+    /**
+     * Starts the dynamic_reconfigure server with the current camera settings
+     * or, after a camera removal, updates it with the settings of the new
+     * camera.
+     */
+    void setupReconfigure();
+
+    /**
+     * dynamic_reconfigure callback. Only stores the configuration, it is
+     * applied by the grabbing thread in applyPendingConfig() between two
+     * frames. Requests arriving in the meantime are merged.
+     * @param config the requested configuration
+     * @param level bitwise or of the levels of the changed parameters
+     */
+    void reconfigureCB(PylonCameraConfig& config, uint32_t level);
+
+    /**
+     * Applies the pending dynamic_reconfigure request, if any, in one
+     * transaction while holding the grab_mutex_. The reached values are
+     * reported back to the reconfigure clients and the next grabbed frame is
+     * announced on the config_applied topic.
+     */
+    void applyPendingConfig();
+
+    /**
+     * Changes the image encoding while grabbing and updates the image
+     * messages accordingly
+     * @param target_encoding the ROS image encoding
+     * @return false if the camera does not support the encoding
+     */
+    bool setImageEncoding(const std::string& target_encoding);
+
+    /**
+     * Sets the publisher frame rate, limited to the max possible frame rate
+     * of the camera. -1 means max possible frame rate.
+     * @param target_frame_rate the desired frame rate in Hz
+     * @return the frame rate which will be used
+     */
+    double setFrameRate(const double& target_frame_rate);
+
+    /**
+     * Runs the brightness search, see setBrightness()
+     */
+    bool searchBrightness(const int& target_brightness,
+                          int& reached_brightness,
+                          const bool& exposure_auto,
+                          const bool& gain_auto);
+
     /**
      * Grabs an image and stores the image in img_raw_msg_
      * @return false if an error occurred.
      */
     virtual bool grabImage();
 
+    /**
+     * Grabs an image into the given message and rectifies it into img_rect,
+     * if the camera is calibrated. The encoding and the dimensions of img
+     * have to be set.
+     * @param img the message receiving the image data, stamp and sequence
+     * @param img_rect receives the rectified image, nullptr if the
+     *        rectification is not set up
+     * @return false if an error occurred.
+     */
+    bool grabImage(sensor_msgs::Image& img, cv_bridge::CvImage* img_rect);
+
+    /**
+     * Callback for the ~trigger topic: grabs an image right away and
+     * publishes it on the triggered_image_topic
+     * @param msg the trigger, without content
+     */
+    void triggerCB(const std_msgs::Empty::ConstPtr& msg);
+
+    /**
+     * Sets the exposure and gain for the triggered images, if they differ
+     * from the current ones. Must be called with the grab_mutex_ held.
+     * @param previous_exposure the exposure to restore after the grab, -1
+     *        if it was not changed
+     * @param previous_gain the gain to restore after the grab, -1 if it was
+     *        not changed
+     */
+    void applyTriggerSettings(float& previous_exposure, float& previous_gain);
+
+    /**
+     * Restores the exposure and gain changed by applyTriggerSettings(), such
+     * that the continuous grabbing and the GrabImages goals keep their
+     * values. Must be called with the grab_mutex_ held.
+     * @param previous_exposure the exposure to restore, ignored if negative
+     * @param previous_gain the gain to restore, ignored if negative
+     */
+    void restoreTriggerSettings(const float& previous_exposure,
+                                const float& previous_gain);
+
     /**
      * Fills the ros CameraInfo-Object with the image dimensions
      */
     virtual void setupInitialCameraInfo(sensor_msgs::CameraInfo& cam_info_msg);
 
     /**
-     * Update the horizontal binning_x factor to get downsampled images
-     * @param target_binning_x the target horizontal binning_x factor
-     * @param reached_binning_x the horizontal binning_x factor that could be
-     *        reached
-     * @return true if the targeted binning could be reached
+     * Changes binning (and all other values of the image geometry) in one
+     * transaction: the grabbing is stopped once, the camera is reconfigured
+     * and restarted and the derived state is rebuilt once. The time the
+     * grabbing was interrupted is logged and reported by the diagnostics.
+     * @param target the desired geometry
+     * @param reached the geometry that could be reached
+     * @return true if the camera accepted the geometry
+     */
+    bool setGeometry(const ImageGeometry& target, ImageGeometry& reached);
+
+    /**
+     * Updates CameraInfo, the image message and the sampling indices of the
+     * brightness search after a change of the image geometry
+     */
+    void updateGeometryDependentState();
+
+    /**
+     * Restores the feature set persisted by a previous start, if its
+     * fingerprint matches the current parameters and camera
+     * @return true if the camera was configured from the feature set
+     */
+    bool warmStart();
+
+    /**
+     * Persists the configured state of the camera and its fingerprint after
+     * a cold start, so that the next start can be a warm one
      */
-    bool setBinningX(const size_t& target_binning_x,
-                     size_t& reached_binning_x);
+    void persistFeatures();
 
     /**
-     * Update the vertical binning_y factor to get downsampled images
-     * @param target_binning_y the target vertical binning_y factor
-     * @param reached_binning_y the vertical binning_y factor that could be
-     *        reached
-     * @return true if the targeted binning could be reached
+     * The file the fingerprint of the persisted feature set is stored in
      */
-    bool setBinningY(const size_t& target_binning_y,
-                     size_t& reached_binning_y);
+    std::string fingerprintFile() const;
 
     /**
      * Service callback for updating the cameras binning setting
@@ -165,6 +406,64 @@ protected:
      */
     bool setBinningCallback(camera_control_msgs::SetBinning::Request &req,
                             camera_control_msgs::SetBinning::Response &res);
+
+    /**
+     * Service callback for setting the decimation of the camera
+     * @param req request
+     * @param res response
+     * @return true on success
+     */
+    bool setDecimationCallback(pylon_camera::SetDecimation::Request &req,
+                               pylon_camera::SetDecimation::Response &res);
+
+    /**
+     * Service callback for setting the region of interest (AOI) of the camera
+     * @param req request
+     * @param res response
+     * @return true on success
+     */
+    bool setROICallback(pylon_camera::SetROI::Request &req,
+                        pylon_camera::SetROI::Response &res);
+
+    /**
+     * Service callback for registering, renewing or removing the region of
+     * interest of a client
+     * @param req request
+     * @param res response
+     * @return true on success
+     */
+    bool registerROICallback(pylon_camera::RegisterROI::Request &req,
+                             pylon_camera::RegisterROI::Response &res);
+
+    /**
+     * Service callback returning the frames of the history in a time window
+     * around an event
+     * @param req request
+     * @param res response
+     * @return true on success
+     */
+    bool getFrameHistoryCallback(pylon_camera::GetFrameHistory::Request &req,
+                                 pylon_camera::GetFrameHistory::Response &res);
+
+    /**
+     * Sets the camera AOI to the bounding box of the regions of all
+     * registered clients. If the last client left, the AOI that was set
+     * before the first client registered is restored.
+     * @param reached the geometry that could be reached
+     * @return true if the camera accepted the geometry
+     */
+    bool applyClientROIs(ImageGeometry& reached);
+
+    /**
+     * Removes the clients whose lease ended and shrinks the AOI accordingly
+     */
+    void expireClientROIs();
+
+    /**
+     * Publishes the region of each client with subscribers as a view into
+     * the last grabbed image
+     */
+    void publishClientROIs();
     /**
      * Update the exposure value on the camera
      * @param target_exposure the targeted exposure
@@ -260,32 +559,45 @@ protected:
     bool isSleeping();
 
     /**
-     * Generates the subset of points on which the brightness search will be
-     * executed in order to speed it up. The subset are the indices of the
-     * one-dimensional image_raw data vector. The base generation is done in a
-     * recursive manner, by calling genSamplingIndicesRec
-     * @return indices describing the subset of points
+     * Calculates the mean brightness of the image based on the subset indices
+     * @return the mean brightness of the image
+     */
+    float calcCurrentBrightness();
+
+    /**
+     * Computes the sharpness of the current image on the sampled rows of the
+     * sharpness ROI and publishes it with the header of the image. Only
+     * images with 8 bit per channel are supported.
      */
-    void setupSamplingIndices(std::vector<std::size_t>& indices,
-                              std::size_t rows,
-                              std::size_t cols,
-                              int downsampling_factor);
+    void publishSharpness();
 
     /**
-     * This funcion will recursivly be called from above setupSamplingIndices()
-     * to generate the indices of pixels given the actual ROI.
-     * @return indices describing the subset of points
+     * Compares the current image with the last published one on the sampled
+     * rows and counts the skipped frames. The image becomes the new reference
+     * if it is published. Only images with 8 bit per channel are compared,
+     * all others are published. Must be called with the grab_mutex_ held.
+     * @return true if the image has to be published: it changed, the
+     *         keyframe interval is reached, its size differs from the
+     *         reference, a config_applied message is pending or it does
+     *         not have 8 bit per channel
      */
-    void genSamplingIndicesRec(std::vector<std::size_t>& indices,
-                               const std::size_t& min_window_height,
-                               const cv::Point2i& start,
-                               const cv::Point2i& end);
+    bool detectChange();
 
     /**
-     * Calculates the mean brightness of the image based on the subset indices
-     * @return the mean brightness of the image
+     * Sets the frequency range the image_raw topic is expected to be
+     * published with, lowered by the keyframe interval if the change
+     * detection may skip frames
+     * @param frame_rate the frame rate of the camera
      */
-    float calcCurrentBrightness();
+    void setExpectedFrequency(const double& frame_rate);
+
+    /**
+     * Generates the samples of the brightness search for the current image
+     * geometry and encoding. If metering regions are given, the samples are
+     * weighted and the auto function AOI of the camera is set to the
+     * bounding box of the regions.
+     */
+    void setupBrightnessSampling();
 
     /**
      * Callback for the grab images action
@@ -303,9 +615,17 @@ protected:
     /**
      * This function can also be called from the derived PylonCameraOpenCV-Class
      */
-    camera_control_msgs::GrabImagesResult grabImagesRaw(
-                    const camera_control_msgs::GrabImagesGoal::ConstPtr& goal,
-                    GrabImagesAS* action_server);
+    void grabImagesRaw(const camera_control_msgs::GrabImagesGoal::ConstPtr& goal,
+                       GrabImagesAS* action_server,
+                       camera_control_msgs::GrabImagesResult& result);
+
+    /**
+     * Releases the image buffers of the result of the previous goal into the
+     * frame buffer pool, moves the images to the spare images and empties
+     * all vectors, keeping their capacity
+     * @param result the result of the previous goal
+     */
+    void resetGrabImagesResult(camera_control_msgs::GrabImagesResult& result);
 
     void initCalibrationMatrices(sensor_msgs::CameraInfo& info,
                                  const cv::Mat& D,
@@ -329,8 +649,51 @@ protected:
     bool waitForCamera(const ros::Duration& timeout) const;
 
     ros::NodeHandle nh_;
+
+    /**
+     * The services and actions are served by spinner threads of their own,
+     * such that a long running call does not block the others:
+     * - control: the services which change the camera configuration, a
+     *   single thread, hence they are applied in the order of arrival
+     * - action: the GrabImages actions, one goal after the other
+     * - history: get_frame_history, which waits for frames after the event
+     *   and only locks the FrameHistory, hence it neither waits for a
+     *   GrabImages goal nor for a grab
+     * - info: set_sleeping, set_user_output_* and the camera_info services
+     * - trigger: the ~trigger subscriber, such that a trigger is never
+     *   queued behind other callbacks
+     * Timers, dynamic_reconfigure and the subscriptions stay on the global
+     * queue, which is spun by main().
+     * The threads do not serialize the camera access: the control services,
+     * the GrabImages goals, the trigger and register_roi still take the
+     * grab_mutex_, hence they wait for each other and for the grab of the
+     * acquisition loop. get_frame_history and the info services do not.
+     */
+    ros::CallbackQueue control_queue_;
+    ros::CallbackQueue action_queue_;
+    ros::CallbackQueue history_queue_;
+    ros::CallbackQueue info_queue_;
+    ros::CallbackQueue trigger_queue_;
+    ros::NodeHandle control_nh_;
+    ros::NodeHandle action_nh_;
+    ros::NodeHandle history_nh_;
+    ros::NodeHandle info_nh_;
+    ros::NodeHandle trigger_nh_;
+    ros::AsyncSpinner control_spinner_;
+    ros::AsyncSpinner action_spinner_;
+    ros::AsyncSpinner history_spinner_;
+    ros::AsyncSpinner info_spinner_;
+    ros::AsyncSpinner trigger_spinner_;
+
+    boost::mutex service_latency_mutex_;
+    std::map<std::string, LatencyHistogram*> service_latency_;
+
     PylonCameraParameter pylon_camera_parameter_set_;
     ros::ServiceServer set_binning_srv_;
+    ros::ServiceServer set_decimation_srv_;
+    ros::ServiceServer set_roi_srv_;
+    ros::ServiceServer register_roi_srv_;
+    ros::ServiceServer get_frame_history_srv_;
     ros::ServiceServer set_exposure_srv_;
     ros::ServiceServer set_gain_srv_;
     ros::ServiceServer set_gamma_srv_;
@@ -346,19 +709,190 @@ protected:
     ros::Publisher* img_rect_pub_;
     image_geometry::PinholeCameraModel* pinhole_model_;
 
+    PublisherQueueMonitor* img_raw_queue_monitor_;
+    PublisherQueueMonitor* img_rect_queue_monitor_;
+    ros::Publisher publisher_stats_pub_;
+    ros::Timer publisher_stats_timer_;
+
+    LatencyStats* latency_stats_;
+    ros::Publisher latency_pub_;
+    ros::Timer latency_timer_;
+    ros::Time latency_last_publish_;
+    LatencyHistogram scheduling_latency_;
+
+    ros::Subscriber trigger_sub_;
+    ros::Publisher triggered_image_pub_;
+    ros::Publisher triggered_image_rect_pub_;
+    /**
+     * The triggered images get their own messages, such that the trigger
+     * callback never writes img_raw_msg_ while spin() publishes it
+     */
+    sensor_msgs::Image triggered_img_msg_;
+    cv_bridge::CvImage triggered_img_rect_;
+    /**
+     * Time from the receipt of a trigger to the published image
+     */
+    LatencyHistogram trigger_latency_;
+
+    ros::Publisher sharpness_pub_;
+    PreviewPublisher* preview_publisher_;
+
+    /**
+     * The sampled rows of the last published image and the number of frames
+     * grabbed since, only used by the acquisition thread
+     */
+    std::vector<uint8_t> change_reference_;
+    int frames_since_publish_;
+    std::atomic<uint64_t> num_unchanged_skipped_;
+    std::atomic<uint64_t> num_keyframes_;
+
+    diagnostic_updater::Updater diagnostics_updater_;
+    diagnostic_updater::TopicDiagnostic* img_raw_diagnostic_;
+    double img_raw_min_freq_;
+    double img_raw_max_freq_;
+    ros::Timer diagnostics_timer_;
+
+    /**
+     * Counters which are written by the grabbing and the services and read
+     * by the diagnostics
+     */
+    std::atomic<uint64_t> num_reconnects_;
+    /**
+     * Set when the camera is removed, cleared when init() reconnected it.
+     * The diagnostics read it without waiting for the grab_mutex_, which
+     * is held during the whole reconnect.
+     */
+    std::atomic<bool> camera_removed_;
+    std::atomic<uint64_t> num_brightness_search_succeeded_;
+    std::atomic<uint64_t> num_brightness_search_failed_;
+    std::atomic<uint64_t> num_brightness_search_timeouts_;
+
+    /**
+     * Grab error counters of cameras which have been removed, the counters
+     * of the PylonCamera start from zero after each reconnect
+     */
+    uint64_t prev_grab_failures_;
+    uint64_t prev_grab_timeouts_;
+    uint64_t prev_incomplete_buffers_;
+    uint64_t prev_lost_frames_;
+    uint64_t prev_skipped_frames_;
+
+    /**
+     * Offset of the frame sequence of the current camera, such that the
+     * header.seq of the published images keeps counting across reconnects
+     */
+    uint64_t frame_seq_offset_;
+
+    /**
+     * Camera values of the last diagnostics update which could access the
+     * camera
+     */
+    uint64_t diag_grab_failures_;
+    uint64_t diag_grab_timeouts_;
+    uint64_t diag_incomplete_buffers_;
+    uint64_t diag_lost_frames_;
+    uint64_t diag_skipped_frames_;
+    uint64_t diag_last_lost_frames_;
+    uint64_t diag_last_grab_failures_;
+    float diag_exposure_;
+    float diag_gain_;
+    float diag_temperature_;
+
+    /**
+     * dynamic_reconfigure server and the request which is waiting to be
+     * applied by the grabbing thread. pending_config_level_ is 0 if there
+     * is none.
+     */
+    boost::recursive_mutex reconfigure_mutex_;
+    ReconfigureServer* reconfigure_server_;
+    boost::mutex pending_config_mutex_;
+    PylonCameraConfig pending_config_;
+    uint32_t pending_config_level_;
+
+    /**
+     * Announces the first frame grabbed with a new configuration
+     */
+    ros::Publisher config_applied_pub_;
+    pylon_camera::ConfigApplied config_applied_msg_;
+    bool config_applied_pending_;
+
+    /**
+     * Duration of the last geometry change, read by the diagnostics
+     */
+    std::atomic<double> last_geometry_downtime_ms_;
+
+    /**
+     * The geometry of the camera, updated after each geometry change
+     */
+    ImageGeometry current_geometry_;
+
+    /**
+     * Regions of interest registered by the clients and their publishers.
+     * geometry_before_clients_ is the geometry to restore after the last
+     * client left. Lock grab_mutex_ first if both are needed.
+     */
+    boost::mutex client_rois_mutex_;
+    RoiRegistry client_rois_;
+    std::map<std::string, ros::Publisher> client_roi_pubs_;
+    ImageGeometry geometry_before_clients_;
+    bool geometry_before_clients_valid_;
+
     GrabImagesAS grab_imgs_raw_as_;
     GrabImagesAS* grab_imgs_rect_as_;
 
+    /**
+     * The results of the GrabImages actions are reused across goals, their
+     * image buffers are exchanged through the pool, such that goals in
+     * steady state grab into memory which is already allocated
+     */
+    camera_control_msgs::GrabImagesResult grab_imgs_raw_result_;
+    camera_control_msgs::GrabImagesResult grab_imgs_rect_result_;
+    FrameBufferPool* grab_imgs_buffer_pool_;
+
+    /**
+     * The images of finished goals without their buffers, their strings are
+     * reused by the next goals. Shared by the raw and the rect action
+     * servers, which execute their goals on threads of their own, hence
+     * guarded by grab_imgs_spare_mutex_.
+     */
+    std::vector<sensor_msgs::Image> grab_imgs_spare_images_;
+    boost::mutex grab_imgs_spare_mutex_;
+
+    /**
+     * The last frames for look-back captures, nullptr if disabled
+     */
+    FrameHistory* frame_history_;
+
     sensor_msgs::Image img_raw_msg_;
     cv_bridge::CvImage* cv_bridge_img_rect_;
 
     camera_info_manager::CameraInfoManager* camera_info_manager_;
 
     std::vector<std::size_t> sampling_indices_;
+    /**
+     * Weights of the sampling_indices_ if metering regions are given,
+     * empty otherwise
+     */
+    std::vector<float> sampling_weights_;
     std::array<float, 256> brightness_exp_lut_;
 
-    bool is_sleeping_;
+    std::atomic<bool> is_sleeping_;
+
+    /**
+     * Locking model, always lock in this order:
+     * - grab_mutex_ serializes the grabbing and every transaction on the
+     *   camera which has to be ordered with it (geometry, exposure, gain,
+     *   gamma, brightness search). It is recursive, because the transactions
+     *   compose, e.g. the brightness search sets the exposure and grabs.
+     * - camera_mutex_ guards the lifetime of pylon_camera_. Single feature
+     *   accesses which need no ordering with the grabbing (user outputs)
+     *   only take it shared, hence are not blocked by a brightness search.
+     *   Replacing the camera after a removal takes it exclusively.
+     * - client_rois_mutex_, pending_config_mutex_, grab_imgs_spare_mutex_
+     *   and service_latency_mutex_ guard their data only.
+     */
     boost::recursive_mutex grab_mutex_;
+    boost::shared_mutex camera_mutex_;
 };
 
 }  // namespace pylon_camera
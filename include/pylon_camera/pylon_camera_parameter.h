@@ -34,21 +34,16 @@
 #include <vector>
 #include <ros/ros.h>
 
-namespace pylon_camera
-{
+#include <pylon_camera/pylon_camera_settings.h>
 
-enum SHUTTER_MODE
+namespace pylon_camera
 {
-    SM_ROLLING = 0,
-    SM_GLOBAL = 1,
-    SM_GLOBAL_RESET_RELEASE = 2,
-    SM_DEFAULT =  -1,
-};
 
 /**
- * Parameter class for the PylonCamera
+ * Parameter class for the PylonCamera, reads the PylonCameraSettings from the
+ * ros parameter server
  */
-class PylonCameraParameter
+class PylonCameraParameter : public PylonCameraSettings
 {
 public:
     PylonCameraParameter();
@@ -63,42 +58,12 @@ public:
      */
     void readFromRosParameterServer(const ros::NodeHandle& nh);
 
-    /**
-     * Getter for the device_user_id_ set from ros-parameter server
-     */
-    const std::string& deviceUserID() const;
-
-    /**
-     * Getter for the string describing the shutter mode
-     */
-    std::string shutterModeString() const;
-
-    /**
-     * Getter for the camera_frame_ set from ros-parameter server
-     */
-    const std::string& cameraFrame() const;
-
-    /**
-     * Getter for the frame_rate_ read from ros-parameter server
-     */
-    const double& frameRate() const;
-
-    /**
-     * Getter for the image_encoding_ read from ros-parameter server
-     */
-    const std::string& imageEncoding() const;
-
     /**
      * Setter for the frame_rate_ initially set from ros-parameter server
      * The frame rate needs to be updated with the value the camera supports
      */
     void setFrameRate(const ros::NodeHandle& nh, const double& frame_rate);
 
-    /**
-     * Getter for the camera_info_url set from ros-parameter server
-     */
-    const std::string& cameraInfoURL() const;
-
     /**
      * Setter for the camera_info_url_ if a new CameraInfo-Msgs Object is
      * provided via the SetCameraInfo-service from the CameraInfoManager
@@ -107,160 +72,105 @@ public:
                           const std::string& camera_info_url);
 
 public:
-    /** Binning factor to get downsampled images. It refers here to any camera
-     * setting which combines rectangular neighborhoods of pixels into larger
-     * "super-pixels." It reduces the resolution of the output image to
-     * (width / binning_x) x (height / binning_y).
-     * The default values binning_x = binning_y = 0 are considered the same
-     * as binning_x = binning_y = 1 (no subsampling).
-     */
-    size_t binning_x_;
-    size_t binning_y_;
-
-    /**
-     * Flagis which indicate if the binning factors are provided and hence
-     * should be set during startup
-     */
-    bool binning_x_given_;
-    bool binning_y_given_;
-
-    /**
-     * Factor that describes the image downsampling to speed up the exposure
-     * search to find the desired brightness.
-     * The smallest window height is img_rows/downsampling_factor
-     */
-    int downsampling_factor_exp_search_;
-
     // #######################################################################
-    // ###################### Image Intensity Settings  ######################
-    // #######################################################################
-    // The following settings do *NOT* have to be set. Each camera has default
-    // values which provide an automatic image adjustment
-    // If one would like to adjust image brightness, it is not
+    // The following settings only concern the pylon_camera_node, the camera
+    // layer does not use them
     // #######################################################################
 
     /**
-     * The exposure time in microseconds to be set after opening the camera.
+     * The size of the outgoing queue of each subscriber of the image_raw
+     * topic. If a subscriber is slower than the publisher, the oldest
+     * message will be dropped as soon as the queue is full.
+     * 0 means infinite queue size.
      */
-    double exposure_;
+    int image_raw_queue_size_;
 
     /**
-     * Flag which indicates if the exposure time is provided and hence should
-     * be set during startup
+     * The size of the outgoing queue of each subscriber of the image_rect
+     * topic. 0 means infinite queue size.
      */
-    bool exposure_given_;
+    int image_rect_queue_size_;
 
     /**
-     * The target gain in percent of the maximal value the camera supports
-     * For USB-Cameras, the gain is in dB, for GigE-Cameras it is given in so
-     * called 'device specific units'.
+     * The number of image buffers the GrabImages actions keep between goals,
+     * such that their images are grabbed without allocating memory. Larger
+     * goals allocate the missing buffers. 0 disables the pool.
      */
-    double gain_;
+    int grab_images_pool_size_;
 
     /**
-     * Flag which indicates if the gain value is provided and hence should be
-     * set during startup
+     * The frame history keeps the last frame_history_size_ frames, but none
+     * older than frame_history_duration_ seconds (0: no limit) and not more
+     * than frame_history_max_memory_ MB. A size of 0 disables the history.
+     * While enabled, the camera grabs even without subscribers.
      */
-    bool gain_given_;
+    int frame_history_size_;
+    double frame_history_duration_;
+    double frame_history_max_memory_;
 
     /**
-     * Gamma correction of pixel intensity.
-     * Adjusts the brightness of the pixel values output by the camera's sensor
-     * to account for a non-linearity in the human perception of brightness or
-     * of the display system (such as CRT).
+     * The rate in Hz with which the per-subscriber drop and backlog counters
+     * are published on the publisher_stats topic. 0 disables the statistics.
      */
-    double gamma_;
+    double publisher_stats_rate_;
 
     /**
-     * Flag which indicates if the gamma correction value is provided and
-     * hence should be set during startup
+     * The rate in Hz with which the per-stage latency distributions of the
+     * acquisition pipeline are published on the latency topic. 0 disables
+     * the measurement.
      */
-    bool gamma_given_;
+    double latency_stats_rate_;
 
     /**
-     * The average intensity value of the images. It depends on the exposure
-     * time as well as the gain setting. If 'exposure' is provided, the
-     * interface will try to reach the desired brightness by only varying the
-     * gain. (What may often fail, because the range of possible exposure
-     * vaules is many times higher than the gain range).
-     * If 'gain' is provided, the interface will try to reach the desired
-     * brightness by only varying the exposure time. If gain AND exposure are
-     * given, it is not possible to reach the brightness, because both are
-     * assumed to be fix.
+     * Topic on which the image grabbed for each message on ~trigger is
+     * published, the rectified one on <topic>_rect. Empty: no ~trigger
+     * subscriber
      */
-    int brightness_;
+    std::string triggered_image_topic_;
 
     /**
-     * Flag which indicates if the average brightness is provided and hence
-     * should be set during startup
+     * Exposure in microseconds and gain [0, 1] the triggered images are
+     * grabbed with. Negative: keep the current values
      */
-    bool brightness_given_;
+    float trigger_exposure_;
+    float trigger_gain_;
 
     /**
-     * Only relevant, if 'brightness' is set as ros-parameter:
-     * The brightness_continuous flag controls the auto brightness function.
-     * If it is set to false, the brightness will only be reached once.
-     * Hence changing light conditions lead to changing brightness values.
-     * If it is set to true, the given brightness will be reached continuously,
-     * trying to adapt to changing light conditions. This is only possible for
-     * values in the possible auto range of the pylon API which is
-     * e.g. [50 - 205] for acA2500-14um and acA1920-40gm
-     */
-    bool brightness_continuous_;
-    /**
-     * Only relevant, if 'brightness' is given as ros-parameter:
-     * If the camera should try to reach and / or keep the brightness, hence
-     * adapting to changing light conditions, at least one of the following
-     * flags must be set. If both are set, the interface will use the profile
-     * that tries to keep the  gain at minimum to reduce white noise.
-     * The exposure_auto flag indicates, that the desired brightness will
-     * be reached by adapting the exposure time.
-     * The gain_auto flag indicates, that the desired brightness will be
-     * reached by adapting the gain.
+     * Flag that indicates if the sharpness of each image is published on
+     * ~sharpness. It is only computed while subscribed.
      */
-    bool exposure_auto_;
-    bool gain_auto_;
-    // #######################################################################
-
-    /**
-     * The timeout while searching the exposure which is connected to the
-     * desired brightness. For slow system this has to be increased.
-     */
-    double exposure_search_timeout_;
+    bool publish_sharpness_;
 
     /**
-     * The exposure search can be limited with an upper bound. This is to
-     * prevent very high exposure times and resulting timeouts.
-     * A typical value for this upper bound is ~2000000us.
+     * Region the sharpness is computed on, [x, y, width, height] as fractions
+     * [0, 1] of the image. Empty: the whole image
      */
-    double auto_exp_upper_lim_;
+    std::vector<float> sharpness_roi_;
 
     /**
-     * The MTU size. Only used for GigE cameras.
-     * To prevent lost frames the camera has to be configured
-     * with the MTU size the network card supports. A value greater 3000
-     * should be good (1500 for RaspberryPI)
+     * Only every sharpness_row_step_-th row is sampled for the sharpness
      */
-    int mtu_size_;
+    int sharpness_row_step_;
 
     /**
-     * The inter-package delay in ticks. Only used for GigE cameras.
-     * To prevent lost frames it should be greater 0.
-     * For most of GigE-Cameras, a value of 1000 is reasonable.
-     * For GigE-Cameras used on a RaspberryPI this value should be set to 11772
+     * Change detection: an image is only published on image_raw, image_rect
+     * and the ROI topics if the mean absolute difference of its sampled rows
+     * to the last published image reaches change_threshold_ (in gray
+     * levels), or if change_keyframe_interval_ frames were grabbed since.
+     * Only every change_row_step_-th row is compared. A threshold of 0
+     * disables the change detection.
      */
-    int inter_pkg_delay_;
-
-    /**
-      Shutter mode
-    */
-    SHUTTER_MODE shutter_mode_;
+    double change_threshold_;
+    int change_keyframe_interval_;
+    int change_row_step_;
 
     /**
-     * Flag that indicates if the camera has been calibrated and the intrinsic
-     * calibration matrices are available
+     * Maximum rate in Hz of the downscaled preview on ~preview, 0 disables
+     * it. The preview is downscaled by the smallest integer factor that
+     * makes it at most preview_max_width_ pixels wide.
      */
-    bool has_intrinsic_calib_;
+    double preview_rate_;
+    int preview_max_width_;
 
 protected:
     /**
@@ -272,38 +182,14 @@ protected:
     void validateParameterSet(const ros::NodeHandle& nh);
 
     /**
-     * The tf frame under which the images were published
-     */
-    std::string camera_frame_;
-
-    /**
-     * The DeviceUserID of the camera. If empty, the first camera found in the
-     * device list will be used
-     */
-    std::string device_user_id_;
-
-    /**
-     * The desired publisher frame rate if listening to the topics.
-     * This paramter can only be set once at startup
-     * Calling the GrabImages-Action can result in a higher framerate
-     */
-    double frame_rate_;
-
-    /**
-     * The CameraInfo URL (Uniform Resource Locator) where the optional
-     * intrinsic camera calibration parameters are stored. This URL string will
-     * be parsed from the CameraInfoManager:
-     * http://wiki.ros.org/camera_info_manager
-     */
-    std::string camera_info_url_;
-
-    /**
-     * The encoding of the pixels -- channel meaning, ordering, size taken
-     * from the list of strings in include/sensor_msgs/image_encodings.h
-     * The supported encodings are 'mono8', 'bgr8', 'rgb8', 'bayer_bggr8',
-     * 'bayer_gbrg8', 'bayer_rggb8' and 'yuv422'
+     * Parses a single entry [x, y, width, height, (weight)] of the
+     * metering_regions parameter, the weight defaults to 1
+     * @param value the entry
+     * @param region the parsed region
+     * @return false if the entry is invalid
      */
-    std::string image_encoding_;
+    bool parseMeteringRegion(XmlRpc::XmlRpcValue& value,
+                             MeteringRegion& region) const;
 };
 
 }  // namespace pylon_camera
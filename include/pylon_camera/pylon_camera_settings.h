@@ -0,0 +1,423 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_PYLON_CAMERA_SETTINGS_H
+#define PYLON_CAMERA_PYLON_CAMERA_SETTINGS_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace pylon_camera
+{
+
+enum SHUTTER_MODE
+{
+    SM_ROLLING = 0,
+    SM_GLOBAL = 1,
+    SM_GLOBAL_RESET_RELEASE = 2,
+    SM_DEFAULT =  -1,
+};
+
+/**
+ * Where the fully configured camera state is persisted for a warm start
+ */
+enum FEATURE_PERSISTENCE
+{
+    FP_NONE = 0,
+    FP_USER_SET = 1,
+    FP_FILE = 2,
+};
+
+/**
+ * A weighted region the brightness is metered on. Position and size are
+ * fractions [0, 1] of the image.
+ */
+struct MeteringRegion
+{
+    float x;
+    float y;
+    float width;
+    float height;
+    float weight;
+};
+
+/**
+ * Configuration of the PylonCamera. Plain data without any dependency on
+ * ROS, processes which embed the camera fill it themselves, the
+ * pylon_camera_node reads it from the parameter server via the derived
+ * PylonCameraParameter.
+ */
+class PylonCameraSettings
+{
+public:
+    PylonCameraSettings();
+
+    virtual ~PylonCameraSettings();
+
+    /**
+     * Getter for the device_user_id_
+     */
+    const std::string& deviceUserID() const;
+
+    /**
+     * Getter for the string describing the shutter mode
+     */
+    std::string shutterModeString() const;
+
+    /**
+     * Getter for the string describing the feature persistence
+     */
+    std::string featurePersistenceString() const;
+
+    /**
+     * Computes the fingerprint of the startup configuration, i.e. of all
+     * parameters which end up in the camera's feature set, together with the
+     * identity of the camera. A persisted feature set may only be restored
+     * if its fingerprint matches.
+     * @param device_identity model, serial number and firmware of the camera
+     * @return the fingerprint as hex string
+     */
+    std::string featureSetFingerprint(const std::string& device_identity) const;
+
+    /**
+     * Getter for the camera_frame_
+     */
+    const std::string& cameraFrame() const;
+
+    /**
+     * Getter for the frame_rate_
+     */
+    const double& frameRate() const;
+
+    /**
+     * Getter for the image_encoding_
+     */
+    const std::string& imageEncoding() const;
+
+    /**
+     * Getter for the camera_info_url_
+     */
+    const std::string& cameraInfoURL() const;
+
+public:
+    /** Binning factor to get downsampled images. It refers here to any camera
+     * setting which combines rectangular neighborhoods of pixels into larger
+     * "super-pixels." It reduces the resolution of the output image to
+     * (width / binning_x) x (height / binning_y).
+     * The default values binning_x = binning_y = 0 are considered the same
+     * as binning_x = binning_y = 1 (no subsampling).
+     */
+    size_t binning_x_;
+    size_t binning_y_;
+
+    /**
+     * Flagis which indicate if the binning factors are provided and hence
+     * should be set during startup
+     */
+    bool binning_x_given_;
+    bool binning_y_given_;
+
+    /**
+     * Decimation factors: only every decimation_x-th column and every
+     * decimation_y-th row is read out. Unlike binning this keeps the
+     * sensitivity. If the camera does not support decimation, the images
+     * are decimated in software.
+     */
+    size_t decimation_x_;
+    size_t decimation_y_;
+    bool decimation_x_given_;
+    bool decimation_y_given_;
+
+    /**
+     * Region of interest (AOI) of the camera in unbinned sensor pixels. A
+     * smaller AOI allows higher frame rates. roi_width_ or roi_height_ of 0
+     * means the full sensor. roi_given_ is true if any of them is set.
+     */
+    size_t roi_offset_x_;
+    size_t roi_offset_y_;
+    size_t roi_width_;
+    size_t roi_height_;
+    bool roi_given_;
+
+    /**
+     * Factor that describes the image downsampling to speed up the exposure
+     * search to find the desired brightness.
+     * The smallest window height is img_rows/downsampling_factor
+     */
+    int downsampling_factor_exp_search_;
+
+    /**
+     * Regions the brightness is metered on. If empty, the whole image is
+     * metered. Otherwise the bounding box of the regions is set as auto
+     * function AOI of the camera and the brightness search weights the
+     * pixels with the weight of their region, the pixels outside all
+     * regions with metering_background_weight_.
+     */
+    std::vector<MeteringRegion> metering_regions_;
+    float metering_background_weight_;
+
+    // #######################################################################
+    // ###################### Image Intensity Settings  ######################
+    // #######################################################################
+    // The following settings do *NOT* have to be set. Each camera has default
+    // values which provide an automatic image adjustment
+    // If one would like to adjust image brightness, it is not
+    // #######################################################################
+
+    /**
+     * The exposure time in microseconds to be set after opening the camera.
+     */
+    double exposure_;
+
+    /**
+     * Flag which indicates if the exposure time is provided and hence should
+     * be set during startup
+     */
+    bool exposure_given_;
+
+    /**
+     * The target gain in percent of the maximal value the camera supports
+     * For USB-Cameras, the gain is in dB, for GigE-Cameras it is given in so
+     * called 'device specific units'.
+     */
+    double gain_;
+
+    /**
+     * Flag which indicates if the gain value is provided and hence should be
+     * set during startup
+     */
+    bool gain_given_;
+
+    /**
+     * Gamma correction of pixel intensity.
+     * Adjusts the brightness of the pixel values output by the camera's sensor
+     * to account for a non-linearity in the human perception of brightness or
+     * of the display system (such as CRT).
+     */
+    double gamma_;
+
+    /**
+     * Flag which indicates if the gamma correction value is provided and
+     * hence should be set during startup
+     */
+    bool gamma_given_;
+
+    /**
+     * The average intensity value of the images. It depends on the exposure
+     * time as well as the gain setting. If 'exposure' is provided, the
+     * interface will try to reach the desired brightness by only varying the
+     * gain. (What may often fail, because the range of possible exposure
+     * vaules is many times higher than the gain range).
+     * If 'gain' is provided, the interface will try to reach the desired
+     * brightness by only varying the exposure time. If gain AND exposure are
+     * given, it is not possible to reach the brightness, because both are
+     * assumed to be fix.
+     */
+    int brightness_;
+
+    /**
+     * Flag which indicates if the average brightness is provided and hence
+     * should be set during startup
+     */
+    bool brightness_given_;
+
+    /**
+     * Only relevant, if 'brightness' is set as ros-parameter:
+     * The brightness_continuous flag controls the auto brightness function.
+     * If it is set to false, the brightness will only be reached once.
+     * Hence changing light conditions lead to changing brightness values.
+     * If it is set to true, the given brightness will be reached continuously,
+     * trying to adapt to changing light conditions. This is only possible for
+     * values in the possible auto range of the pylon API which is
+     * e.g. [50 - 205] for acA2500-14um and acA1920-40gm
+     */
+    bool brightness_continuous_;
+    /**
+     * Only relevant, if 'brightness' is given as ros-parameter:
+     * If the camera should try to reach and / or keep the brightness, hence
+     * adapting to changing light conditions, at least one of the following
+     * flags must be set. If both are set, the interface will use the profile
+     * that tries to keep the  gain at minimum to reduce white noise.
+     * The exposure_auto flag indicates, that the desired brightness will
+     * be reached by adapting the exposure time.
+     * The gain_auto flag indicates, that the desired brightness will be
+     * reached by adapting the gain.
+     */
+    bool exposure_auto_;
+    bool gain_auto_;
+    // #######################################################################
+
+    /**
+     * The timeout while searching the exposure which is connected to the
+     * desired brightness. For slow system this has to be increased.
+     */
+    double exposure_search_timeout_;
+
+    /**
+     * The exposure search can be limited with an upper bound. This is to
+     * prevent very high exposure times and resulting timeouts.
+     * A typical value for this upper bound is ~2000000us.
+     */
+    double auto_exp_upper_lim_;
+
+    /**
+     * The MTU size. Only used for GigE cameras.
+     * To prevent lost frames the camera has to be configured
+     * with the MTU size the network card supports. A value greater 3000
+     * should be good (1500 for RaspberryPI)
+     */
+    int mtu_size_;
+
+    /**
+     * The inter-package delay in ticks. Only used for GigE cameras.
+     * To prevent lost frames it should be greater 0.
+     * For most of GigE-Cameras, a value of 1000 is reasonable.
+     * For GigE-Cameras used on a RaspberryPI this value should be set to 11772
+     */
+    int inter_pkg_delay_;
+
+    /**
+     * Flag which indicates if the inter-package delay is given, it then
+     * overrides the delay computed by the bandwidth planner.
+     */
+    bool inter_pkg_delay_given_;
+
+    /**
+     * If true, packet size, inter-package delay and frame transmission delay
+     * of GigE cameras are computed from the image size, the frame rate and
+     * the number of cameras sharing the link (see gige_bandwidth_planner.h).
+     */
+    bool plan_bandwidth_;
+
+    /**
+     * Number of GigE cameras which stream over the same link and the index of
+     * this camera among them, in [0, num_cameras_on_link_).
+     */
+    int num_cameras_on_link_;
+    int camera_index_on_link_;
+
+    /**
+     * Speed of the shared link in Mbit/s and the fraction of it the cameras
+     * may use in total.
+     */
+    double link_speed_;
+    double link_headroom_;
+
+    /**
+      Shutter mode
+    */
+    SHUTTER_MODE shutter_mode_;
+
+    /**
+     * Where the configured camera state is saved after a cold start and
+     * restored from on the next start, if the fingerprint matches
+     */
+    FEATURE_PERSISTENCE feature_persistence_;
+
+    /**
+     * The camera UserSet used for FP_USER_SET, e.g. 'UserSet1'
+     */
+    std::string feature_persistence_user_set_;
+
+    /**
+     * The .pfs file used for FP_FILE. The fingerprint is stored next to it
+     * in '<file>.fingerprint', for FP_USER_SET as well.
+     */
+    std::string feature_persistence_file_;
+
+    /**
+     * Real-time priority (SCHED_FIFO, 1 - 99) of the acquisition thread which
+     * triggers, retrieves and publishes the images. 0 keeps the normal
+     * scheduling.
+     */
+    int acquisition_thread_priority_;
+
+    /**
+     * The CPUs the acquisition thread is pinned to. Empty: no pinning
+     */
+    std::vector<int> acquisition_thread_cpus_;
+
+    /**
+     * Flag that indicates if all current and future pages of the process,
+     * including the frame buffers, are locked into RAM (mlockall)
+     */
+    bool lock_memory_;
+
+    /**
+     * Priority of the internal grab engine thread of pylon, which receives
+     * the frames from the device. 0 keeps the default of pylon.
+     */
+    int grab_engine_thread_priority_;
+
+    /**
+     * Flag that indicates if the camera has been calibrated and the intrinsic
+     * calibration matrices are available
+     */
+    bool has_intrinsic_calib_;
+
+protected:
+    /**
+     * The tf frame under which the images were published
+     */
+    std::string camera_frame_;
+
+    /**
+     * The DeviceUserID of the camera. If empty, the first camera found in the
+     * device list will be used
+     */
+    std::string device_user_id_;
+
+    /**
+     * The desired publisher frame rate if listening to the topics.
+     * This paramter can only be set once at startup
+     * Calling the GrabImages-Action can result in a higher framerate
+     */
+    double frame_rate_;
+
+    /**
+     * The CameraInfo URL (Uniform Resource Locator) where the optional
+     * intrinsic camera calibration parameters are stored. This URL string will
+     * be parsed from the CameraInfoManager:
+     * http://wiki.ros.org/camera_info_manager
+     */
+    std::string camera_info_url_;
+
+    /**
+     * The encoding of the pixels -- channel meaning, ordering, size taken
+     * from the list of strings in include/sensor_msgs/image_encodings.h
+     * The supported encodings are 'mono8', 'bgr8', 'rgb8', 'bayer_bggr8',
+     * 'bayer_gbrg8', 'bayer_rggb8' and 'yuv422'
+     */
+    std::string image_encoding_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_PYLON_CAMERA_SETTINGS_H
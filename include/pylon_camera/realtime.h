@@ -0,0 +1,103 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_REALTIME_H
+#define PYLON_CAMERA_REALTIME_H
+
+#include <cstdint>
+#include <vector>
+
+namespace pylon_camera
+{
+
+namespace realtime
+{
+    /**
+     * Switches the calling thread to SCHED_FIFO with the given priority.
+     * Threads created afterwards by this thread inherit the policy.
+     * @param priority 1 - 99, 0 switches back to SCHED_OTHER
+     * @return false if the process lacks the permission (CAP_SYS_NICE or
+     *         an rtprio limit) or the priority is out of range
+     */
+    bool setThreadPriority(const int& priority);
+
+    /**
+     * Pins the calling thread to the given CPUs
+     * @return false if the affinity could not be set, e.g. because none of
+     *         the CPUs is online
+     */
+    bool pinThreadToCPUs(const std::vector<int>& cpus);
+
+    /**
+     * Allows the calling thread to run on all CPUs again, e.g. in a thread
+     * created by a pinned one
+     * @return false if the affinity could not be set
+     */
+    bool unpinThread();
+
+    /**
+     * Locks all current and future pages of the process into RAM, such that
+     * touching a frame buffer never causes a page fault
+     * @return false if the memlock limit does not allow it
+     */
+    bool lockMemory();
+
+    /**
+     * Periodic sleep with absolute deadlines on CLOCK_MONOTONIC, which
+     * reports how late the thread was woken up after each deadline, i.e. its
+     * scheduling latency.
+     */
+    class CycleTimer
+    {
+    public:
+        explicit CycleTimer(const double& rate);
+
+        /**
+         * Changes the rate, starting with the next cycle
+         */
+        void setRate(const double& rate);
+
+        /**
+         * Sleeps until the end of the current cycle. If the cycle has
+         * already been overrun, the schedule restarts from now without
+         * sleeping.
+         * @param latency_ns the delay between the deadline and the wake-up
+         * @return false if the cycle was overrun, hence there was no wake-up
+         */
+        bool sleep(uint64_t& latency_ns);
+
+    private:
+        uint64_t period_ns_;
+        uint64_t deadline_ns_;
+    };
+
+}  // namespace realtime
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_REALTIME_H
@@ -0,0 +1,120 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef PYLON_CAMERA_ROI_REGISTRY_H
+#define PYLON_CAMERA_ROI_REGISTRY_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <ros/ros.h>
+#include <sensor_msgs/RegionOfInterest.h>
+
+namespace pylon_camera
+{
+
+/**
+ * The regions of interest registered by the clients of the node. Each
+ * registration is a lease which has to be renewed by the client before it
+ * expires. The camera AOI is the bounding box of all active regions.
+ * Regions are given in unbinned sensor pixels, a width or height of 0 means
+ * the full sensor in that dimension.
+ * Not thread-safe.
+ */
+class RoiRegistry
+{
+public:
+    RoiRegistry();
+
+    virtual ~RoiRegistry();
+
+    /**
+     * Registers the region of a client or renews its lease
+     * @param client_id the name of the client
+     * @param roi the region of the client
+     * @param expiry the time the lease ends
+     * @return true if the region (or the set of clients) changed
+     */
+    bool update(const std::string& client_id,
+                const sensor_msgs::RegionOfInterest& roi,
+                const ros::Time& expiry);
+
+    /**
+     * Removes the region of a client
+     * @return true if the client was registered
+     */
+    bool remove(const std::string& client_id);
+
+    /**
+     * Removes all regions whose lease ended before now
+     * @return the ids of the removed clients
+     */
+    std::vector<std::string> expire(const ros::Time& now);
+
+    /**
+     * The bounding box of all active regions. If one of the regions spans
+     * the full sensor in a dimension, so does the box (offset and size 0).
+     * @param box the bounding box
+     * @return false if there is no active region
+     */
+    bool boundingBox(sensor_msgs::RegionOfInterest& box) const;
+
+    /**
+     * The region of a client
+     * @return false if the client is not registered
+     */
+    bool region(const std::string& client_id,
+                sensor_msgs::RegionOfInterest& roi) const;
+
+    /**
+     * The ids of all registered clients
+     */
+    std::vector<std::string> clients() const;
+
+    /**
+     * Number of registered clients
+     */
+    std::size_t size() const;
+
+protected:
+    /**
+     * A single registration
+     */
+    struct Lease
+    {
+        sensor_msgs::RegionOfInterest roi;
+        ros::Time expiry;
+    };
+
+    std::map<std::string, Lease> leases_;
+};
+
+}  // namespace pylon_camera
+
+#endif  // PYLON_CAMERA_ROI_REGISTRY_H
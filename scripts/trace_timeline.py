@@ -0,0 +1,92 @@
+#! /usr/bin/env python
+
+"""
+Turns the output of trace_pylon_camera.bt into a per-frame timeline.
+
+Every frame starts with a 'grab_start' event of the acquisition thread and
+lists the offsets of the following stages in milliseconds. Waits for and
+holds of the grab_mutex_ longer than the given threshold are reported with
+the name of the locking function, as are the parameter writes in between.
+
+usage: trace_timeline.py trace.txt [--lock-threshold-ms 5.0]
+"""
+
+import argparse
+import sys
+
+ACQUISITION_PROBES = ['grab_start', 'trigger_done', 'retrieve_done',
+                      'frame_lost', 'copy_done', 'rectify_start', 'rectify_done',
+                      'publish_start', 'publish_done', 'grab_failed']
+
+
+def parse(lines):
+    for line in lines:
+        fields = line.split()
+        if len(fields) < 3 or not fields[0].isdigit():
+            continue  # bpftrace banner or empty line
+        yield (int(fields[0]), int(fields[1]),
+               fields[2].split(':')[-1], fields[3:])
+
+
+def to_ms(ns):
+    return ns / 1e6
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().split('\n')[0])
+    parser.add_argument('trace', nargs='?', type=argparse.FileType('r'),
+                        default=sys.stdin)
+    parser.add_argument('--lock-threshold-ms', type=float, default=5.0)
+    args = parser.parse_args()
+
+    frame = None
+    frame_nr = 0
+    wait_begin = {}  # tid -> (ns, site)
+    hold_begin = {}  # tid -> [(ns, site)], grab_mutex_ is recursive
+
+    def flush(frame):
+        if frame is None:
+            return
+        start = frame[0][0]
+        stages = ' '.join('%s=+%.3f' % (name, to_ms(ns - start))
+                          for ns, name, _ in frame[1:]
+                          if name in ACQUISITION_PROBES)
+        print('frame %d @%.3f: %s' % (frame_nr, to_ms(start), stages))
+        for ns, name, info in frame[1:]:
+            if name not in ACQUISITION_PROBES:
+                print('    +%.3f %s %s' % (to_ms(ns - start), name, info))
+
+    for ns, tid, probe, probe_args in parse(args.trace):
+        if probe == 'grab_start':
+            flush(frame)
+            frame_nr += 1
+            frame = [(ns, probe, '')]
+        elif probe in ACQUISITION_PROBES:
+            if frame is not None:
+                frame.append((ns, probe, ' '.join(probe_args)))
+        elif probe == 'lock_wait':
+            wait_begin[tid] = (ns, probe_args[0])
+        elif probe == 'lock_acquired':
+            site = probe_args[0]
+            if tid in wait_begin:
+                waited = ns - wait_begin.pop(tid)[0]
+                if to_ms(waited) > args.lock_threshold_ms and frame is not None:
+                    frame.append((ns, 'lock_wait',
+                                  '%s waited %.3f ms' % (site, to_ms(waited))))
+            hold_begin.setdefault(tid, []).append((ns, site))
+        elif probe == 'lock_released':
+            if hold_begin.get(tid):
+                begin, site = hold_begin[tid].pop()
+                held = ns - begin
+                if to_ms(held) > args.lock_threshold_ms and frame is not None:
+                    frame.append((ns, 'lock_hold',
+                                  '%s (tid %d) held %.3f ms' % (site, tid, to_ms(held))))
+        elif probe == 'param_write':
+            if frame is not None:
+                frame.append((ns, 'param_write', '%s = %.3f' % (
+                    probe_args[0], int(probe_args[1]) / 1000.0)))
+    flush(frame)
+
+
+if __name__ == '__main__':
+    main()
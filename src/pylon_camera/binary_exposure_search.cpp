@@ -28,6 +28,7 @@
  *****************************************************************************/
 
 #include <pylon_camera/binary_exposure_search.h>
+#include <pylon_camera/logging.h>
 
 namespace pylon_camera
 {
@@ -82,7 +83,7 @@ bool BinaryExposureSearch::update(const float& current_brightness,
 
     if ( last_unchanged_exposure_counter_ > 2 )
     {
-        ROS_ERROR_STREAM("BinaryExposureSearch failed, trying three times "
+        PYLON_CAMERA_ERROR_STREAM("BinaryExposureSearch failed, trying three times "
                 << "to set the same new exposure value");
         return false;
     }
@@ -27,9 +27,8 @@
  * POSSIBILITY OF SUCH DAMAGE.
  *****************************************************************************/
 
-#include <ros/ros.h>
 #include <pylon_camera/encoding_conversions.h>
-#include <sensor_msgs/image_encodings.h>
+#include <string>
 
 namespace pylon_camera
 {
@@ -37,37 +36,51 @@ namespace pylon_camera
 namespace encoding_conversions
 {
 
+namespace
+{
+// the subset of sensor_msgs/image_encodings.h which the camera layer needs,
+// spelled out here to keep it free of ROS
+const char MONO8[] = "mono8";
+const char MONO16[] = "mono16";
+const char BGR8[] = "bgr8";
+const char RGB8[] = "rgb8";
+const char BAYER_BGGR8[] = "bayer_bggr8";
+const char BAYER_GBRG8[] = "bayer_gbrg8";
+const char BAYER_RGGB8[] = "bayer_rggb8";
+const char BAYER_GRBG8[] = "bayer_grbg8";
+}  // namespace
+
 bool ros2GenAPI(const std::string& ros_enc, std::string& gen_api_enc)
 {
     /*
      * http://docs.ros.org/kinetic/api/sensor_msgs/html/image__encodings_8h_source.html
      */
-    if ( ros_enc == sensor_msgs::image_encodings::MONO8 )
+    if ( ros_enc == MONO8 )
     {
         gen_api_enc = "Mono8";
     }
-    else if ( ros_enc == sensor_msgs::image_encodings::BGR8 )
+    else if ( ros_enc == BGR8 )
     {
         gen_api_enc = "BGR8";
     }
-    else if ( ros_enc == sensor_msgs::image_encodings::RGB8 )
+    else if ( ros_enc == RGB8 )
     {
         gen_api_enc = "RGB8";
     }
-    else if ( ros_enc == sensor_msgs::image_encodings::BAYER_BGGR8 )
+    else if ( ros_enc == BAYER_BGGR8 )
     {
         gen_api_enc = "BayerBG8";
     }
-    else if ( ros_enc == sensor_msgs::image_encodings::BAYER_GBRG8 )
+    else if ( ros_enc == BAYER_GBRG8 )
     {
         gen_api_enc = "BayerGB8";
     }
-    else if ( ros_enc == sensor_msgs::image_encodings::BAYER_RGGB8 )
+    else if ( ros_enc == BAYER_RGGB8 )
     {
         gen_api_enc = "BayerRG8";
     }
     /*
-    else if ( ros_enc == sensor_msgs::image_encodings::YUV422 )
+    else if ( ros_enc == YUV422 )
     {
         //  This is the UYVY version of YUV422 codec http://www.fourcc.org/yuv.php#UYVY
         //  with an 8-bit depth
@@ -99,27 +112,27 @@ bool genAPI2Ros(const std::string& gen_api_enc, std::string& ros_enc)
 {
     if ( gen_api_enc == "Mono8" )
     {
-        ros_enc = sensor_msgs::image_encodings::MONO8;
+        ros_enc = MONO8;
     }
     else if ( gen_api_enc == "BGR8" )
     {
-        ros_enc = sensor_msgs::image_encodings::BGR8;
+        ros_enc = BGR8;
     }
     else if ( gen_api_enc == "RGB8" )
     {
-        ros_enc = sensor_msgs::image_encodings::RGB8;
+        ros_enc = RGB8;
     }
     else if ( gen_api_enc == "BayerBG8" )
     {
-        ros_enc = sensor_msgs::image_encodings::BAYER_BGGR8;
+        ros_enc = BAYER_BGGR8;
     }
     else if ( gen_api_enc == "BayerGB8" )
     {
-        ros_enc = sensor_msgs::image_encodings::BAYER_GBRG8;
+        ros_enc = BAYER_GBRG8;
     }
     else if ( gen_api_enc == "BayerRG8" )
     {
-        ros_enc = sensor_msgs::image_encodings::BAYER_RGGB8;
+        ros_enc = BAYER_RGGB8;
     }
     /*
     else if ( gen_api_enc == "YCbCr422_8" )
@@ -156,5 +169,6 @@ bool genAPI2Ros(const std::string& gen_api_enc, std::string& ros_enc)
     }
     return true;
 }
+
 }  // namespace encoding_conversions
 }  // namespace pylon_camera
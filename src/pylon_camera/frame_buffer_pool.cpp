@@ -0,0 +1,116 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/frame_buffer_pool.h>
+
+namespace pylon_camera
+{
+
+FrameBufferPool::FrameBufferPool(const size_t& max_buffers)
+    : mutex_()
+    , max_buffers_(max_buffers)
+    , buffers_()
+{
+    buffers_.reserve(max_buffers_);
+}
+
+FrameBufferPool::~FrameBufferPool()
+{}
+
+void FrameBufferPool::acquire(std::vector<uint8_t>& buffer)
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    if ( buffers_.empty() )
+    {
+        return;
+    }
+    // swap the largest buffer of the pool with the one of the caller, which
+    // ends up in the pool if it holds memory
+    size_t largest = 0;
+    for ( size_t i = 1; i < buffers_.size(); ++i )
+    {
+        if ( buffers_[i].capacity() > buffers_[largest].capacity() )
+        {
+            largest = i;
+        }
+    }
+    if ( buffers_[largest].capacity() <= buffer.capacity() )
+    {
+        return;
+    }
+    buffer.swap(buffers_[largest]);
+    if ( buffers_[largest].capacity() == 0 )
+    {
+        buffers_[largest].swap(buffers_.back());
+        buffers_.pop_back();
+    }
+}
+
+void FrameBufferPool::release(std::vector<uint8_t>& buffer)
+{
+    if ( buffer.capacity() == 0 )
+    {
+        return;
+    }
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    push(buffer);
+}
+
+size_t FrameBufferPool::size() const
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    return buffers_.size();
+}
+
+size_t FrameBufferPool::capacityBytes() const
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    size_t bytes = 0;
+    for ( const std::vector<uint8_t>& buffer : buffers_ )
+    {
+        bytes += buffer.capacity();
+    }
+    return bytes;
+}
+
+void FrameBufferPool::push(std::vector<uint8_t>& buffer)
+{
+    if ( buffers_.size() < max_buffers_ )
+    {
+        buffers_.push_back(std::vector<uint8_t>());
+        buffers_.back().swap(buffer);
+    }
+    else
+    {
+        // the pool is full, free the memory
+        std::vector<uint8_t>().swap(buffer);
+    }
+}
+
+}  // namespace pylon_camera
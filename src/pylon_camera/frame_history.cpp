@@ -0,0 +1,198 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/frame_history.h>
+#include <boost/make_shared.hpp>
+#include <algorithm>
+
+namespace pylon_camera
+{
+
+FrameHistory::FrameHistory(const size_t& max_frames,
+                           const double& max_age,
+                           const size_t& max_bytes)
+    : mutex_()
+    , pushed_()
+    , max_frames_(max_frames)
+    , max_age_(max_age)
+    , max_bytes_(max_bytes)
+    , slots_()
+    , next_(0)
+    , count_(0)
+    , frame_bytes_(0)
+    , memory_bytes_(0)
+{}
+
+FrameHistory::~FrameHistory()
+{}
+
+void FrameHistory::push(const sensor_msgs::Image& image)
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    if ( image.data.size() != frame_bytes_ || slots_.empty() )
+    {
+        // restart with as many slots as fit into the memory budget, the
+        // frames of the previous size are dropped
+        frame_bytes_ = image.data.size();
+        size_t num_slots = std::min(max_frames_,
+                                    max_bytes_ / std::max<size_t>(frame_bytes_, 1));
+        if ( num_slots == 0 )
+        {
+            ROS_WARN_STREAM_THROTTLE(10.0, "A frame of " << frame_bytes_
+                    << " bytes exceeds the memory budget of the frame history ("
+                    << max_bytes_ << " bytes), it stays empty");
+        }
+        slots_.clear();
+        for ( size_t i = 0; i < num_slots; ++i )
+        {
+            slots_.push_back(boost::make_shared<sensor_msgs::Image>());
+        }
+        next_ = 0;
+        count_ = 0;
+        memory_bytes_ = 0;
+        if ( num_slots == 0 )
+        {
+            return;
+        }
+    }
+
+    if ( !slots_[next_].unique() )
+    {
+        // a query still copies the old frame, it frees it when done
+        memory_bytes_ -= slots_[next_]->data.capacity();
+        slots_[next_] = boost::make_shared<sensor_msgs::Image>();
+    }
+    sensor_msgs::Image& slot = *slots_[next_];
+    const size_t previous_capacity = slot.data.capacity();
+    slot.header = image.header;
+    slot.height = image.height;
+    slot.width = image.width;
+    slot.encoding = image.encoding;
+    slot.is_bigendian = image.is_bigendian;
+    slot.step = image.step;
+    slot.data.assign(image.data.begin(), image.data.end());
+    memory_bytes_ += slot.data.capacity() - previous_capacity;
+
+    next_ = (next_ + 1) % slots_.size();
+    count_ = std::min(count_ + 1, slots_.size());
+    dropExpired();
+    pushed_.notify_all();
+}
+
+bool FrameHistory::waitFor(const ros::Time& stamp, const double& timeout) const
+{
+    const boost::system_time deadline = boost::get_system_time() +
+                boost::posix_time::microseconds(static_cast<int64_t>(timeout * 1e6));
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    while ( count_ == 0 || slots_[slotIndex(count_ - 1)]->header.stamp < stamp )
+    {
+        if ( !pushed_.timed_wait(lock, deadline) )
+        {
+            return count_ > 0 && slots_[slotIndex(count_ - 1)]->header.stamp >= stamp;
+        }
+    }
+    return true;
+}
+
+size_t FrameHistory::query(const ros::Time& start,
+                           const ros::Time& end,
+                           std::vector<sensor_msgs::Image>& images) const
+{
+    std::vector<sensor_msgs::ImagePtr> frames;
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        for ( size_t i = 0; i < count_; ++i )
+        {
+            const sensor_msgs::ImagePtr& frame = slots_[slotIndex(i)];
+            if ( frame->header.stamp >= start && frame->header.stamp <= end )
+            {
+                frames.push_back(frame);
+            }
+        }
+    }
+
+    // push() does not write into the slots referenced here
+    for ( const sensor_msgs::ImagePtr& frame : frames )
+    {
+        images.push_back(*frame);
+    }
+    return frames.size();
+}
+
+size_t FrameHistory::size() const
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    return count_;
+}
+
+size_t FrameHistory::capacity() const
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    return slots_.size();
+}
+
+size_t FrameHistory::memoryBytes() const
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    return memory_bytes_;
+}
+
+ros::Time FrameHistory::oldestStamp() const
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    return count_ > 0 ? slots_[slotIndex(0)]->header.stamp : ros::Time();
+}
+
+ros::Time FrameHistory::newestStamp() const
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    return count_ > 0 ? slots_[slotIndex(count_ - 1)]->header.stamp : ros::Time();
+}
+
+size_t FrameHistory::slotIndex(const size_t& i) const
+{
+    return (next_ + slots_.size() - count_ + i) % slots_.size();
+}
+
+void FrameHistory::dropExpired()
+{
+    if ( max_age_ <= 0.0 || count_ == 0 )
+    {
+        return;
+    }
+    const ros::Time& newest = slots_[slotIndex(count_ - 1)]->header.stamp;
+    // the memory of dropped frames is kept for the next ones
+    while ( count_ > 1 &&
+            (newest - slots_[slotIndex(0)]->header.stamp).toSec() > max_age_ )
+    {
+        --count_;
+    }
+}
+
+}  // namespace pylon_camera
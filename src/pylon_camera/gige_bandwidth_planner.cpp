@@ -0,0 +1,123 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/gige_bandwidth_planner.h>
+#include <algorithm>
+#include <cmath>
+
+namespace pylon_camera
+{
+
+namespace gige_bandwidth
+{
+
+Request::Request()
+    : width(0)
+    , height(0)
+    , bytes_per_pixel(1.0)
+    , target_fps(-1.0)
+    , num_cameras(1)
+    , camera_index(0)
+    , link_speed_bps(1e9)
+    , headroom(0.9)
+    , mtu(1500)
+    , max_packet_size(16404)
+    , packet_size_increment(4)
+    , tick_frequency_hz(125e6)
+{}
+
+Plan::Plan()
+    : packet_size(0)
+    , inter_packet_delay(0)
+    , frame_transmission_delay(0)
+    , packets_per_frame(0)
+    , wire_bytes_per_frame(0.0)
+    , bandwidth_share_bps(0.0)
+    , max_fps(0.0)
+    , planned_fps(0.0)
+{}
+
+bool plan(const Request& request, Plan& plan)
+{
+    if ( request.width == 0 || request.height == 0 ||
+         request.bytes_per_pixel <= 0.0 || request.num_cameras == 0 ||
+         request.camera_index >= request.num_cameras ||
+         request.link_speed_bps <= 0.0 || request.headroom <= 0.0 ||
+         request.tick_frequency_hz <= 0.0 ||
+         request.mtu <= PACKET_HEADER_BYTES )
+    {
+        return false;
+    }
+
+    // largest packet the camera supports which still fits into the MTU
+    const std::size_t increment = std::max<std::size_t>(request.packet_size_increment, 1);
+    plan.packet_size = std::min(request.mtu, request.max_packet_size);
+    plan.packet_size -= plan.packet_size % increment;
+    if ( plan.packet_size <= PACKET_HEADER_BYTES )
+    {
+        return false;
+    }
+
+    const std::size_t payload = plan.packet_size - PACKET_HEADER_BYTES;
+    const double frame_bytes = static_cast<double>(request.width * request.height)
+                             * request.bytes_per_pixel;
+    const std::size_t data_packets =
+            static_cast<std::size_t>(std::ceil(frame_bytes / payload));
+    plan.packets_per_frame = data_packets + 2;
+    plan.wire_bytes_per_frame = frame_bytes
+            + data_packets * (PACKET_HEADER_BYTES + ETHERNET_OVERHEAD_BYTES)
+            + LEADER_TRAILER_BYTES + 2 * ETHERNET_OVERHEAD_BYTES;
+
+    plan.bandwidth_share_bps = request.link_speed_bps
+                             * std::min(request.headroom, 1.0)
+                             / request.num_cameras;
+    plan.max_fps = plan.bandwidth_share_bps / (plan.wire_bytes_per_frame * 8.0);
+    plan.planned_fps = request.target_fps > 0.0
+                     ? std::min(request.target_fps, plan.max_fps)
+                     : plan.max_fps;
+
+    // while one camera sends a packet, the others may use the link as well:
+    // the delay between two packets of a camera is its packet time scaled
+    // with the inverse of its share of the link
+    const double packet_time = (plan.packet_size + ETHERNET_OVERHEAD_BYTES) * 8.0
+                             / request.link_speed_bps;
+    const double share = plan.bandwidth_share_bps / request.link_speed_bps;
+    const double delay = packet_time * (1.0 / share - 1.0);
+    plan.inter_packet_delay = static_cast<int64_t>(
+                                std::ceil(delay * request.tick_frequency_hz));
+
+    // start the frames of the cameras one packet time apart, so their first
+    // packets do not collide in the switch
+    plan.frame_transmission_delay = static_cast<int64_t>(std::ceil(
+            request.camera_index * packet_time * request.tick_frequency_hz));
+    return true;
+}
+
+}  // namespace gige_bandwidth
+}  // namespace pylon_camera
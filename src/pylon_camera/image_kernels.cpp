@@ -0,0 +1,595 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/image_kernels.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace pylon_camera
+{
+
+namespace image_kernels
+{
+
+namespace
+{
+
+/**
+ * Decimates a single row, returns the number of pixels written by the SSE2
+ * loop, the caller does the remaining ones
+ */
+std::size_t decimateRowSSE2(const uint8_t* src,
+                            const std::size_t& out_cols,
+                            const std::size_t& bytes_per_pixel,
+                            const std::size_t& decimation_x,
+                            uint8_t* dst)
+{
+    std::size_t col = 0;
+#ifdef __SSE2__
+    if ( bytes_per_pixel == 1 && decimation_x == 2 )
+    {
+        // keep the low byte of each 16 bit lane
+        const __m128i mask = _mm_set1_epi16(0x00FF);
+        for ( ; col + 16 <= out_cols; col += 16 )
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * col));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * col + 16));
+            a = _mm_and_si128(a, mask);
+            b = _mm_and_si128(b, mask);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + col), _mm_packus_epi16(a, b));
+        }
+    }
+    else if ( bytes_per_pixel == 1 && decimation_x == 4 )
+    {
+        // keep the low byte of each 32 bit lane
+        const __m128i mask = _mm_set1_epi32(0x000000FF);
+        for ( ; col + 16 <= out_cols; col += 16 )
+        {
+            const __m128i* in = reinterpret_cast<const __m128i*>(src + 4 * col);
+            __m128i a = _mm_and_si128(_mm_loadu_si128(in), mask);
+            __m128i b = _mm_and_si128(_mm_loadu_si128(in + 1), mask);
+            __m128i c = _mm_and_si128(_mm_loadu_si128(in + 2), mask);
+            __m128i d = _mm_and_si128(_mm_loadu_si128(in + 3), mask);
+            const __m128i ab = _mm_packs_epi32(a, b);
+            const __m128i cd = _mm_packs_epi32(c, d);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + col), _mm_packus_epi16(ab, cd));
+        }
+    }
+    else if ( bytes_per_pixel == 2 && decimation_x == 2 )
+    {
+        // sign extend the low 16 bit of each 32 bit lane, hence the signed
+        // saturation of the pack keeps all 16 bits
+        for ( ; col + 8 <= out_cols; col += 8 )
+        {
+            const __m128i* in = reinterpret_cast<const __m128i*>(src + 4 * col);
+            __m128i a = _mm_loadu_si128(in);
+            __m128i b = _mm_loadu_si128(in + 1);
+            a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+            b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * col), _mm_packs_epi32(a, b));
+        }
+    }
+#endif
+    return col;
+}
+
+/**
+ * Adds the Laplacians of a single row and their squares to sum and sum_sq,
+ * returns the number of bytes done by the SSE2 loop, the caller does the
+ * remaining ones
+ */
+std::size_t laplacianRowSSE2(const uint8_t* center,
+                             const std::size_t& width,
+                             const std::size_t& dx,
+                             const std::size_t& row_offset,
+                             int64_t& sum,
+                             uint64_t& sum_sq)
+{
+    std::size_t col = 0;
+#ifdef __SSE2__
+    const uint8_t* up = center - row_offset;
+    const uint8_t* down = center + row_offset;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    while ( col + 16 <= width )
+    {
+        // |laplacian| <= 1020, hence each 32 bit lane of the squares gains
+        // at most 4 * 1020^2 per iteration, flush them every 256 iterations
+        __m128i acc_sum = zero;
+        __m128i acc_sq = zero;
+        const std::size_t block_end = std::min(width - width % 16, col + 256 * 16);
+        for ( ; col < block_end; col += 16 )
+        {
+            const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(center + col));
+            const __m128i u = _mm_loadu_si128(reinterpret_cast<const __m128i*>(up + col));
+            const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(down + col));
+            const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(center + col - dx));
+            const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(center + col + dx));
+            // low and high 8 bytes as 16 bit
+            const __m128i lap_lo = _mm_sub_epi16(
+                    _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(u, zero), _mm_unpacklo_epi8(d, zero)),
+                                  _mm_add_epi16(_mm_unpacklo_epi8(l, zero), _mm_unpacklo_epi8(r, zero))),
+                    _mm_slli_epi16(_mm_unpacklo_epi8(c, zero), 2));
+            const __m128i lap_hi = _mm_sub_epi16(
+                    _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(u, zero), _mm_unpackhi_epi8(d, zero)),
+                                  _mm_add_epi16(_mm_unpackhi_epi8(l, zero), _mm_unpackhi_epi8(r, zero))),
+                    _mm_slli_epi16(_mm_unpackhi_epi8(c, zero), 2));
+            acc_sum = _mm_add_epi32(acc_sum, _mm_madd_epi16(lap_lo, ones));
+            acc_sum = _mm_add_epi32(acc_sum, _mm_madd_epi16(lap_hi, ones));
+            acc_sq = _mm_add_epi32(acc_sq, _mm_madd_epi16(lap_lo, lap_lo));
+            acc_sq = _mm_add_epi32(acc_sq, _mm_madd_epi16(lap_hi, lap_hi));
+        }
+        int32_t sums[4];
+        uint32_t squares[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(sums), acc_sum);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(squares), acc_sq);
+        for ( int i = 0; i < 4; ++i )
+        {
+            sum += sums[i];
+            sum_sq += squares[i];
+        }
+    }
+#endif
+    return col;
+}
+
+/**
+ * Returns the sum of absolute differences of a single row in sad and the
+ * number of bytes done by the SSE2 loop, the caller does the remaining ones
+ */
+std::size_t absDiffRowSSE2(const uint8_t* a,
+                           const uint8_t* b,
+                           const std::size_t& row_bytes,
+                           uint64_t& sad)
+{
+    std::size_t col = 0;
+#ifdef __SSE2__
+    // psadbw sums 8 bytes each into the two 64 bit lanes
+    __m128i acc = _mm_setzero_si128();
+    for ( ; col + 16 <= row_bytes; col += 16 )
+    {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + col));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + col));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    sad += lanes[0] + lanes[1];
+#endif
+    return col;
+}
+
+/**
+ * Adds the bytes of a row to the 32 bit sums, returns the number of bytes
+ * done by the SSE2 loop, the caller does the remaining ones
+ */
+std::size_t addRowSSE2(const uint8_t* row,
+                       const std::size_t& num_bytes,
+                       uint32_t* sums)
+{
+    std::size_t col = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for ( ; col + 16 <= num_bytes; col += 16 )
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + col));
+        const __m128i words[2] = { _mm_unpacklo_epi8(bytes, zero),
+                                   _mm_unpackhi_epi8(bytes, zero) };
+        for ( int i = 0; i < 2; ++i )
+        {
+            __m128i* lo = reinterpret_cast<__m128i*>(sums + col + 8 * i);
+            __m128i* hi = reinterpret_cast<__m128i*>(sums + col + 8 * i + 4);
+            _mm_storeu_si128(lo, _mm_add_epi32(_mm_loadu_si128(lo),
+                                               _mm_unpacklo_epi16(words[i], zero)));
+            _mm_storeu_si128(hi, _mm_add_epi32(_mm_loadu_si128(hi),
+                                               _mm_unpackhi_epi16(words[i], zero)));
+        }
+    }
+#endif
+    return col;
+}
+
+}  // namespace
+
+void setupSamplingIndices(std::vector<std::size_t>& indices,
+                          const std::size_t& rows,
+                          const std::size_t& cols,
+                          const int& downsampling_factor)
+{
+    indices.clear();
+    std::size_t min_window_height = static_cast<float>(rows) /
+                                    static_cast<float>(downsampling_factor);
+    cv::Point2i start_pt(0, 0);
+    cv::Point2i end_pt(cols, rows);
+    // add the iamge center point only once
+    indices.push_back(0.5 * rows * cols);
+    genSamplingIndicesRec(indices,
+                          min_window_height,
+                          cols,
+                          start_pt,
+                          end_pt);
+    std::sort(indices.begin(), indices.end());
+    return;
+}
+
+void genSamplingIndicesRec(std::vector<std::size_t>& indices,
+                           const std::size_t& min_window_height,
+                           const std::size_t& cols,
+                           const cv::Point2i& s,   // start
+                           const cv::Point2i& e)   // end
+{
+    if ( static_cast<std::size_t>(std::abs(e.y - s.y)) <= min_window_height )
+    {
+        return;  // abort criteria -> shrinked window has the min_col_size
+    }
+    /*
+     * sampled img:      point:                             idx:
+     * s 0 0 0 0 0 0  a) [(e.x-s.x)*0.5, (e.y-s.y)*0.5]     a.x*a.y*0.5
+     * 0 0 0 d 0 0 0  b) [a.x,           1.5*a.y]           b.y*img_rows+b.x
+     * 0 0 0 0 0 0 0  c) [0.5*a.x,       a.y]               c.y*img_rows+c.x
+     * 0 c 0 a 0 f 0  d) [a.x,           0.5*a.y]           d.y*img_rows+d.x
+     * 0 0 0 0 0 0 0  f) [1.5*a.x,       a.y]               f.y*img_rows+f.x
+     * 0 0 0 b 0 0 0
+     * 0 0 0 0 0 0 e
+     */
+    cv::Point2i a, b, c, d, f, delta;
+    a = s + 0.5 * (e - s);  // center point
+    delta = 0.5 * (e - s);
+    b = s + cv::Point2i(delta.x,       1.5 * delta.y);
+    c = s + cv::Point2i(0.5 * delta.x, delta.y);
+    d = s + cv::Point2i(delta.x,       0.5 * delta.y);
+    f = s + cv::Point2i(1.5 * delta.x, delta.y);
+    indices.push_back(b.y * cols + b.x);
+    indices.push_back(c.y * cols + c.x);
+    indices.push_back(d.y * cols + d.x);
+    indices.push_back(f.y * cols + f.x);
+    genSamplingIndicesRec(indices, min_window_height, cols, s, a);
+    genSamplingIndicesRec(indices, min_window_height, cols, a, e);
+    genSamplingIndicesRec(indices, min_window_height, cols, cv::Point2i(s.x, a.y), cv::Point2i(a.x, e.y));
+    genSamplingIndicesRec(indices, min_window_height, cols, cv::Point2i(a.x, s.y), cv::Point2i(e.x, a.y));
+    return;
+}
+
+void setupWeightedSamplingIndices(std::vector<std::size_t>& indices,
+                                  std::vector<float>& weights,
+                                  const std::size_t& rows,
+                                  const std::size_t& cols,
+                                  const std::size_t& bytes_per_pixel,
+                                  const int& downsampling_factor,
+                                  const std::vector<cv::Rect>& regions,
+                                  const std::vector<float>& region_weights,
+                                  const float& background_weight)
+{
+    indices.clear();
+    weights.clear();
+
+    const cv::Rect image(0, 0, cols, rows);
+    const std::size_t num_regions = std::min(regions.size(), region_weights.size());
+
+    // (pixel index, weight)
+    std::vector<std::pair<std::size_t, float> > samples;
+    std::vector<std::size_t> pixels;
+    if ( background_weight > 0.0 )
+    {
+        setupSamplingIndices(pixels, rows, cols, downsampling_factor);
+        for ( const std::size_t& idx : pixels )
+        {
+            const cv::Point pixel(idx % cols, idx / cols);
+            bool in_region = false;
+            for ( std::size_t i = 0; i < num_regions && !in_region; ++i )
+            {
+                in_region = regions[i].contains(pixel);
+            }
+            if ( !in_region )
+            {
+                samples.push_back(std::make_pair(idx, background_weight));
+            }
+        }
+    }
+
+    // the regions are sampled as dense as the whole image, i.e. the
+    // recursion stops at the same window height
+    const std::size_t min_window_height = static_cast<float>(rows) /
+                                          static_cast<float>(downsampling_factor);
+    for ( std::size_t i = 0; i < num_regions; ++i )
+    {
+        const cv::Rect region = regions[i] & image;
+        if ( region.area() <= 0 || region_weights[i] <= 0.0 )
+        {
+            continue;
+        }
+        pixels.clear();
+        // the region center once, then the same pattern as for the image
+        pixels.push_back((region.y + region.height / 2) * cols +
+                         region.x + region.width / 2);
+        genSamplingIndicesRec(pixels,
+                              min_window_height,
+                              cols,
+                              region.tl(),
+                              region.br());
+        for ( const std::size_t& idx : pixels )
+        {
+            samples.push_back(std::make_pair(idx, region_weights[i]));
+        }
+    }
+
+    // merge duplicates, keeping the largest weight
+    std::sort(samples.begin(), samples.end());
+    for ( std::size_t i = 0; i < samples.size(); ++i )
+    {
+        if ( i + 1 < samples.size() && samples[i + 1].first == samples[i].first )
+        {
+            continue;
+        }
+        for ( std::size_t byte = 0; byte < bytes_per_pixel; ++byte )
+        {
+            indices.push_back(samples[i].first * bytes_per_pixel + byte);
+            weights.push_back(samples[i].second);
+        }
+    }
+}
+
+float sampledMean(const std::vector<uint8_t>& data,
+                  const std::vector<std::size_t>& indices)
+{
+    // the indices are sorted, the last one is the largest
+    if ( indices.empty() || indices.back() >= data.size() )
+    {
+        return 0.0;
+    }
+    uint64_t sum = 0;
+    for ( const std::size_t& idx : indices )
+    {
+        sum += data[idx];
+    }
+    return static_cast<float>(sum) / static_cast<float>(indices.size());
+}
+
+float mean(const std::vector<uint8_t>& data)
+{
+    if ( data.empty() )
+    {
+        return 0.0;
+    }
+    // 64 bit accumulator: a 32 bit sum overflows after 16.8 M bytes of 255,
+    // i.e. for bright images > 16 MB
+    uint64_t sum = 0;
+    for ( const uint8_t& value : data )
+    {
+        sum += value;
+    }
+    return static_cast<float>(sum) / static_cast<float>(data.size());
+}
+
+std::size_t decimatedLength(const std::size_t& length,
+                            const std::size_t& cell_size,
+                            const std::size_t& decimation)
+{
+    return length / (cell_size * decimation) * cell_size;
+}
+
+void decimate(const uint8_t* src,
+              const std::size_t& rows,
+              const std::size_t& cols,
+              const std::size_t& bytes_per_pixel,
+              const std::size_t& cell_size,
+              const std::size_t& decimation_x,
+              const std::size_t& decimation_y,
+              uint8_t* dst)
+{
+    const std::size_t out_rows = decimatedLength(rows, cell_size, decimation_y);
+    // the cells of a row are decimated like pixels of cell_size pixels
+    const std::size_t cell_bytes = cell_size * bytes_per_pixel;
+    const std::size_t out_cells = cols / (cell_size * decimation_x);
+    const std::size_t src_step = cols * bytes_per_pixel;
+    const std::size_t dst_step = out_cells * cell_bytes;
+    for ( std::size_t row = 0; row < out_rows; ++row )
+    {
+        // row % cell_size is the row within the cell
+        const std::size_t src_row_idx = (row / cell_size) * cell_size * decimation_y +
+                                        row % cell_size;
+        const uint8_t* src_row = src + src_row_idx * src_step;
+        uint8_t* dst_row = dst + row * dst_step;
+        if ( decimation_x == 1 )
+        {
+            std::memcpy(dst_row, src_row, dst_step);
+            continue;
+        }
+        std::size_t col = decimateRowSSE2(src_row,
+                                          out_cells,
+                                          cell_bytes,
+                                          decimation_x,
+                                          dst_row);
+        for ( ; col < out_cells; ++col )
+        {
+            const uint8_t* src_cell = src_row + col * decimation_x * cell_bytes;
+            uint8_t* dst_cell = dst_row + col * cell_bytes;
+            for ( std::size_t byte = 0; byte < cell_bytes; ++byte )
+            {
+                dst_cell[byte] = src_cell[byte];
+            }
+        }
+    }
+}
+
+float weightedSampledMean(const std::vector<uint8_t>& data,
+                          const std::vector<std::size_t>& indices,
+                          const std::vector<float>& weights)
+{
+    // the indices are sorted, the last one is the largest
+    if ( indices.empty() || indices.back() >= data.size() )
+    {
+        return 0.0;
+    }
+    float sum = 0.0;
+    float weight_sum = 0.0;
+    for ( std::size_t i = 0; i < indices.size(); ++i )
+    {
+        sum += weights[i] * data[indices[i]];
+        weight_sum += weights[i];
+    }
+    if ( weight_sum <= 0.0 )
+    {
+        return 0.0;
+    }
+    return sum / weight_sum;
+}
+
+double laplacianVariance(const uint8_t* data,
+                         const std::size_t& rows,
+                         const std::size_t& row_bytes,
+                         const cv::Rect& roi,
+                         const std::size_t& dx,
+                         const std::size_t& dy,
+                         const std::size_t& row_step)
+{
+    if ( rows <= 2 * dy || row_bytes <= 2 * dx )
+    {
+        return 0.0;
+    }
+    const cv::Rect valid(dx, dy, row_bytes - 2 * dx, rows - 2 * dy);
+    const cv::Rect area = roi & valid;
+    if ( area.area() <= 0 )
+    {
+        return 0.0;
+    }
+
+    const std::size_t width = area.width;
+    const std::size_t row_offset = dy * row_bytes;
+    int64_t sum = 0;
+    uint64_t sum_sq = 0;
+    uint64_t count = 0;
+    for ( std::size_t row = area.y; row < static_cast<std::size_t>(area.br().y); row += row_step )
+    {
+        const uint8_t* center = data + row * row_bytes + area.x;
+        std::size_t col = laplacianRowSSE2(center, width, dx, row_offset, sum, sum_sq);
+        for ( ; col < width; ++col )
+        {
+            const int laplacian = center[col - row_offset] + center[col + row_offset] +
+                                  center[col - dx] + center[col + dx] - 4 * center[col];
+            sum += laplacian;
+            sum_sq += laplacian * laplacian;
+        }
+        count += width;
+    }
+    const double mean = static_cast<double>(sum) / static_cast<double>(count);
+    return static_cast<double>(sum_sq) / static_cast<double>(count) - mean * mean;
+}
+
+void copySampledRows(const uint8_t* data,
+                     const std::size_t& rows,
+                     const std::size_t& row_bytes,
+                     const std::size_t& row_step,
+                     std::vector<uint8_t>& reference)
+{
+    const std::size_t sampled_rows = (rows + row_step - 1) / row_step;
+    reference.resize(sampled_rows * row_bytes);
+    for ( std::size_t i = 0; i < sampled_rows; ++i )
+    {
+        std::memcpy(&reference[i * row_bytes], data + i * row_step * row_bytes, row_bytes);
+    }
+}
+
+float sampledRowsMeanAbsDiff(const uint8_t* data,
+                             const std::size_t& rows,
+                             const std::size_t& row_bytes,
+                             const std::size_t& row_step,
+                             const std::vector<uint8_t>& reference)
+{
+    const std::size_t sampled_rows = (rows + row_step - 1) / row_step;
+    if ( sampled_rows == 0 || row_bytes == 0 )
+    {
+        return 0.0;
+    }
+    uint64_t sad = 0;
+    for ( std::size_t i = 0; i < sampled_rows; ++i )
+    {
+        const uint8_t* row = data + i * row_step * row_bytes;
+        const uint8_t* ref = &reference[i * row_bytes];
+        std::size_t col = absDiffRowSSE2(row, ref, row_bytes, sad);
+        for ( ; col < row_bytes; ++col )
+        {
+            sad += row[col] > ref[col] ? row[col] - ref[col] : ref[col] - row[col];
+        }
+    }
+    return static_cast<float>(sad) / static_cast<float>(sampled_rows * row_bytes);
+}
+
+void boxDownscale(const uint8_t* src,
+                  const std::size_t& rows,
+                  const std::size_t& cols,
+                  const std::size_t& channels,
+                  const std::size_t& factor,
+                  std::vector<uint32_t>& column_sums,
+                  uint8_t* dst)
+{
+    const std::size_t out_rows = rows / factor;
+    const std::size_t out_cols = cols / factor;
+    const std::size_t src_step = cols * channels;
+    const std::size_t used_bytes = out_cols * factor * channels;
+    const uint32_t area = factor * factor;
+    column_sums.resize(used_bytes);
+    for ( std::size_t out_row = 0; out_row < out_rows; ++out_row )
+    {
+        std::fill(column_sums.begin(), column_sums.end(), 0);
+        for ( std::size_t k = 0; k < factor; ++k )
+        {
+            const uint8_t* row = src + (out_row * factor + k) * src_step;
+            std::size_t col = addRowSSE2(row, used_bytes, column_sums.data());
+            for ( ; col < used_bytes; ++col )
+            {
+                column_sums[col] += row[col];
+            }
+        }
+        uint8_t* dst_row = dst + out_row * out_cols * channels;
+        for ( std::size_t out_col = 0; out_col < out_cols; ++out_col )
+        {
+            const uint32_t* block = &column_sums[out_col * factor * channels];
+            for ( std::size_t ch = 0; ch < channels; ++ch )
+            {
+                uint32_t sum = 0;
+                for ( std::size_t j = 0; j < factor; ++j )
+                {
+                    sum += block[j * channels + ch];
+                }
+                dst_row[out_col * channels + ch] = static_cast<uint8_t>((sum + area / 2) / area);
+            }
+        }
+    }
+}
+
+}  // namespace image_kernels
+}  // namespace pylon_camera
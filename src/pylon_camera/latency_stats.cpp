@@ -0,0 +1,193 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/latency_stats.h>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace pylon_camera
+{
+
+const uint64_t LatencyHistogram::SUB_BUCKET_BITS;
+const uint64_t LatencyHistogram::SUB_BUCKETS;
+const uint64_t LatencyHistogram::MAX_VALUE_BITS;
+const uint64_t LatencyHistogram::NUM_BUCKETS;
+
+LatencyHistogram::LatencyHistogram()
+    : count_(0),
+      sum_(0),
+      min_(std::numeric_limits<uint64_t>::max()),
+      max_(0)
+{
+    for ( std::size_t i = 0; i < buckets_.size(); ++i )
+    {
+        buckets_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+std::size_t LatencyHistogram::bucketIndex(const uint64_t& value_ns)
+{
+    const uint64_t value = std::min(value_ns, (uint64_t(1) << MAX_VALUE_BITS) - 1);
+    if ( value < 2 * SUB_BUCKETS )
+    {
+        return value;
+    }
+    // position of the most significant bit, value >> shift lies in
+    // [SUB_BUCKETS, 2 * SUB_BUCKETS)
+    const uint64_t msb = 63 - __builtin_clzll(value);
+    const uint64_t shift = msb - SUB_BUCKET_BITS;
+    return shift * SUB_BUCKETS + (value >> shift);
+}
+
+uint64_t LatencyHistogram::bucketLowerBound(const std::size_t& index)
+{
+    if ( index < 2 * SUB_BUCKETS )
+    {
+        return index;
+    }
+    const uint64_t shift = index / SUB_BUCKETS - 1;
+    const uint64_t sub = index - shift * SUB_BUCKETS;
+    return sub << shift;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(const std::size_t& index)
+{
+    if ( index < 2 * SUB_BUCKETS )
+    {
+        return index;
+    }
+    const uint64_t shift = index / SUB_BUCKETS - 1;
+    const uint64_t sub = index - shift * SUB_BUCKETS;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(const uint64_t& value_ns)
+{
+    buckets_[bucketIndex(value_ns)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value_ns, std::memory_order_relaxed);
+
+    uint64_t cur_min = min_.load(std::memory_order_relaxed);
+    while ( value_ns < cur_min &&
+            !min_.compare_exchange_weak(cur_min, value_ns, std::memory_order_relaxed) )
+    {
+    }
+    uint64_t cur_max = max_.load(std::memory_order_relaxed);
+    while ( value_ns > cur_max &&
+            !max_.compare_exchange_weak(cur_max, value_ns, std::memory_order_relaxed) )
+    {
+    }
+}
+
+LatencySummary LatencyHistogram::snapshotAndReset()
+{
+    // the single fields are reset independently, values recorded concurrently
+    // might hence be attributed to different periods, which is negligible
+    std::vector<uint64_t> counts(NUM_BUCKETS, 0);
+    uint64_t total = 0;
+    for ( std::size_t i = 0; i < NUM_BUCKETS; ++i )
+    {
+        counts[i] = buckets_[i].exchange(0, std::memory_order_relaxed);
+        total += counts[i];
+    }
+    count_.exchange(0, std::memory_order_relaxed);
+    const uint64_t sum = sum_.exchange(0, std::memory_order_relaxed);
+    const uint64_t min = min_.exchange(std::numeric_limits<uint64_t>::max(),
+                                       std::memory_order_relaxed);
+    const uint64_t max = max_.exchange(0, std::memory_order_relaxed);
+
+    LatencySummary summary;
+    summary.count = total;
+    if ( total == 0 )
+    {
+        summary.mean = 0.0;
+        summary.min = summary.max = 0;
+        summary.p50 = summary.p90 = summary.p99 = summary.p999 = 0;
+        return summary;
+    }
+    summary.mean = static_cast<double>(sum) / static_cast<double>(total);
+    summary.min = min;
+    summary.max = max;
+
+    const double quantiles[4] = { 0.5, 0.9, 0.99, 0.999 };
+    uint64_t* targets[4] = { &summary.p50, &summary.p90, &summary.p99, &summary.p999 };
+    std::size_t q = 0;
+    uint64_t cumulated = 0;
+    for ( std::size_t i = 0; i < NUM_BUCKETS && q < 4; ++i )
+    {
+        cumulated += counts[i];
+        while ( q < 4 && cumulated >= quantiles[q] * total )
+        {
+            // upper bound of the bucket, but never more than the real maximum
+            *targets[q] = std::min(bucketUpperBound(i), max);
+            ++q;
+        }
+    }
+    return summary;
+}
+
+LatencyStats::LatencyStats()
+    : histograms_()
+{}
+
+LatencyStats::~LatencyStats()
+{}
+
+LatencyHistogram& LatencyStats::histogram(const LATENCY_STAGE& stage)
+{
+    return histograms_.at(stage);
+}
+
+std::string LatencyStats::stageName(const LATENCY_STAGE& stage)
+{
+    switch ( stage )
+    {
+        case LS_TRIGGER_WAIT:
+            return "trigger_wait";
+        case LS_RETRIEVE:
+            return "retrieve";
+        case LS_COPY:
+            return "copy";
+        case LS_CONVERT:
+            return "convert";
+        case LS_RECTIFY:
+            return "rectify";
+        case LS_PUBLISH:
+            return "publish";
+        case LS_SCHEDULING:
+            return "scheduling";
+        case LS_TRIGGERED:
+            return "triggered";
+        default:
+            return "unknown";
+    }
+}
+
+}  // namespace pylon_camera
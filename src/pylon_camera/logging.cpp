@@ -0,0 +1,277 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/logging.h>
+#include <pylon_camera/realtime.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace pylon_camera
+{
+
+namespace
+{
+
+class StderrLogSink : public LogSink
+{
+public:
+    virtual void log(const LOG_LEVEL& level, const std::string& msg)
+    {
+        static const char* const LEVEL_NAMES[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+        // a single write per message, such that lines of concurrent
+        // messages don't interleave
+        std::cerr << std::string("[") + LEVEL_NAMES[level] + "] [pylon_camera] " + msg + "\n";
+    }
+};
+
+StderrLogSink default_sink;
+std::atomic<LogSink*> sink(&default_sink);
+std::atomic<int> min_level(LL_INFO);
+
+int64_t steadyNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Bounded lock-free multi-producer queue (after D. Vyukov), drained by a
+ * background thread which forwards the messages to the sink. The producers
+ * never block and never allocate.
+ */
+class AsyncLogQueue
+{
+public:
+    AsyncLogQueue()
+        : enqueue_pos_(0)
+        , dequeue_pos_(0)
+        , dropped_(0)
+        , running_(true)
+        , wake_mutex_()
+        , wake_()
+        , worker_()
+    {
+        for ( std::size_t i = 0; i < CAPACITY; ++i )
+        {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        worker_ = std::thread(&AsyncLogQueue::run, this);
+    }
+
+    ~AsyncLogQueue()
+    {
+        running_.store(false);
+        wake_.notify_one();
+        worker_.join();
+    }
+
+    void push(const LOG_LEVEL& level, const std::string& msg)
+    {
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        while ( true )
+        {
+            slot = &slots_[pos % CAPACITY];
+            const std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if ( diff == 0 )
+            {
+                if ( enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                                        std::memory_order_relaxed) )
+                {
+                    break;
+                }
+            }
+            else if ( diff < 0 )
+            {
+                // full
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            else
+            {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->level = level;
+        slot->length = std::min(msg.size(), LOG_ASYNC_MAX_LENGTH);
+        std::memcpy(slot->text, msg.data(), slot->length);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        // without the mutex, a wake-up might get lost, which only delays
+        // the message until the next poll
+        wake_.notify_one();
+    }
+
+private:
+    static const std::size_t CAPACITY = 256;
+
+    struct Slot
+    {
+        std::atomic<std::size_t> sequence;
+        LOG_LEVEL level;
+        std::size_t length;
+        char text[LOG_ASYNC_MAX_LENGTH];
+    };
+
+    bool pop(LOG_LEVEL& level, std::string& msg)
+    {
+        const std::size_t pos = dequeue_pos_;
+        Slot& slot = slots_[pos % CAPACITY];
+        if ( slot.sequence.load(std::memory_order_acquire) != pos + 1 )
+        {
+            return false;
+        }
+        level = slot.level;
+        msg.assign(slot.text, slot.length);
+        slot.sequence.store(pos + CAPACITY, std::memory_order_release);
+        dequeue_pos_ = pos + 1;
+        return true;
+    }
+
+    void run()
+    {
+        // a queue created by the real-time acquisition thread would inherit
+        // its SCHED_FIFO policy and CPU pinning, the logging must not compete
+        // with it
+        realtime::setThreadPriority(0);
+        realtime::unpinThread();
+
+        LOG_LEVEL level;
+        std::string msg;
+        msg.reserve(LOG_ASYNC_MAX_LENGTH);
+        bool running = true;
+        while ( running )
+        {
+            // drain once more after the stop was requested
+            running = running_.load();
+            while ( pop(level, msg) )
+            {
+                logMessage(level, msg);
+            }
+            const uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+            if ( dropped > 0 )
+            {
+                logMessage(LL_WARN, std::to_string(dropped)
+                           + " log message(s) dropped, the log queue was full");
+            }
+            if ( running )
+            {
+                std::unique_lock<std::mutex> lock(wake_mutex_);
+                wake_.wait_for(lock, std::chrono::milliseconds(50));
+            }
+        }
+    }
+
+    std::array<Slot, CAPACITY> slots_;
+    std::atomic<std::size_t> enqueue_pos_;
+    // only used by the worker
+    std::size_t dequeue_pos_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<bool> running_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::thread worker_;
+};
+
+AsyncLogQueue& asyncLogQueue()
+{
+    // started by setLogSink() or the first asynchronous message, stopped at
+    // exit before the sinks which have been installed earlier are destroyed
+    static AsyncLogQueue queue;
+    return queue;
+}
+
+}  // namespace
+
+LogSink::~LogSink()
+{}
+
+void setLogSink(LogSink* new_sink)
+{
+    sink.store(new_sink != nullptr ? new_sink : &default_sink);
+    // start the worker now, usually before the real-time setup of the
+    // acquisition thread
+    asyncLogQueue();
+}
+
+void setLogLevel(const LOG_LEVEL& level)
+{
+    min_level.store(level, std::memory_order_relaxed);
+}
+
+bool isLogLevelEnabled(const LOG_LEVEL& level)
+{
+    return level >= min_level.load(std::memory_order_relaxed);
+}
+
+void logMessage(const LOG_LEVEL& level, const std::string& msg)
+{
+    sink.load()->log(level, msg);
+}
+
+bool logThrottlePassed(std::atomic<int64_t>& last_ns, const double& period_s)
+{
+    const int64_t now_ns = steadyNowNs();
+    int64_t last = last_ns.load(std::memory_order_relaxed);
+    if ( last != 0 && now_ns - last < static_cast<int64_t>(period_s * 1e9) )
+    {
+        return false;
+    }
+    // only one of several concurrent callers wins the slot
+    return last_ns.compare_exchange_strong(last, now_ns);
+}
+
+void logMessageAsync(const LOG_LEVEL& level, const std::string& msg)
+{
+    asyncLogQueue().push(level, msg);
+}
+
+LogSite::LogSite()
+    : last_ns(0)
+    , suppressed(0)
+{}
+
+bool logSitePassed(LogSite& site, const double& period_s, uint64_t& suppressed)
+{
+    if ( !logThrottlePassed(site.last_ns, period_s) )
+    {
+        site.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+}  // namespace pylon_camera
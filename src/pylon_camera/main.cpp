@@ -35,6 +35,7 @@
 #include <ros/ros.h>
 #include <boost/thread.hpp>
 #include <pylon_camera/pylon_camera_node.h>
+#include <pylon_camera/realtime.h>
 
 
 int main(int argc, char **argv)
@@ -43,7 +44,7 @@ int main(int argc, char **argv)
 
     pylon_camera::PylonCameraNode pylon_camera_node;
 
-    ros::Rate r(pylon_camera_node.frameRate());
+    double frame_rate = pylon_camera_node.frameRate();
 
     ROS_INFO_STREAM("Start image grabbing if node connects to topic with "
         << "a frame_rate of: " << pylon_camera_node.frameRate() << " Hz");
@@ -51,10 +52,25 @@ int main(int argc, char **argv)
     // Main thread and brightness-service thread
     boost::thread th(boost::bind(&ros::spin));
 
+    // only the main thread, which acquires the images, runs with real-time
+    // priority, hence after the spinner thread has been started
+    pylon_camera_node.setupAcquisitionThread();
+    pylon_camera::realtime::CycleTimer cycle_timer(frame_rate);
+
     while ( ros::ok() )
     {
         pylon_camera_node.spin();
-        r.sleep();
+        // the frame rate might have been changed by dynamic_reconfigure
+        if ( pylon_camera_node.frameRate() != frame_rate )
+        {
+            frame_rate = pylon_camera_node.frameRate();
+            cycle_timer.setRate(frame_rate);
+        }
+        uint64_t latency_ns = 0;
+        if ( cycle_timer.sleep(latency_ns) )
+        {
+            pylon_camera_node.recordSchedulingLatency(latency_ns);
+        }
     }
 
     ROS_INFO("Terminate PylonCameraNode");
@@ -0,0 +1,149 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/preview_publisher.h>
+#include <pylon_camera/image_kernels.h>
+#include <sensor_msgs/image_encodings.h>
+#include <algorithm>
+#include <string>
+
+namespace pylon_camera
+{
+
+PreviewPublisher::PreviewPublisher(image_transport::ImageTransport& it,
+                                   const std::string& topic,
+                                   const int& max_width,
+                                   const double& rate)
+    : pub_(it.advertise(topic, 1))
+    , max_width_(std::max(max_width, 1))
+    , period_(1.0 / rate)
+    , last_stamp_()
+    , scaled_()
+    , column_sums_()
+    , mutex_()
+    , cond_()
+    , pending_()
+    , has_pending_(false)
+    , shutdown_(false)
+    , thread_(&PreviewPublisher::run, this)
+{}
+
+PreviewPublisher::~PreviewPublisher()
+{
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        shutdown_ = true;
+    }
+    cond_.notify_one();
+    thread_.join();
+}
+
+uint32_t PreviewPublisher::getNumSubscribers() const
+{
+    return pub_.getNumSubscribers();
+}
+
+void PreviewPublisher::push(const sensor_msgs::Image& image)
+{
+    if ( pub_.getNumSubscribers() == 0 ||
+         ( !last_stamp_.isZero() && image.header.stamp < last_stamp_ + period_ ) )
+    {
+        return;
+    }
+
+    namespace enc = sensor_msgs::image_encodings;
+    if ( enc::bitDepth(image.encoding) != 8 || image.encoding == enc::YUV422 )
+    {
+        ROS_WARN_STREAM_ONCE("The preview does not support the encoding "
+                << image.encoding);
+        return;
+    }
+    const bool bayer = enc::isBayer(image.encoding);
+    const std::size_t channels = enc::numChannels(image.encoding);
+    std::size_t factor = (image.width + max_width_ - 1) / max_width_;
+    if ( bayer )
+    {
+        // even factors average whole Bayer cells into gray
+        factor += factor % 2;
+    }
+    factor = std::max<std::size_t>(factor, 1);
+    if ( image.height < factor || image.width < factor )
+    {
+        // an empty preview is of no use to anyone
+        ROS_WARN_STREAM_ONCE("The image of " << image.width << " x " << image.height
+                << " pixels is too small for a preview");
+        return;
+    }
+
+    last_stamp_ = image.header.stamp;
+    scaled_.header = image.header;
+    scaled_.encoding = bayer ? enc::MONO8 : image.encoding;
+    scaled_.is_bigendian = image.is_bigendian;
+    scaled_.height = image.height / factor;
+    scaled_.width = image.width / factor;
+    scaled_.step = scaled_.width * channels;
+    scaled_.data.resize(scaled_.step * scaled_.height);
+    image_kernels::boxDownscale(image.data.data(),
+                                image.height,
+                                image.width,
+                                channels,
+                                factor,
+                                column_sums_,
+                                scaled_.data.data());
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        std::swap(scaled_, pending_);
+        has_pending_ = true;
+    }
+    cond_.notify_one();
+}
+
+void PreviewPublisher::run()
+{
+    sensor_msgs::Image preview;
+    while ( true )
+    {
+        {
+            boost::unique_lock<boost::mutex> lock(mutex_);
+            while ( !has_pending_ && !shutdown_ )
+            {
+                cond_.wait(lock);
+            }
+            if ( shutdown_ )
+            {
+                return;
+            }
+            std::swap(preview, pending_);
+            has_pending_ = false;
+        }
+        pub_.publish(preview);
+    }
+}
+
+}  // namespace pylon_camera
@@ -0,0 +1,132 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/publisher_queue_monitor.h>
+#include <ros/topic_manager.h>
+#include <ros/publication.h>
+#include <string>
+
+namespace pylon_camera
+{
+
+PublisherQueueMonitor::PublisherQueueMonitor(const std::string& topic,
+                                             const uint32_t& queue_size)
+    : topic_(topic)
+    , queue_size_(queue_size)
+    , num_published_(0)
+    , subscribers_()
+{}
+
+PublisherQueueMonitor::~PublisherQueueMonitor()
+{}
+
+void PublisherQueueMonitor::published()
+{
+    num_published_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PublisherQueueMonitor::update()
+{
+    std::map<int, SubscriberQueue> subscribers;
+
+    ros::PublicationPtr publication = ros::TopicManager::instance()->lookupPublication(topic_);
+    if ( publication )
+    {
+        try
+        {
+            // info: [[connection_id, destination_caller_id, direction, transport, topic, ...], ...]
+            XmlRpc::XmlRpcValue info;
+            info.setSize(0);
+            publication->getInfo(info);
+            std::map<int, std::string> caller_ids;
+            for ( int i = 0; i < info.size(); ++i )
+            {
+                caller_ids[static_cast<int>(info[i][0])] = static_cast<std::string>(info[i][1]);
+            }
+
+            // stats: [topic, [[connection_id, bytes_sent, data_sent, messages_sent, connected], ...]]
+            // messages_sent is incremented on enqueue, also if an older
+            // message is pushed out of the full queue
+            XmlRpc::XmlRpcValue stats;
+            publication->getStats(stats);
+            XmlRpc::XmlRpcValue& links = stats[1];
+            for ( int i = 0; i < links.size(); ++i )
+            {
+                int connection_id = static_cast<int>(links[i][0]);
+                SubscriberQueue& queue = subscribers[connection_id];
+                queue.caller_id = caller_ids[connection_id];
+                // an XmlRpc int of 32 bit, it wraps after 2^32 messages
+                queue.enqueued = static_cast<uint32_t>(static_cast<int>(links[i][3]));
+            }
+        }
+        catch ( const XmlRpc::XmlRpcException& e )
+        {
+            ROS_DEBUG_STREAM("Unable to read the publication statistics of '"
+                    << topic_ << "': " << e.getMessage());
+            return;
+        }
+    }
+    subscribers_.swap(subscribers);
+}
+
+void PublisherQueueMonitor::fillStatus(diagnostic_msgs::DiagnosticStatus& status) const
+{
+    diagnostic_msgs::KeyValue kv;
+    kv.key = topic_ + " queue_size";
+    kv.value = std::to_string(queue_size_);
+    status.values.push_back(kv);
+
+    kv.key = topic_ + " published";
+    kv.value = std::to_string(numPublished());
+    status.values.push_back(kv);
+
+
+    for ( std::map<int, SubscriberQueue>::const_iterator it = subscribers_.begin();
+          it != subscribers_.end(); ++it )
+    {
+        const SubscriberQueue& queue = it->second;
+        std::string prefix = topic_ + " [" + queue.caller_id + "#"
+                           + std::to_string(it->first) + "] ";
+        kv.key = prefix + "enqueued";
+        kv.value = std::to_string(queue.enqueued);
+        status.values.push_back(kv);
+    }
+}
+
+const std::string& PublisherQueueMonitor::topic() const
+{
+    return topic_;
+}
+
+uint64_t PublisherQueueMonitor::numPublished() const
+{
+    return num_published_.load(std::memory_order_relaxed);
+}
+
+}  // namespace pylon_camera
@@ -28,6 +28,7 @@
  *****************************************************************************/
 
 #include <pylon_camera/internal/pylon_camera.h>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -42,17 +43,45 @@ enum PYLON_CAM_TYPE
     UNKNOWN = -1,
 };
 
+ImageGeometry::ImageGeometry()
+    : binning_x(1)
+    , binning_y(1)
+    , decimation_x(1)
+    , decimation_y(1)
+    , roi_offset_x(0)
+    , roi_offset_y(0)
+    , roi_width(0)
+    , roi_height(0)
+{}
+
 PylonCamera::PylonCamera()
     : device_user_id_("")
     , img_rows_(0)
     , img_cols_(0)
     , img_size_byte_(0)
+    , camera_img_rows_(0)
+    , camera_img_cols_(0)
+    , sw_decimation_x_(1)
+    , sw_decimation_y_(1)
+    , sw_decimation_cell_(1)
+    , bandwidth_limited_framerate_(-1.0)
     , grab_timeout_(-1.0)
     , is_ready_(false)
+    , is_warm_started_(false)
     , is_cam_removed_(false)
+    , is_grabbing_paused_(false)
     , is_binary_exposure_search_running_(false)
     , max_brightness_tolerance_(2.5)
     , binary_exp_search_(nullptr)
+    , latency_stats_(nullptr)
+    , grab_failures_(0)
+    , grab_timeouts_(0)
+    , incomplete_buffers_(0)
+    , lost_frames_(0)
+    , skipped_frames_(0)
+    , last_block_id_(0)
+    , last_block_id_valid_(false)
+    , frame_seq_(0)
 {}
 
 PYLON_CAM_TYPE detectPylonCamType(const Pylon::CDeviceInfo& device_info)
@@ -80,7 +109,7 @@ PYLON_CAM_TYPE detectPylonCamType(const Pylon::CDeviceInfo& device_info)
                 }
                 else
                 {
-                    ROS_ERROR_STREAM("Found 'BaslerUsb'-Camera, but it is neither "
+                    PYLON_CAMERA_ERROR_STREAM("Found 'BaslerUsb'-Camera, but it is neither "
                         << "a Dart, nor a USB-Camera. Up to now, other cameras are "
                         << "not supported by this pkg!");
                     return UNKNOWN;
@@ -88,14 +117,14 @@ PYLON_CAM_TYPE detectPylonCamType(const Pylon::CDeviceInfo& device_info)
             }
             else
             {
-                ROS_ERROR_STREAM("Error while detecting the pylon camera type from "
+                PYLON_CAMERA_ERROR_STREAM("Error while detecting the pylon camera type from "
                 << "its ModelName: Camera has no ModelName available!");
                 return UNKNOWN;
             }
         }
         else
         {
-            ROS_ERROR_STREAM("Detected Camera Type is neither 'BaslerUsb', nor "
+            PYLON_CAMERA_ERROR_STREAM("Detected Camera Type is neither 'BaslerUsb', nor "
                 << "'BaslerGigE'. Up to now, other cameras not supported by "
                 << "this pkg!");
             return UNKNOWN;
@@ -103,7 +132,7 @@ PYLON_CAM_TYPE detectPylonCamType(const Pylon::CDeviceInfo& device_info)
     }
     else
     {
-        ROS_ERROR_STREAM("Error while detecting the pylon camera type from "
+        PYLON_CAMERA_ERROR_STREAM("Error while detecting the pylon camera type from "
                 << "its DeviceClass: Camera has no DeviceClass available!");
         return UNKNOWN;
     }
@@ -139,7 +168,7 @@ PylonCamera* PylonCamera::create(const std::string& device_user_id_to_open)
         if ( 0 == tl_factory.EnumerateDevices(device_list) )
         {
             Pylon::PylonTerminate();
-            ROS_ERROR_ONCE("No camera present");
+            PYLON_CAMERA_ERROR_STREAM_ONCE("No camera present");
             return nullptr;
         }
         else
@@ -147,7 +176,7 @@ PylonCamera* PylonCamera::create(const std::string& device_user_id_to_open)
             Pylon::DeviceInfoList_t::const_iterator it;
             if ( device_user_id_to_open.empty() )
             {
-                ROS_INFO_STREAM("Found camera with DeviceUserID "
+                PYLON_CAMERA_INFO_STREAM("Found camera with DeviceUserID "
                             << device_list.front().GetUserDefinedName() << ": "
                             << device_list.front().GetModelName());
                 PYLON_CAM_TYPE cam_type = detectPylonCamType(device_list.front());
@@ -173,7 +202,7 @@ PylonCamera* PylonCamera::create(const std::string& device_user_id_to_open)
             }
             if ( found_desired_device )
             {
-                ROS_INFO_STREAM("Found the desired camera with DeviceUserID "
+                PYLON_CAMERA_INFO_STREAM("Found the desired camera with DeviceUserID "
                             << device_user_id_to_open << ": "
                             << it->GetModelName());
                 PYLON_CAM_TYPE cam_type = detectPylonCamType(*it);
@@ -182,7 +211,7 @@ PylonCamera* PylonCamera::create(const std::string& device_user_id_to_open)
             }
             else
             {
-                ROS_ERROR_STREAM("Couldn't find the camera, that matches the "
+                PYLON_CAMERA_ERROR_STREAM("Couldn't find the camera, that matches the "
                     << "given DeviceUserID: " << device_user_id_to_open << "!\r\n"
                     << "Maybe it's wrong or has not yet been written to the "
                     << "camera?!");
@@ -192,7 +221,7 @@ PylonCamera* PylonCamera::create(const std::string& device_user_id_to_open)
     }
     catch ( GenICam::GenericException &e )
     {
-        ROS_ERROR_STREAM("An exception while opening the desired camera with "
+        PYLON_CAMERA_ERROR_STREAM("An exception while opening the desired camera with "
             << "DeviceUserID: " << device_user_id_to_open << " occurred: \r\n"
             << e.GetDescription());
         return nullptr;
@@ -214,6 +243,16 @@ const size_t& PylonCamera::imageCols() const
     return img_cols_;
 }
 
+const size_t& PylonCamera::softwareDecimationX() const
+{
+    return sw_decimation_x_;
+}
+
+const size_t& PylonCamera::softwareDecimationY() const
+{
+    return sw_decimation_y_;
+}
+
 const size_t& PylonCamera::imageSize() const
 {
     return img_size_byte_;
@@ -234,6 +273,11 @@ const bool& PylonCamera::isReady() const
     return is_ready_;
 }
 
+const bool& PylonCamera::isWarmStarted() const
+{
+    return is_warm_started_;
+}
+
 std::size_t PylonCamera::numUserOutputs() const
 {
     return user_output_selector_enums_.size();
@@ -244,6 +288,96 @@ const std::vector<float>& PylonCamera::sequencerExposureTimes() const
     return seq_exp_times_;
 }
 
+void PylonCamera::setLatencyStats(LatencyStats* latency_stats)
+{
+    latency_stats_ = latency_stats;
+}
+
+uint64_t PylonCamera::numGrabFailures() const
+{
+    return grab_failures_.load(std::memory_order_relaxed);
+}
+
+uint64_t PylonCamera::numGrabTimeouts() const
+{
+    return grab_timeouts_.load(std::memory_order_relaxed);
+}
+
+uint64_t PylonCamera::numIncompleteBuffers() const
+{
+    return incomplete_buffers_.load(std::memory_order_relaxed);
+}
+
+uint64_t PylonCamera::numLostFrames() const
+{
+    return lost_frames_.load(std::memory_order_relaxed);
+}
+
+uint64_t PylonCamera::numSkippedFrames() const
+{
+    return skipped_frames_.load(std::memory_order_relaxed);
+}
+
+uint64_t PylonCamera::frameSequence() const
+{
+    return frame_seq_;
+}
+
+void PylonCamera::trackFrame(const uint64_t& block_id,
+                             const uint64_t& max_block_id,
+                             const size_t& num_skipped)
+{
+    // the skipped frames also left a gap in the block IDs
+    uint64_t gap = num_skipped;
+    if ( block_id != std::numeric_limits<uint64_t>::max() )
+    {
+        if ( last_block_id_valid_ )
+        {
+            uint64_t expected = last_block_id_ + 1;
+            if ( max_block_id != 0 && last_block_id_ >= max_block_id )
+            {
+                expected = 1;
+            }
+            if ( block_id >= expected )
+            {
+                gap = block_id - expected;
+            }
+            else if ( max_block_id != 0 && block_id >= 1 )
+            {
+                // wrapped around, 0 is never used
+                gap = (max_block_id - expected + 1) + (block_id - 1);
+            }
+            else
+            {
+                // block IDs restarted, e.g. by the camera itself
+                gap = num_skipped;
+            }
+        }
+        last_block_id_ = block_id;
+        last_block_id_valid_ = true;
+    }
+
+    if ( gap > num_skipped )
+    {
+        uint64_t lost = gap - num_skipped;
+        lost_frames_.fetch_add(lost, std::memory_order_relaxed);
+        PYLON_CAMERA_TRACE1(frame_lost, lost);
+        PYLON_CAMERA_WARN_STREAM_AGGREGATED(1.0, "Lost " << lost << " frame(s) before "
+                << "block ID " << block_id << ", " << numLostFrames()
+                << " frames lost in total");
+    }
+    if ( num_skipped > 0 )
+    {
+        skipped_frames_.fetch_add(num_skipped, std::memory_order_relaxed);
+    }
+    frame_seq_ += gap + 1;
+}
+
+void PylonCamera::resetFrameTracking()
+{
+    last_block_id_valid_ = false;
+}
+
 const bool& PylonCamera::isBinaryExposureSearchRunning() const
 {
     return is_binary_exposure_search_running_;
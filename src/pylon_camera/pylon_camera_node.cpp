@@ -28,9 +28,13 @@
  *****************************************************************************/
 
 #include <pylon_camera/pylon_camera_node.h>
+#include <pylon_camera/internal/tracepoints.h>
 #include <GenApi/GenApi.h>
 #include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
 #include <vector>
 #include "boost/multi_array.hpp"
 
@@ -40,48 +44,241 @@ namespace pylon_camera
 using sensor_msgs::CameraInfo;
 using sensor_msgs::CameraInfoPtr;
 
+/**
+ * Levels of the parameters in cfg/PylonCamera.cfg
+ */
+enum RECONFIGURE_LEVEL
+{
+    RL_ENCODING = 1,
+    RL_GEOMETRY = 2,
+    RL_EXPOSURE = 4,
+    RL_GAIN = 8,
+    RL_GAMMA = 16,
+    RL_FRAME_RATE = 32,
+};
+
+namespace
+{
+
+/**
+ * Time get_frame_history waits for frames after the event at most, in s
+ */
+const double GET_FRAME_HISTORY_MAX_WAIT = 2.0;
+
+/**
+ * A private node handle whose callbacks go to the given queue. Copies, e.g.
+ * the one of an action server, keep the queue.
+ */
+ros::NodeHandle privateNodeHandle(ros::CallbackQueue* queue)
+{
+    ros::NodeHandle nh("~");
+    nh.setCallbackQueue(queue);
+    return nh;
+}
+
+/**
+ * Widens a crop of an image axis to whole Bayer cells: the start is rounded
+ * down and the end up to even values, within the image
+ * @param begin the first pixel of the crop
+ * @param size the number of pixels of the crop, 0 if no cell fits
+ * @param length the number of pixels of the image axis
+ */
+void alignToBayerCell(size_t& begin, size_t& size, const size_t& length)
+{
+    size_t end = begin + size;
+    begin -= begin % 2;
+    end += end % 2;
+    if ( end > length )
+    {
+        end -= 2;
+    }
+    size = end > begin ? end - begin : 0;
+}
+
+}  // namespace
+
+template <typename RequestT, typename ResponseT>
+ros::ServiceServer PylonCameraNode::advertiseTimedService(
+                    ros::NodeHandle& nh,
+                    const std::string& service,
+                    bool (PylonCameraNode::*callback)(RequestT&, ResponseT&))
+{
+    return nh.advertiseService<RequestT, ResponseT>(
+                service,
+                timedServiceCallback<RequestT, ResponseT>(
+                        service, boost::bind(callback, this, _1, _2)));
+}
+
+template <typename RequestT, typename ResponseT>
+boost::function<bool(RequestT&, ResponseT&)> PylonCameraNode::timedServiceCallback(
+                    const std::string& service,
+                    const boost::function<bool(RequestT&, ResponseT&)>& callback)
+{
+    LatencyHistogram* histogram = serviceLatencyHistogram(service);
+    return [histogram, callback](RequestT& req, ResponseT& res)
+    {
+        const uint64_t start = LatencyStats::now();
+        const bool success = callback(req, res);
+        histogram->record(LatencyStats::now() - start);
+        return success;
+    };
+}
+
 PylonCameraNode::PylonCameraNode()
+    : PylonCameraNode(nullptr)
+{}
+
+PylonCameraNode::PylonCameraNode(PylonCamera* pylon_camera)
     : nh_("~"),
+      control_queue_(),
+      action_queue_(),
+      history_queue_(),
+      info_queue_(),
+      trigger_queue_(),
+      control_nh_(privateNodeHandle(&control_queue_)),
+      action_nh_(privateNodeHandle(&action_queue_)),
+      history_nh_(privateNodeHandle(&history_queue_)),
+      info_nh_(privateNodeHandle(&info_queue_)),
+      trigger_nh_(privateNodeHandle(&trigger_queue_)),
+      control_spinner_(1, &control_queue_),
+      action_spinner_(1, &action_queue_),
+      history_spinner_(1, &history_queue_),
+      info_spinner_(1, &info_queue_),
+      trigger_spinner_(1, &trigger_queue_),
+      service_latency_mutex_(),
+      service_latency_(),
       pylon_camera_parameter_set_(),
-      set_binning_srv_(nh_.advertiseService("set_binning",
-                                            &PylonCameraNode::setBinningCallback,
-                                            this)),
-      set_exposure_srv_(nh_.advertiseService("set_exposure",
-                                             &PylonCameraNode::setExposureCallback,
-                                             this)),
-      set_gain_srv_(nh_.advertiseService("set_gain",
-                                         &PylonCameraNode::setGainCallback,
-                                         this)),
-      set_gamma_srv_(nh_.advertiseService("set_gamma",
-                                          &PylonCameraNode::setGammaCallback,
-                                          this)),
-      set_brightness_srv_(nh_.advertiseService("set_brightness",
-                                               &PylonCameraNode::setBrightnessCallback,
-                                               this)),
-      set_sleeping_srv_(nh_.advertiseService("set_sleeping",
-                                             &PylonCameraNode::setSleepingCallback,
-                                             this)),
+      set_binning_srv_(advertiseTimedService(control_nh_,
+                                             "set_binning",
+                                             &PylonCameraNode::setBinningCallback)),
+      set_decimation_srv_(advertiseTimedService(control_nh_,
+                                                "set_decimation",
+                                                &PylonCameraNode::setDecimationCallback)),
+      set_roi_srv_(advertiseTimedService(control_nh_,
+                                         "set_roi",
+                                         &PylonCameraNode::setROICallback)),
+      register_roi_srv_(advertiseTimedService(control_nh_,
+                                              "register_roi",
+                                              &PylonCameraNode::registerROICallback)),
+      get_frame_history_srv_(advertiseTimedService(history_nh_,
+                                                   "get_frame_history",
+                                                   &PylonCameraNode::getFrameHistoryCallback)),
+      set_exposure_srv_(advertiseTimedService(control_nh_,
+                                              "set_exposure",
+                                              &PylonCameraNode::setExposureCallback)),
+      set_gain_srv_(advertiseTimedService(control_nh_,
+                                          "set_gain",
+                                          &PylonCameraNode::setGainCallback)),
+      set_gamma_srv_(advertiseTimedService(control_nh_,
+                                           "set_gamma",
+                                           &PylonCameraNode::setGammaCallback)),
+      set_brightness_srv_(advertiseTimedService(control_nh_,
+                                                "set_brightness",
+                                                &PylonCameraNode::setBrightnessCallback)),
+      set_sleeping_srv_(advertiseTimedService(info_nh_,
+                                              "set_sleeping",
+                                              &PylonCameraNode::setSleepingCallback)),
       set_user_output_srvs_(),
-      pylon_camera_(nullptr),
+      pylon_camera_(pylon_camera),
       it_(new image_transport::ImageTransport(nh_)),
-      img_raw_pub_(it_->advertiseCamera("image_raw", 1)),
+      img_raw_pub_(),
       img_rect_pub_(nullptr),
       grab_imgs_raw_as_(
-              nh_,
+              action_nh_,
               "grab_images_raw",
               boost::bind(&PylonCameraNode::grabImagesRawActionExecuteCB,
                           this,
                           _1),
               false),
       grab_imgs_rect_as_(nullptr),
+      grab_imgs_raw_result_(),
+      grab_imgs_rect_result_(),
+      grab_imgs_buffer_pool_(nullptr),
+      grab_imgs_spare_images_(),
+      grab_imgs_spare_mutex_(),
+      frame_history_(nullptr),
       pinhole_model_(nullptr),
+      img_raw_queue_monitor_(nullptr),
+      img_rect_queue_monitor_(nullptr),
+      publisher_stats_pub_(),
+      publisher_stats_timer_(),
+      latency_stats_(nullptr),
+      latency_pub_(),
+      latency_timer_(),
+      latency_last_publish_(),
+      scheduling_latency_(),
+      trigger_sub_(),
+      triggered_image_pub_(),
+      triggered_image_rect_pub_(),
+      triggered_img_msg_(),
+      triggered_img_rect_(),
+      trigger_latency_(),
+      sharpness_pub_(),
+      preview_publisher_(nullptr),
+      change_reference_(),
+      frames_since_publish_(0),
+      num_unchanged_skipped_(0),
+      num_keyframes_(0),
+      diagnostics_updater_(),
+      img_raw_diagnostic_(nullptr),
+      img_raw_min_freq_(0.0),
+      img_raw_max_freq_(0.0),
+      diagnostics_timer_(),
+      num_reconnects_(0),
+      camera_removed_(false),
+      num_brightness_search_succeeded_(0),
+      num_brightness_search_failed_(0),
+      num_brightness_search_timeouts_(0),
+      prev_grab_failures_(0),
+      prev_grab_timeouts_(0),
+      prev_incomplete_buffers_(0),
+      prev_lost_frames_(0),
+      prev_skipped_frames_(0),
+      frame_seq_offset_(0),
+      diag_grab_failures_(0),
+      diag_grab_timeouts_(0),
+      diag_incomplete_buffers_(0),
+      diag_lost_frames_(0),
+      diag_skipped_frames_(0),
+      diag_last_lost_frames_(0),
+      diag_last_grab_failures_(0),
+      diag_exposure_(0.0),
+      diag_gain_(0.0),
+      diag_temperature_(std::numeric_limits<float>::quiet_NaN()),
+      reconfigure_mutex_(),
+      reconfigure_server_(nullptr),
+      pending_config_mutex_(),
+      pending_config_(),
+      pending_config_level_(0),
+      config_applied_pub_(),
+      config_applied_msg_(),
+      config_applied_pending_(false),
+      last_geometry_downtime_ms_(0.0),
+      current_geometry_(),
+      client_rois_mutex_(),
+      client_rois_(),
+      client_roi_pubs_(),
+      geometry_before_clients_(),
+      geometry_before_clients_valid_(false),
       cv_bridge_img_rect_(nullptr),
-      camera_info_manager_(new camera_info_manager::CameraInfoManager(nh_)),
+      camera_info_manager_(new camera_info_manager::CameraInfoManager(info_nh_)),
       sampling_indices_(),
+      sampling_weights_(),
       brightness_exp_lut_(),
-      is_sleeping_(false)
+      is_sleeping_(false),
+      grab_mutex_(),
+      camera_mutex_()
 {
+    // the camera layer logs through rosconsole, with the level of its logger
+    static RosLogSink ros_log_sink;
+    setLogSink(&ros_log_sink);
+    setLogLevel(RosLogSink::rosconsoleLevel());
     init();
+    control_spinner_.start();
+    action_spinner_.start();
+    history_spinner_.start();
+    info_spinner_.start();
+    trigger_spinner_.start();
 }
 
 void PylonCameraNode::init()
@@ -93,6 +290,23 @@ void PylonCameraNode::init()
     // in case they are provided
     pylon_camera_parameter_set_.readFromRosParameterServer(nh_);
 
+    // init() is called again after a reconnect, the pool survives it
+    if ( grab_imgs_buffer_pool_ == nullptr )
+    {
+        grab_imgs_buffer_pool_ = new FrameBufferPool(
+                static_cast<size_t>(pylon_camera_parameter_set_.grab_images_pool_size_));
+    }
+    if ( frame_history_ == nullptr &&
+         pylon_camera_parameter_set_.frame_history_size_ > 0 )
+    {
+        frame_history_ = new FrameHistory(
+                static_cast<size_t>(pylon_camera_parameter_set_.frame_history_size_),
+                pylon_camera_parameter_set_.frame_history_duration_,
+                static_cast<size_t>(pylon_camera_parameter_set_.frame_history_max_memory_ * 1e6));
+    }
+
+    setupPublishers();
+
     // creating the target PylonCamera-Object with the specified
     // device_user_id, registering the Software-Trigger-Mode, starting the
     // communication with the device and enabling the desired startup-settings
@@ -108,12 +322,348 @@ void PylonCameraNode::init()
         ros::shutdown();
         return;
     }
+
+    setupDiagnostics();
+    setupReconfigure();
+
+    if ( camera_removed_ )
+    {
+        // only completed reconnects are counted
+        camera_removed_ = false;
+        ++num_reconnects_;
+    }
+}
+
+void PylonCameraNode::setupDiagnostics()
+{
+    diagnostics_updater_.setHardwareID(pylon_camera_->deviceUserID());
+
+    // the frame rate might have been limited while starting the grabbing
+    setExpectedFrequency(pylon_camera_parameter_set_.frameRate());
+
+    if ( img_raw_diagnostic_ )
+    {
+        // already registered, init() is called again after a camera removal
+        return;
+    }
+
+    img_raw_diagnostic_ = new diagnostic_updater::TopicDiagnostic(
+            img_raw_pub_.getTopic(),
+            diagnostics_updater_,
+            diagnostic_updater::FrequencyStatusParam(&img_raw_min_freq_,
+                                                     &img_raw_max_freq_,
+                                                     0.1,
+                                                     10),
+            diagnostic_updater::TimeStampStatusParam());
+    diagnostics_updater_.add("camera status",
+                             this,
+                             &PylonCameraNode::cameraStatusDiagnostics);
+    diagnostics_updater_.add("service latency",
+                             this,
+                             &PylonCameraNode::serviceLatencyDiagnostics);
+    diagnostics_timer_ = nh_.createTimer(ros::Duration(1.0),
+                                         &PylonCameraNode::diagnosticsTimerCB,
+                                         this);
+}
+
+void PylonCameraNode::setupReconfigure()
+{
+    // the clients shall see the values of the camera, not the defaults
+    PylonCameraConfig config;
+    config.image_encoding = pylon_camera_->currentROSEncoding();
+    ImageGeometry geometry = pylon_camera_->currentGeometry();
+    config.binning_x = static_cast<int>(geometry.binning_x);
+    config.binning_y = static_cast<int>(geometry.binning_y);
+    config.decimation_x = static_cast<int>(geometry.decimation_x);
+    config.decimation_y = static_cast<int>(geometry.decimation_y);
+    config.roi_offset_x = static_cast<int>(geometry.roi_offset_x);
+    config.roi_offset_y = static_cast<int>(geometry.roi_offset_y);
+    config.roi_width = static_cast<int>(geometry.roi_width);
+    config.roi_height = static_cast<int>(geometry.roi_height);
+    config.exposure = pylon_camera_->currentExposure();
+    config.gain = pylon_camera_->currentGain();
+    config.gamma = pylon_camera_->currentGamma();
+    config.frame_rate = pylon_camera_parameter_set_.frameRate();
+
+    if ( reconfigure_server_ )
+    {
+        // already running, init() is called again after a camera removal
+        reconfigure_server_->updateConfig(config);
+        return;
+    }
+
+    config_applied_pub_ = nh_.advertise<pylon_camera::ConfigApplied>(
+                                                    "config_applied", 10);
+    reconfigure_server_ = new ReconfigureServer(
+                                reconfigure_mutex_,
+                                ros::NodeHandle(nh_, "reconfigure"));
+    reconfigure_server_->updateConfig(config);
+    reconfigure_server_->setCallback(
+                boost::bind(&PylonCameraNode::reconfigureCB, this, _1, _2));
+
+    // setCallback() reports the current config, which is already applied
+    boost::lock_guard<boost::mutex> lock(pending_config_mutex_);
+    pending_config_level_ = 0;
+}
+
+void PylonCameraNode::reconfigureCB(PylonCameraConfig& config, uint32_t level)
+{
+    boost::lock_guard<boost::mutex> lock(pending_config_mutex_);
+    pending_config_ = config;
+    pending_config_level_ |= level;
+}
+
+void PylonCameraNode::applyPendingConfig()
+{
+    PylonCameraConfig config;
+    uint32_t level;
+    {
+        boost::lock_guard<boost::mutex> lock(pending_config_mutex_);
+        if ( pending_config_level_ == 0 )
+        {
+            return;
+        }
+        config = pending_config_;
+        level = pending_config_level_;
+        pending_config_level_ = 0;
+    }
+
+    TracedLockGuard lock(grab_mutex_, __func__);
+    if ( pylon_camera_ == nullptr || !pylon_camera_->isReady() )
+    {
+        // try again in the next cycle
+        boost::lock_guard<boost::mutex> lock(pending_config_mutex_);
+        pending_config_level_ |= level;
+        return;
+    }
+
+    std::vector<std::string> failed_parameters;
+    // encoding and geometry can only be changed while not grabbing, stop
+    // only once if both change
+    const bool pause_grabbing = (level & RL_ENCODING) && (level & RL_GEOMETRY);
+    if ( pause_grabbing )
+    {
+        pylon_camera_->pauseGrabbing();
+    }
+    if ( level & RL_ENCODING )
+    {
+        if ( !setImageEncoding(config.image_encoding) )
+        {
+            failed_parameters.push_back("image_encoding");
+        }
+        config.image_encoding = pylon_camera_->currentROSEncoding();
+    }
+    if ( level & RL_GEOMETRY )
+    {
+        ImageGeometry target;
+        target.binning_x = config.binning_x;
+        target.binning_y = config.binning_y;
+        target.decimation_x = config.decimation_x;
+        target.decimation_y = config.decimation_y;
+        target.roi_offset_x = config.roi_offset_x;
+        target.roi_offset_y = config.roi_offset_y;
+        target.roi_width = config.roi_width;
+        target.roi_height = config.roi_height;
+        ImageGeometry reached;
+        setGeometry(target, reached);
+        if ( reached.binning_x != target.binning_x )
+        {
+            failed_parameters.push_back("binning_x");
+        }
+        if ( reached.binning_y != target.binning_y )
+        {
+            failed_parameters.push_back("binning_y");
+        }
+        if ( reached.decimation_x != target.decimation_x )
+        {
+            failed_parameters.push_back("decimation_x");
+        }
+        if ( reached.decimation_y != target.decimation_y )
+        {
+            failed_parameters.push_back("decimation_y");
+        }
+        if ( reached.roi_offset_x != target.roi_offset_x ||
+             reached.roi_offset_y != target.roi_offset_y ||
+             ( target.roi_width != 0 && reached.roi_width != target.roi_width ) ||
+             ( target.roi_height != 0 && reached.roi_height != target.roi_height ) )
+        {
+            failed_parameters.push_back("roi");
+        }
+        config.binning_x = static_cast<int>(reached.binning_x);
+        config.binning_y = static_cast<int>(reached.binning_y);
+        config.decimation_x = static_cast<int>(reached.decimation_x);
+        config.decimation_y = static_cast<int>(reached.decimation_y);
+        config.roi_offset_x = static_cast<int>(reached.roi_offset_x);
+        config.roi_offset_y = static_cast<int>(reached.roi_offset_y);
+        config.roi_width = static_cast<int>(reached.roi_width);
+        config.roi_height = static_cast<int>(reached.roi_height);
+    }
+    if ( pause_grabbing && !pylon_camera_->resumeGrabbing() )
+    {
+        ROS_ERROR_STREAM("Could not restart the grabbing after the reconfigure request");
+    }
+    if ( level & RL_EXPOSURE )
+    {
+        float reached_exposure;
+        if ( !setExposure(config.exposure, reached_exposure) )
+        {
+            failed_parameters.push_back("exposure");
+        }
+        config.exposure = pylon_camera_->currentExposure();
+    }
+    if ( level & RL_GAIN )
+    {
+        float reached_gain;
+        if ( !setGain(config.gain, reached_gain) )
+        {
+            failed_parameters.push_back("gain");
+        }
+        config.gain = pylon_camera_->currentGain();
+    }
+    if ( level & RL_GAMMA )
+    {
+        float reached_gamma;
+        if ( !setGamma(config.gamma, reached_gamma) )
+        {
+            failed_parameters.push_back("gamma");
+        }
+        config.gamma = pylon_camera_->currentGamma();
+    }
+    // binning and encoding change the max possible frame rate as well
+    if ( level & (RL_FRAME_RATE | RL_GEOMETRY | RL_ENCODING) )
+    {
+        double reached_frame_rate = setFrameRate(config.frame_rate);
+        if ( config.frame_rate != -1 && reached_frame_rate != config.frame_rate )
+        {
+            failed_parameters.push_back("frame_rate");
+        }
+        config.frame_rate = reached_frame_rate;
+    }
+
+    ROS_INFO_STREAM("Applied reconfigure request: "
+            << "encoding = '" << config.image_encoding << "', "
+            << "binning = [" << config.binning_x << ", " << config.binning_y << "], "
+            << "decimation = [" << config.decimation_x << ", " << config.decimation_y << "], "
+            << "exposure = " << config.exposure << ", "
+            << "gain = " << config.gain << ", "
+            << "gamma = " << config.gamma << ", "
+            << "frame rate = " << config.frame_rate);
+
+    // report the reached values back to the clients
+    reconfigure_server_->updateConfig(config);
+
+    config_applied_msg_.success = failed_parameters.empty();
+    config_applied_msg_.failed_parameters = failed_parameters;
+    config_applied_pending_ = true;
+}
+
+bool PylonCameraNode::setImageEncoding(const std::string& target_encoding)
+{
+    TracedLockGuard lock(grab_mutex_, __func__);
+    bool success = pylon_camera_->setImageEncoding(target_encoding);
+    img_raw_msg_.encoding = pylon_camera_->currentROSEncoding();
+    if ( cv_bridge_img_rect_ )
+    {
+        cv_bridge_img_rect_->encoding = img_raw_msg_.encoding;
+    }
+    // the pixel depth changes the step and the weighted samples, which index
+    // bytes, the software decimation of the new format may change the size
+    updateGeometryDependentState();
+    return success;
+}
+
+double PylonCameraNode::setFrameRate(const double& target_frame_rate)
+{
+    double frame_rate = target_frame_rate;
+    if ( frame_rate == -1 ||
+         pylon_camera_->maxPossibleFramerate() < frame_rate )
+    {
+        frame_rate = pylon_camera_->maxPossibleFramerate();
+    }
+    pylon_camera_parameter_set_.setFrameRate(nh_, frame_rate);
+    setExpectedFrequency(frame_rate);
+    return frame_rate;
+}
+
+void PylonCameraNode::setExpectedFrequency(const double& frame_rate)
+{
+    img_raw_min_freq_ = frame_rate;
+    img_raw_max_freq_ = frame_rate;
+    if ( pylon_camera_parameter_set_.change_threshold_ > 0.0 )
+    {
+        img_raw_min_freq_ = frame_rate / pylon_camera_parameter_set_.change_keyframe_interval_;
+    }
+}
+
+void PylonCameraNode::setupPublishers()
+{
+    if ( img_raw_pub_ )
+    {
+        // already advertised, init() is called again after a camera removal
+        return;
+    }
+
+    img_raw_pub_ = it_->advertiseCamera(
+                        "image_raw",
+                        pylon_camera_parameter_set_.image_raw_queue_size_);
+    img_raw_queue_monitor_ = new PublisherQueueMonitor(
+                        img_raw_pub_.getTopic(),
+                        pylon_camera_parameter_set_.image_raw_queue_size_);
+
+    if ( pylon_camera_parameter_set_.publisher_stats_rate_ > 0.0 )
+    {
+        publisher_stats_pub_ =
+            nh_.advertise<diagnostic_msgs::DiagnosticArray>("publisher_stats", 1);
+        publisher_stats_timer_ = nh_.createTimer(
+                ros::Duration(1.0 / pylon_camera_parameter_set_.publisher_stats_rate_),
+                &PylonCameraNode::publisherStatsTimerCB,
+                this);
+    }
+
+    if ( !pylon_camera_parameter_set_.triggered_image_topic_.empty() )
+    {
+        const std::string& topic = pylon_camera_parameter_set_.triggered_image_topic_;
+        triggered_image_pub_ = nh_.advertise<sensor_msgs::Image>(topic, 1);
+        triggered_image_rect_pub_ = nh_.advertise<sensor_msgs::Image>(topic + "_rect", 1);
+        trigger_sub_ = trigger_nh_.subscribe("trigger",
+                                             10,
+                                             &PylonCameraNode::triggerCB,
+                                             this,
+                                             ros::TransportHints().tcpNoDelay());
+    }
+
+    if ( pylon_camera_parameter_set_.preview_rate_ > 0.0 )
+    {
+        preview_publisher_ = new PreviewPublisher(
+                                *it_,
+                                "preview",
+                                pylon_camera_parameter_set_.preview_max_width_,
+                                pylon_camera_parameter_set_.preview_rate_);
+    }
+
+    if ( pylon_camera_parameter_set_.publish_sharpness_ )
+    {
+        sharpness_pub_ = nh_.advertise<pylon_camera::Sharpness>("sharpness", 10);
+    }
+
+    if ( pylon_camera_parameter_set_.latency_stats_rate_ > 0.0 )
+    {
+        latency_stats_ = new LatencyStats();
+        latency_pub_ = nh_.advertise<pylon_camera::PipelineLatency>("latency", 1);
+        latency_last_publish_ = ros::Time::now();
+        latency_timer_ = nh_.createTimer(
+                ros::Duration(1.0 / pylon_camera_parameter_set_.latency_stats_rate_),
+                &PylonCameraNode::latencyTimerCB,
+                this);
+    }
 }
 
 bool PylonCameraNode::initAndRegister()
 {
-    pylon_camera_ = PylonCamera::create(
-                                    pylon_camera_parameter_set_.deviceUserID());
+    if ( pylon_camera_ == nullptr )
+    {
+        replaceCamera(PylonCamera::create(pylon_camera_parameter_set_.deviceUserID()));
+    }
 
     if ( pylon_camera_ == nullptr )
     {
@@ -122,8 +672,7 @@ bool PylonCameraNode::initAndRegister()
         ros::Rate r(0.5);
         while ( ros::ok() && pylon_camera_ == nullptr )
         {
-            pylon_camera_ = PylonCamera::create(
-                                    pylon_camera_parameter_set_.deviceUserID());
+            replaceCamera(PylonCamera::create(pylon_camera_parameter_set_.deviceUserID()));
             if ( ros::Time::now() > end )
             {
                 ROS_WARN_STREAM("No camera present. Keep waiting ...");
@@ -139,6 +688,9 @@ bool PylonCameraNode::initAndRegister()
         return false;
     }
 
+    pylon_camera_->setLatencyStats(latency_stats_);
+    diagnostics_updater_.setHardwareID(pylon_camera_->deviceUserID());
+
     if ( !pylon_camera_->registerCameraConfiguration() )
     {
         ROS_ERROR_STREAM("Error while registering the camera configuration to "
@@ -152,7 +704,8 @@ bool PylonCameraNode::initAndRegister()
         return false;
     }
 
-    if ( !pylon_camera_->applyCamSpecificStartupSettings(pylon_camera_parameter_set_) )
+    if ( !warmStart() &&
+         !pylon_camera_->applyCamSpecificStartupSettings(pylon_camera_parameter_set_) )
     {
         ROS_ERROR_STREAM("Error while applying the cam specific startup settings "
                 << "(e.g. mtu size for GigE, ...) to the camera!");
@@ -174,14 +727,17 @@ bool PylonCameraNode::startGrabbing()
     for ( int i = 0; i < set_user_output_srvs_.size(); ++i )
     {
         std::string srv_name = "set_user_output_" + std::to_string(i);
-        set_user_output_srvs_.at(i) = nh_.advertiseService< camera_control_msgs::SetBool::Request,
-                                                            camera_control_msgs::SetBool::Response >(
+        set_user_output_srvs_.at(i) = info_nh_.advertiseService< camera_control_msgs::SetBool::Request,
+                                                                 camera_control_msgs::SetBool::Response >(
                                             srv_name,
-                                            boost::bind(&PylonCameraNode::setUserOutputCB,
-                                                        this,
-                                                        i,
-                                                        _1,
-                                                        _2));
+                                            timedServiceCallback< camera_control_msgs::SetBool::Request,
+                                                                  camera_control_msgs::SetBool::Response >(
+                                                srv_name,
+                                                boost::bind(&PylonCameraNode::setUserOutputCB,
+                                                            this,
+                                                            i,
+                                                            _1,
+                                                            _2)));
     }
 
     img_raw_msg_.header.frame_id = pylon_camera_parameter_set_.cameraFrame();
@@ -193,6 +749,7 @@ bool PylonCameraNode::startGrabbing()
     // step = full row length in bytes, img_size = (step * rows), imagePixelDepth
     // already contains the number of channels
     img_raw_msg_.step = img_raw_msg_.width * pylon_camera_->imagePixelDepth();
+    current_geometry_ = pylon_camera_->currentGeometry();
 
     if ( !camera_info_manager_->setCameraName(pylon_camera_->deviceUserID()) )
     {
@@ -201,10 +758,7 @@ bool PylonCameraNode::startGrabbing()
                 << "] name not valid for camera_info_manger");
     }
 
-    setupSamplingIndices(sampling_indices_,
-                         pylon_camera_->imageRows(),
-                         pylon_camera_->imageCols(),
-                         pylon_camera_parameter_set_.downsampling_factor_exp_search_);
+    setupBrightnessSampling();
 
     grab_imgs_raw_as_.start();
 
@@ -243,27 +797,60 @@ bool PylonCameraNode::startGrabbing()
         }
     }
 
-    if ( pylon_camera_parameter_set_.binning_x_given_ )
+    if ( pylon_camera_->isWarmStarted() )
     {
-        size_t reached_binning_x;
-        setBinningX(pylon_camera_parameter_set_.binning_x_, reached_binning_x);
-        ROS_INFO_STREAM("Setting horizontal binning_x to "
-                << pylon_camera_parameter_set_.binning_x_);
-        ROS_WARN_STREAM("The image width of the camera_info-msg will "
-            << "be adapted, so that the binning_x value in this msg remains 1");
+        // geometry, exposure, gain, gamma and the auto functions are part of
+        // the restored feature set
+        updateGeometryDependentState();
     }
-
-    if ( pylon_camera_parameter_set_.binning_y_given_ )
+    else if ( pylon_camera_parameter_set_.binning_x_given_ ||
+              pylon_camera_parameter_set_.binning_y_given_ ||
+              pylon_camera_parameter_set_.decimation_x_given_ ||
+              pylon_camera_parameter_set_.decimation_y_given_ ||
+              pylon_camera_parameter_set_.roi_given_ )
     {
-        size_t reached_binning_y;
-        setBinningY(pylon_camera_parameter_set_.binning_y_, reached_binning_y);
-        ROS_INFO_STREAM("Setting vertical binning_y to "
-                << pylon_camera_parameter_set_.binning_y_);
-        ROS_WARN_STREAM("The image height of the camera_info-msg will "
-            << "be adapted, so that the binning_y value in this msg remains 1");
+        ImageGeometry target = pylon_camera_->currentGeometry();
+        if ( pylon_camera_parameter_set_.roi_given_ )
+        {
+            target.roi_offset_x = pylon_camera_parameter_set_.roi_offset_x_;
+            target.roi_offset_y = pylon_camera_parameter_set_.roi_offset_y_;
+            target.roi_width = pylon_camera_parameter_set_.roi_width_;
+            target.roi_height = pylon_camera_parameter_set_.roi_height_;
+        }
+        if ( pylon_camera_parameter_set_.binning_x_given_ )
+        {
+            target.binning_x = pylon_camera_parameter_set_.binning_x_;
+            ROS_INFO_STREAM("Setting horizontal binning_x to "
+                    << pylon_camera_parameter_set_.binning_x_);
+            ROS_WARN_STREAM("The image width of the camera_info-msg will "
+                << "be adapted, so that the binning_x value in this msg remains 1");
+        }
+        if ( pylon_camera_parameter_set_.binning_y_given_ )
+        {
+            target.binning_y = pylon_camera_parameter_set_.binning_y_;
+            ROS_INFO_STREAM("Setting vertical binning_y to "
+                    << pylon_camera_parameter_set_.binning_y_);
+            ROS_WARN_STREAM("The image height of the camera_info-msg will "
+                << "be adapted, so that the binning_y value in this msg remains 1");
+        }
+        if ( pylon_camera_parameter_set_.decimation_x_given_ )
+        {
+            target.decimation_x = pylon_camera_parameter_set_.decimation_x_;
+            ROS_INFO_STREAM("Setting horizontal decimation_x to "
+                    << pylon_camera_parameter_set_.decimation_x_);
+        }
+        if ( pylon_camera_parameter_set_.decimation_y_given_ )
+        {
+            target.decimation_y = pylon_camera_parameter_set_.decimation_y_;
+            ROS_INFO_STREAM("Setting vertical decimation_y to "
+                    << pylon_camera_parameter_set_.decimation_y_);
+        }
+        ImageGeometry reached;
+        setGeometry(target, reached);
     }
 
-    if ( pylon_camera_parameter_set_.exposure_given_ )
+    if ( !pylon_camera_->isWarmStarted() &&
+         pylon_camera_parameter_set_.exposure_given_ )
     {
         float reached_exposure;
         setExposure(pylon_camera_parameter_set_.exposure_, reached_exposure);
@@ -272,7 +859,8 @@ bool PylonCameraNode::startGrabbing()
                 << reached_exposure);
     }
 
-    if ( pylon_camera_parameter_set_.gain_given_ )
+    if ( !pylon_camera_->isWarmStarted() &&
+         pylon_camera_parameter_set_.gain_given_ )
     {
         float reached_gain;
         setGain(pylon_camera_parameter_set_.gain_, reached_gain);
@@ -281,7 +869,8 @@ bool PylonCameraNode::startGrabbing()
                 << reached_gain);
     }
 
-    if ( pylon_camera_parameter_set_.gamma_given_ )
+    if ( !pylon_camera_->isWarmStarted() &&
+         pylon_camera_parameter_set_.gamma_given_ )
     {
         float reached_gamma;
         setGamma(pylon_camera_parameter_set_.gamma_, reached_gamma);
@@ -289,7 +878,8 @@ bool PylonCameraNode::startGrabbing()
                 << ", reached: " << reached_gamma);
     }
 
-    if ( pylon_camera_parameter_set_.brightness_given_ )
+    if ( !pylon_camera_->isWarmStarted() &&
+         pylon_camera_parameter_set_.brightness_given_ )
     {
         int reached_brightness;
         setBrightness(pylon_camera_parameter_set_.brightness_,
@@ -343,16 +933,100 @@ bool PylonCameraNode::startGrabbing()
         ROS_INFO("Max possible framerate is %.2f Hz",
                  pylon_camera_->maxPossibleFramerate());
     }
+
+    if ( !pylon_camera_->isWarmStarted() )
+    {
+        persistFeatures();
+    }
     return true;
 }
 
+bool PylonCameraNode::warmStart()
+{
+    if ( pylon_camera_parameter_set_.feature_persistence_ == FP_NONE )
+    {
+        return false;
+    }
+
+    const std::string fingerprint = pylon_camera_parameter_set_.featureSetFingerprint(
+                                            pylon_camera_->deviceIdentity());
+    std::string stored_fingerprint;
+    std::ifstream file(fingerprintFile().c_str());
+    if ( !( file >> stored_fingerprint ) || stored_fingerprint != fingerprint )
+    {
+        ROS_INFO_STREAM("No persisted feature set matches the parameters and "
+                << "the camera, will configure the camera from scratch");
+        return false;
+    }
+
+    ros::WallTime start = ros::WallTime::now();
+    if ( !pylon_camera_->loadFeatures(pylon_camera_parameter_set_) )
+    {
+        ROS_WARN_STREAM("Restoring the persisted feature set failed, will "
+                << "configure the camera from scratch");
+        return false;
+    }
+    ROS_INFO_STREAM("Warm start: restored the feature set ("
+            << pylon_camera_parameter_set_.featurePersistenceString() << ", "
+            << fingerprint << ") in "
+            << (ros::WallTime::now() - start).toSec() * 1000.0 << " ms");
+    return true;
+}
+
+void PylonCameraNode::persistFeatures()
+{
+    if ( pylon_camera_parameter_set_.feature_persistence_ == FP_NONE )
+    {
+        return;
+    }
+
+    // invalidate the old fingerprint first, a half written feature set must
+    // never be restored
+    const std::string fingerprint_file = fingerprintFile();
+    std::remove(fingerprint_file.c_str());
+    if ( !pylon_camera_->saveFeatures(pylon_camera_parameter_set_) )
+    {
+        ROS_WARN("Could not persist the feature set, the next start will be "
+                 "a cold one as well");
+        return;
+    }
+
+    const std::string fingerprint = pylon_camera_parameter_set_.featureSetFingerprint(
+                                            pylon_camera_->deviceIdentity());
+    std::ofstream file(fingerprint_file.c_str());
+    file << fingerprint << std::endl;
+    if ( !file )
+    {
+        ROS_WARN_STREAM("Could not write the fingerprint to '"
+                << fingerprint_file << "'");
+        return;
+    }
+    ROS_INFO_STREAM("Persisted the feature set ("
+            << pylon_camera_parameter_set_.featurePersistenceString() << ", "
+            << fingerprint << ") for the next start");
+}
+
+std::string PylonCameraNode::fingerprintFile() const
+{
+    return pylon_camera_parameter_set_.feature_persistence_file_ + ".fingerprint";
+}
+
 void PylonCameraNode::setupRectification()
 {
     img_rect_pub_ =
-        new ros::Publisher(nh_.advertise<sensor_msgs::Image>("image_rect", 1));
+        new ros::Publisher(nh_.advertise<sensor_msgs::Image>(
+                        "image_rect",
+                        pylon_camera_parameter_set_.image_rect_queue_size_));
+    if ( img_rect_queue_monitor_ )
+    {
+        delete img_rect_queue_monitor_;
+    }
+    img_rect_queue_monitor_ = new PublisherQueueMonitor(
+                        img_rect_pub_->getTopic(),
+                        pylon_camera_parameter_set_.image_rect_queue_size_);
 
     grab_imgs_rect_as_ =
-        new GrabImagesAS(nh_,
+        new GrabImagesAS(action_nh_,
                          "grab_images_rect",
                          boost::bind(
                             &PylonCameraNode::grabImagesRectActionExecuteCB,
@@ -380,16 +1054,57 @@ void PylonCameraNode::spin()
         ROS_INFO_ONCE("Camera not calibrated");
     }
 
+    // reconfigure requests and leaving clients are applied between two
+    // frames
+    applyPendingConfig();
+    expireClientROIs();
+
     // images were published if subscribers are available or if someone calls
-    // the GrabImages Action
+    // the GrabImages Action. The frame history needs all frames.
     if ( !isSleeping() && ( img_raw_pub_.getNumSubscribers() > 0 ||
-                            getNumSubscribersRect() ) )
+                            getNumSubscribersRect() ||
+                            getNumSubscribersROI() ||
+                            sharpness_pub_.getNumSubscribers() > 0 ||
+                            ( preview_publisher_ && preview_publisher_->getNumSubscribers() > 0 ) ||
+                            frame_history_ != nullptr ) )
     {
-        if ( !grabImage() )
         {
-            return;
+            // a geometry change rewrites the dimensions of img_raw_msg_
+            // before the next grab resizes its data, hence the analysis of
+            // the image stays under the lock
+            TracedLockGuard lock(grab_mutex_, __func__);
+            if ( !grabImage() )
+            {
+                return;
+            }
+
+            if ( frame_history_ )
+            {
+                frame_history_->push(img_raw_msg_);
+            }
+
+            // the preview keeps its rate, even if the scene does not change
+            if ( preview_publisher_ )
+            {
+                preview_publisher_->push(img_raw_msg_);
+            }
+
+            if ( pylon_camera_parameter_set_.change_threshold_ > 0.0 && !detectChange() )
+            {
+                return;
+            }
         }
 
+        if ( config_applied_pending_ )
+        {
+            config_applied_msg_.header = img_raw_msg_.header;
+            config_applied_pub_.publish(config_applied_msg_);
+            config_applied_pending_ = false;
+        }
+
+        PYLON_CAMERA_TRACE(publish_start);
+        uint64_t publish_start = latency_stats_ ? LatencyStats::now() : 0;
+
         if ( img_raw_pub_.getNumSubscribers() > 0 )
         {
             // get actual cam_info-object in every frame, because it might have
@@ -398,74 +1113,443 @@ void PylonCameraNode::spin()
                         new sensor_msgs::CameraInfo(
                                         camera_info_manager_->getCameraInfo()));
             cam_info->header.stamp = img_raw_msg_.header.stamp;
+            cam_info->header.seq = img_raw_msg_.header.seq;
 
             // Publish via image_transport
             img_raw_pub_.publish(img_raw_msg_, *cam_info);
+            img_raw_queue_monitor_->published();
+            img_raw_diagnostic_->tick(img_raw_msg_.header.stamp);
         }
 
         if ( getNumSubscribersRect() > 0 )
         {
             img_rect_pub_->publish(*cv_bridge_img_rect_);
+            img_rect_queue_monitor_->published();
+        }
+
+        publishClientROIs();
+
+        if ( sharpness_pub_.getNumSubscribers() > 0 )
+        {
+            publishSharpness();
+        }
+
+        if ( latency_stats_ )
+        {
+            latency_stats_->record(LS_PUBLISH, publish_start);
+        }
+        PYLON_CAMERA_TRACE1(publish_done,
+                            static_cast<int64_t>(img_raw_msg_.header.stamp.toNSec()));
+    }
+}
+
+void PylonCameraNode::publisherStatsTimerCB(const ros::TimerEvent& event)
+{
+    diagnostic_msgs::DiagnosticArray stats;
+    stats.header.stamp = ros::Time::now();
+
+    diagnostic_msgs::DiagnosticStatus status;
+    status.name = ros::this_node::getName() + ": publisher queues";
+    status.hardware_id = pylon_camera_parameter_set_.deviceUserID();
+
+    PublisherQueueMonitor* monitors[] = { img_raw_queue_monitor_,
+                                          img_rect_queue_monitor_ };
+    for ( PublisherQueueMonitor* monitor : monitors )
+    {
+        if ( monitor )
+        {
+            monitor->update();
+            monitor->fillStatus(status);
+        }
+    }
+    // roscpp does not report the drops of the outgoing queues
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    status.message = "Subscribers and enqueued images";
+
+    stats.status.push_back(status);
+    publisher_stats_pub_.publish(stats);
+}
+
+void PylonCameraNode::diagnosticsTimerCB(const ros::TimerEvent& event)
+{
+    diagnostics_updater_.update();
+}
+
+void PylonCameraNode::cameraStatusDiagnostics(
+                        diagnostic_updater::DiagnosticStatusWrapper& stat)
+{
+    bool camera_available = false;
+    {
+        // never wait for the grabbing, report the cached values instead
+        boost::unique_lock<boost::recursive_mutex> lock(grab_mutex_,
+                                                        boost::try_to_lock);
+        if ( lock.owns_lock() && pylon_camera_ != nullptr &&
+             !pylon_camera_->isCamRemoved() )
+        {
+            camera_available = true;
+            diag_grab_failures_ = prev_grab_failures_ + pylon_camera_->numGrabFailures();
+            diag_grab_timeouts_ = prev_grab_timeouts_ + pylon_camera_->numGrabTimeouts();
+            diag_incomplete_buffers_ = prev_incomplete_buffers_
+                                     + pylon_camera_->numIncompleteBuffers();
+            diag_lost_frames_ = prev_lost_frames_ + pylon_camera_->numLostFrames();
+            diag_skipped_frames_ = prev_skipped_frames_
+                                 + pylon_camera_->numSkippedFrames();
+            try
+            {
+                diag_exposure_ = pylon_camera_->currentExposure();
+                diag_gain_ = pylon_camera_->currentGain();
+                diag_temperature_ = pylon_camera_->currentTemperature();
+            }
+            catch ( const std::exception& e )
+            {
+                ROS_DEBUG_STREAM("Reading the camera values for the diagnostics "
+                        << "failed: " << e.what());
+            }
+        }
+        else if ( !lock.owns_lock() )
+        {
+            // busy grabbing, hence the camera is available, unless the
+            // grabbing thread is reconnecting it
+            camera_available = !camera_removed_;
+        }
+    }
+
+    if ( !camera_available )
+    {
+        stat.summary(diagnostic_msgs::DiagnosticStatus::ERROR,
+                     "Camera not available");
+    }
+    else if ( diag_grab_failures_ > diag_last_grab_failures_ )
+    {
+        stat.summary(diagnostic_msgs::DiagnosticStatus::WARN,
+                     std::to_string(diag_grab_failures_ - diag_last_grab_failures_)
+                     + " grabs failed since last update");
+    }
+    else if ( diag_lost_frames_ > diag_last_lost_frames_ )
+    {
+        stat.summary(diagnostic_msgs::DiagnosticStatus::WARN,
+                     std::to_string(diag_lost_frames_ - diag_last_lost_frames_)
+                     + " frames lost since last update");
+    }
+    else
+    {
+        stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Grabbing");
+    }
+    diag_last_grab_failures_ = diag_grab_failures_;
+    diag_last_lost_frames_ = diag_lost_frames_;
+
+    stat.add("grab failures", diag_grab_failures_);
+    stat.add("grab timeouts", diag_grab_timeouts_);
+    stat.add("incomplete buffers", diag_incomplete_buffers_);
+    stat.add("lost frames", diag_lost_frames_);
+    stat.add("skipped frames", diag_skipped_frames_);
+    stat.add("reconnects", num_reconnects_.load());
+    stat.add("last geometry change downtime [ms]", last_geometry_downtime_ms_.load());
+    stat.add("brightness search succeeded", num_brightness_search_succeeded_.load());
+    stat.add("brightness search failed", num_brightness_search_failed_.load());
+    stat.add("brightness search timeouts", num_brightness_search_timeouts_.load());
+    if ( frame_history_ )
+    {
+        stat.add("frame history frames", frame_history_->size());
+        stat.add("frame history memory [MB]", frame_history_->memoryBytes() * 1e-6);
+    }
+    const LatencySummary scheduling = scheduling_latency_.snapshotAndReset();
+    if ( scheduling.count > 0 )
+    {
+        // ns -> us
+        stat.add("scheduling latency p99 [us]", scheduling.p99 * 1e-3);
+        stat.add("scheduling latency max [us]", scheduling.max * 1e-3);
+    }
+    const LatencySummary triggered = trigger_latency_.snapshotAndReset();
+    if ( triggered.count > 0 )
+    {
+        // ns -> ms
+        stat.add("triggered images", triggered.count);
+        stat.add("trigger to image p50 [ms]", triggered.p50 * 1e-6);
+        stat.add("trigger to image max [ms]", triggered.max * 1e-6);
+    }
+    if ( pylon_camera_parameter_set_.change_threshold_ > 0.0 )
+    {
+        stat.add("unchanged frames skipped", num_unchanged_skipped_.load());
+        stat.add("keyframes", num_keyframes_.load());
+    }
+    stat.add("exposure [us]", diag_exposure_);
+    stat.add("gain [%]", diag_gain_ * 100.0);
+    if ( std::isnan(diag_temperature_) )
+    {
+        stat.add("temperature [C]", "not available");
+    }
+    else
+    {
+        stat.add("temperature [C]", diag_temperature_);
+    }
+}
+
+void PylonCameraNode::serviceLatencyDiagnostics(
+                        diagnostic_updater::DiagnosticStatusWrapper& stat)
+{
+    boost::lock_guard<boost::mutex> lock(service_latency_mutex_);
+    uint64_t num_calls = 0;
+    for ( auto& entry : service_latency_ )
+    {
+        const LatencySummary summary = entry.second->snapshotAndReset();
+        if ( summary.count == 0 )
+        {
+            continue;
         }
+        num_calls += summary.count;
+        // ns -> ms
+        stat.add(entry.first + " calls", summary.count);
+        stat.add(entry.first + " mean [ms]", summary.mean * 1e-6);
+        stat.add(entry.first + " p99 [ms]", summary.p99 * 1e-6);
+        stat.add(entry.first + " max [ms]", summary.max * 1e-6);
+    }
+    stat.summary(diagnostic_msgs::DiagnosticStatus::OK,
+                 std::to_string(num_calls) + " service calls since last update");
+}
+
+LatencyHistogram* PylonCameraNode::serviceLatencyHistogram(const std::string& service)
+{
+    boost::lock_guard<boost::mutex> lock(service_latency_mutex_);
+    LatencyHistogram*& histogram = service_latency_[service];
+    if ( histogram == nullptr )
+    {
+        histogram = new LatencyHistogram();
     }
+    return histogram;
+}
+
+void PylonCameraNode::replaceCamera(PylonCamera* camera)
+{
+    boost::unique_lock<boost::shared_mutex> lock(camera_mutex_);
+    delete pylon_camera_;
+    pylon_camera_ = camera;
+}
+
+void PylonCameraNode::latencyTimerCB(const ros::TimerEvent& event)
+{
+    pylon_camera::PipelineLatency msg;
+    msg.header.stamp = ros::Time::now();
+    msg.header.frame_id = pylon_camera_parameter_set_.cameraFrame();
+    msg.period = msg.header.stamp - latency_last_publish_;
+    latency_last_publish_ = msg.header.stamp;
+
+    for ( int i = 0; i < LS_NUM_STAGES; ++i )
+    {
+        const LATENCY_STAGE stage = static_cast<LATENCY_STAGE>(i);
+        const LatencySummary summary =
+                        latency_stats_->histogram(stage).snapshotAndReset();
+        pylon_camera::StageLatency stage_msg;
+        stage_msg.stage = LatencyStats::stageName(stage);
+        stage_msg.count = summary.count;
+        // ns -> us
+        stage_msg.mean = summary.mean * 1e-3;
+        stage_msg.min = summary.min * 1e-3;
+        stage_msg.max = summary.max * 1e-3;
+        stage_msg.p50 = summary.p50 * 1e-3;
+        stage_msg.p90 = summary.p90 * 1e-3;
+        stage_msg.p99 = summary.p99 * 1e-3;
+        stage_msg.p999 = summary.p999 * 1e-3;
+        msg.stages.push_back(stage_msg);
+    }
+    latency_pub_.publish(msg);
+}
+
+bool PylonCameraNode::grabImage()
+{
+    TracedLockGuard lock(grab_mutex_, __func__);
+    return grabImage(img_raw_msg_, cv_bridge_img_rect_);
 }
 
-bool PylonCameraNode::grabImage()
+bool PylonCameraNode::grabImage(sensor_msgs::Image& img,
+                                cv_bridge::CvImage* img_rect)
 {
-    boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
-    if ( !pylon_camera_->grab(img_raw_msg_.data) )
+    TracedLockGuard lock(grab_mutex_, __func__);
+    if ( !pylon_camera_->grab(img.data) )
     {
         if ( pylon_camera_->isCamRemoved() )
         {
             ROS_ERROR("Pylon camera has been removed!");
-            delete pylon_camera_;
-            pylon_camera_ = nullptr;
+            prev_grab_failures_ += pylon_camera_->numGrabFailures();
+            prev_grab_timeouts_ += pylon_camera_->numGrabTimeouts();
+            prev_incomplete_buffers_ += pylon_camera_->numIncompleteBuffers();
+            prev_lost_frames_ += pylon_camera_->numLostFrames();
+            prev_skipped_frames_ += pylon_camera_->numSkippedFrames();
+            frame_seq_offset_ += pylon_camera_->frameSequence();
+            camera_removed_ = true;
+            replaceCamera(nullptr);
             ros::Duration(0.5).sleep();  // sleep for half a second
             init();
         }
         else
         {
-            ROS_WARN("Pylon camera returned invalid image! Skipping");
+            // logged asynchronously, not to slow down the acquisition
+            // during an error storm any further
+            PYLON_CAMERA_WARN_STREAM_AGGREGATED(1.0, "Pylon camera returned invalid "
+                    << "image! Skipping");
         }
         return false;
     }
 
-    img_raw_msg_.header.stamp = ros::Time::now();
+    img.header.stamp = ros::Time::now();
+    // gaps in the sequence tell the subscribers about lost frames
+    img.header.seq = static_cast<uint32_t>(
+                            frame_seq_offset_ + pylon_camera_->frameSequence());
 
-    if ( camera_info_manager_->isCalibrated() )
+    // the rectification is only set up if a calibration was loaded at start
+    if ( img_rect != nullptr && pinhole_model_ != nullptr &&
+         camera_info_manager_->isCalibrated() )
     {
-        cv_bridge_img_rect_->header.stamp = img_raw_msg_.header.stamp;
+        img_rect->header.stamp = img.header.stamp;
+        img_rect->header.seq = img.header.seq;
         assert(pinhole_model_->initialized());
+        PYLON_CAMERA_TRACE(rectify_start);
+        uint64_t stage_start = latency_stats_ ? LatencyStats::now() : 0;
         cv_bridge::CvImagePtr cv_img_raw = cv_bridge::toCvCopy(
-                                                        img_raw_msg_,
-                                                        img_raw_msg_.encoding);
+                                                        img,
+                                                        img.encoding);
+        if ( latency_stats_ )
+        {
+            stage_start = latency_stats_->record(LS_CONVERT, stage_start);
+        }
         pinhole_model_->fromCameraInfo(camera_info_manager_->getCameraInfo());
-        pinhole_model_->rectifyImage(cv_img_raw->image, cv_bridge_img_rect_->image);
+        pinhole_model_->rectifyImage(cv_img_raw->image, img_rect->image);
+        PYLON_CAMERA_TRACE(rectify_done);
+        if ( latency_stats_ )
+        {
+            latency_stats_->record(LS_RECTIFY, stage_start);
+        }
     }
     return true;
 }
 
+void PylonCameraNode::triggerCB(const std_msgs::Empty::ConstPtr& msg)
+{
+    const uint64_t receipt_ns = LatencyStats::now();
+    {
+        // the lock is released before publishing, spin() and the other
+        // callbacks only wait for the grab
+        TracedLockGuard lock(grab_mutex_, __func__);
+        if ( isSleeping() || pylon_camera_ == nullptr || !pylon_camera_->isReady() )
+        {
+            PYLON_CAMERA_WARN_STREAM_AGGREGATED(1.0, "Ignoring trigger, the camera is "
+                    << ( isSleeping() ? "sleeping" : "not ready" ));
+            return;
+        }
+
+        float previous_exposure, previous_gain;
+        applyTriggerSettings(previous_exposure, previous_gain);
+        // the geometry and encoding only change with grab_mutex_ held
+        triggered_img_msg_.header.frame_id = img_raw_msg_.header.frame_id;
+        triggered_img_msg_.encoding = img_raw_msg_.encoding;
+        triggered_img_msg_.height = img_raw_msg_.height;
+        triggered_img_msg_.width = img_raw_msg_.width;
+        triggered_img_msg_.step = img_raw_msg_.step;
+        triggered_img_msg_.is_bigendian = img_raw_msg_.is_bigendian;
+        triggered_img_rect_.header.frame_id = img_raw_msg_.header.frame_id;
+        triggered_img_rect_.encoding = img_raw_msg_.encoding;
+        const bool grabbed = grabImage(triggered_img_msg_, &triggered_img_rect_);
+        // grabImage() replaces the camera if it was removed
+        if ( pylon_camera_ != nullptr && pylon_camera_->isReady() )
+        {
+            restoreTriggerSettings(previous_exposure, previous_gain);
+        }
+        if ( !grabbed )
+        {
+            return;
+        }
+    }
+
+    // triggered_img_msg_ is only written by this callback, which runs on
+    // the single threaded trigger_queue_
+    triggered_image_pub_.publish(triggered_img_msg_);
+    if ( pinhole_model_ != nullptr && camera_info_manager_->isCalibrated() &&
+         triggered_image_rect_pub_.getNumSubscribers() > 0 )
+    {
+        triggered_image_rect_pub_.publish(triggered_img_rect_);
+    }
+
+    const uint64_t latency_ns = LatencyStats::now() - receipt_ns;
+    trigger_latency_.record(latency_ns);
+    if ( latency_stats_ )
+    {
+        latency_stats_->histogram(LS_TRIGGERED).record(latency_ns);
+    }
+}
+
+void PylonCameraNode::applyTriggerSettings(float& previous_exposure,
+                                           float& previous_gain)
+{
+    previous_exposure = -1.0;
+    previous_gain = -1.0;
+    // reading the current values is usually served from the node map cache,
+    // the camera is only written to if the values differ
+    const float& target_exposure = pylon_camera_parameter_set_.trigger_exposure_;
+    const float current_exposure = pylon_camera_->currentExposure();
+    if ( target_exposure > 0.0 &&
+         std::fabs(current_exposure - target_exposure) > pylon_camera_->exposureStep() )
+    {
+        previous_exposure = current_exposure;
+        float reached_exposure = 0.0;
+        if ( !pylon_camera_->setExposure(target_exposure, reached_exposure) )
+        {
+            PYLON_CAMERA_WARN_STREAM_AGGREGATED(1.0, "Exposure for the triggered "
+                    << "images not reached: " << reached_exposure << " us");
+        }
+    }
+
+    const float& target_gain = pylon_camera_parameter_set_.trigger_gain_;
+    const float current_gain = pylon_camera_->currentGain();
+    if ( target_gain >= 0.0 && std::fabs(current_gain - target_gain) > 1e-3 )
+    {
+        previous_gain = current_gain;
+        float reached_gain = 0.0;
+        if ( !pylon_camera_->setGain(target_gain, reached_gain) )
+        {
+            PYLON_CAMERA_WARN_STREAM_AGGREGATED(1.0, "Gain for the triggered "
+                    << "images not reached: " << reached_gain);
+        }
+    }
+}
+
+void PylonCameraNode::restoreTriggerSettings(const float& previous_exposure,
+                                             const float& previous_gain)
+{
+    float reached_value = 0.0;
+    if ( previous_exposure > 0.0 &&
+         !pylon_camera_->setExposure(previous_exposure, reached_value) )
+    {
+        PYLON_CAMERA_WARN_STREAM_AGGREGATED(1.0, "Exposure not restored after "
+                << "the triggered image: " << reached_value << " us");
+    }
+    if ( previous_gain >= 0.0 &&
+         !pylon_camera_->setGain(previous_gain, reached_value) )
+    {
+        PYLON_CAMERA_WARN_STREAM_AGGREGATED(1.0, "Gain not restored after "
+                << "the triggered image: " << reached_value);
+    }
+}
+
 void PylonCameraNode::grabImagesRawActionExecuteCB(
                     const camera_control_msgs::GrabImagesGoal::ConstPtr& goal)
 {
-    camera_control_msgs::GrabImagesResult result;
-    result = grabImagesRaw(goal, &grab_imgs_raw_as_);
-    grab_imgs_raw_as_.setSucceeded(result);
+    grabImagesRaw(goal, &grab_imgs_raw_as_, grab_imgs_raw_result_);
+    grab_imgs_raw_as_.setSucceeded(grab_imgs_raw_result_);
 }
 
 void PylonCameraNode::grabImagesRectActionExecuteCB(
                     const camera_control_msgs::GrabImagesGoal::ConstPtr& goal)
 {
-    camera_control_msgs::GrabImagesResult result;
+    camera_control_msgs::GrabImagesResult& result = grab_imgs_rect_result_;
     if ( !camera_info_manager_->isCalibrated() )
     {
-        result.success = false;
+        resetGrabImagesResult(result);
         grab_imgs_rect_as_->setSucceeded(result);
         return;
     }
     else
     {
-        result = PylonCameraNode::grabImagesRaw(goal, grab_imgs_rect_as_);
+        PylonCameraNode::grabImagesRaw(goal, grab_imgs_rect_as_, result);
         if ( !result.success )
         {
             grab_imgs_rect_as_->setSucceeded(result);
@@ -488,12 +1572,32 @@ void PylonCameraNode::grabImagesRectActionExecuteCB(
     }
 }
 
-camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
+void PylonCameraNode::resetGrabImagesResult(
+        camera_control_msgs::GrabImagesResult& result)
+{
+    boost::lock_guard<boost::mutex> lock(grab_imgs_spare_mutex_);
+    for ( sensor_msgs::Image& img : result.images )
+    {
+        grab_imgs_buffer_pool_->release(img.data);
+        // keeps the strings of the image with their capacity
+        grab_imgs_spare_images_.push_back(std::move(img));
+    }
+    result.images.clear();
+    result.reached_values.clear();
+    result.reached_exposure_times.clear();
+    result.reached_gain_values.clear();
+    result.reached_gamma_values.clear();
+    result.reached_brightness_values.clear();
+    result.success = false;
+}
+
+void PylonCameraNode::grabImagesRaw(
         const camera_control_msgs::GrabImagesGoal::ConstPtr& goal,
-        GrabImagesAS* action_server)
+        GrabImagesAS* action_server,
+        camera_control_msgs::GrabImagesResult& result)
 {
-    camera_control_msgs::GrabImagesResult result;
     camera_control_msgs::GrabImagesFeedback feedback;
+    resetGrabImagesResult(result);
 
 #if DEBUG
     std::cout << *goal << std::endl;
@@ -503,9 +1607,7 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
     bool using_deprecated_interface = goal->target_type == 1 ||
                                       goal->target_type == 2;
     bool exposure_given = false;
-    std::vector<float> exposure_times;
     bool brightness_given = false;
-    std::vector<float> brightness_values;
     bool gain_auto = false;
     bool exposure_auto = false;
     if ( using_deprecated_interface )
@@ -518,12 +1620,10 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
         if ( goal->target_type == goal->EXPOSURE )
         {
             exposure_given = true;
-            exposure_times = goal->target_values;
         }
         if ( goal->target_type == goal->BRIGHTNESS )
         {
             brightness_given = true;
-            brightness_values = goal->target_values;
             // behaviour of the deprecated interface: gain fix, exposure auto
             gain_auto = false;
             exposure_auto = true;
@@ -532,12 +1632,17 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
     else
     {
         exposure_given = goal->exposure_given;
-        exposure_times = goal->exposure_times;
         brightness_given = goal->brightness_given;
-        brightness_values = goal->brightness_values;
         gain_auto = goal->gain_auto;
         exposure_auto = goal->exposure_auto;
     }
+    // referenced instead of copied, a goal must not allocate
+    const std::vector<float>& exposure_times = using_deprecated_interface
+                                             ? goal->target_values
+                                             : goal->exposure_times;
+    const std::vector<float>& brightness_values = using_deprecated_interface
+                                                ? goal->target_values
+                                                : goal->brightness_values;
     // handling of deprecated interface
 
     // Can only grab images if either exposure times, or brightness or gain
@@ -548,7 +1653,7 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
             << "'exposure_given', 'gain_given' and 'brightness_given' are set "
             << "to false! Not enough information to execute acquisition!");
         result.success = false;
-        return result;
+        return;
     }
 
     if ( exposure_given && exposure_times.empty() )
@@ -557,7 +1662,7 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
             << "'exposure_given' is true, but the 'exposure_times' vector is "
             << "empty! Not enough information to execute acquisition!");
         result.success = false;
-        return result;
+        return;
     }
 
     if ( goal->gain_given && goal->gain_values.empty() )
@@ -566,7 +1671,7 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
             << "'gain_given' is true, but the 'gain_values' vector is "
             << "empty! Not enough information to execute acquisition!");
         result.success = false;
-        return result;
+        return;
     }
 
     if ( brightness_given && brightness_values.empty() )
@@ -575,7 +1680,7 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
             << "'brightness_given' is true, but the 'brightness_values' vector"
             << " is empty! Not enough information to execute acquisition!");
         result.success = false;
-        return result;
+        return;
     }
 
     if ( goal->gamma_given && goal->gamma_values.empty() )
@@ -584,17 +1689,16 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
             << "'gamma_given' is true, but the 'gamma_values' vector is "
             << "empty! Not enough information to execute acquisition!");
         result.success = false;
-        return result;
+        return;
     }
 
-    std::vector<size_t> candidates;
-    candidates.resize(4);  // gain, exposure, gamma, brightness
-    candidates.at(0) = goal->gain_given ? goal->gain_values.size() : 0;
-    candidates.at(1) = exposure_given ? exposure_times.size() : 0;
-    candidates.at(2) = brightness_given ? brightness_values.size() : 0;
-    candidates.at(3) = goal->gamma_given ? goal->gamma_values.size() : 0;
+    size_t candidates[4];  // gain, exposure, gamma, brightness
+    candidates[0] = goal->gain_given ? goal->gain_values.size() : 0;
+    candidates[1] = exposure_given ? exposure_times.size() : 0;
+    candidates[2] = brightness_given ? brightness_values.size() : 0;
+    candidates[3] = goal->gamma_given ? goal->gamma_values.size() : 0;
 
-    size_t n_images = *std::max_element(candidates.begin(), candidates.end());
+    size_t n_images = *std::max_element(candidates, candidates + 4);
 
     if ( exposure_given && exposure_times.size() != n_images )
     {
@@ -602,7 +1706,7 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
             << "the size of the requested vaules of brightness, gain or "
             << "gamma! Can't grab!");
         result.success = false;
-        return result;
+        return;
     }
 
     if ( goal->gain_given && goal->gain_values.size() != n_images )
@@ -611,7 +1715,7 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
             << "the size of the requested exposure times or the vaules of "
             << "brightness or gamma! Can't grab!");
         result.success = false;
-        return result;
+        return;
     }
 
     if ( goal->gamma_given && goal->gamma_values.size() != n_images )
@@ -620,7 +1724,7 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
             << "the size of the requested exposure times or the vaules of "
             << "brightness or gain! Can't grab!");
         result.success = false;
-        return result;
+        return;
     }
 
     if ( brightness_given && brightness_values.size() != n_images )
@@ -629,7 +1733,7 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
             << "the size of the requested exposure times or the vaules of gain or "
             << "gamma! Can't grab!");
         result.success = false;
-        return result;
+        return;
     }
 
     if ( brightness_given && !( exposure_auto || gain_auto ) )
@@ -638,10 +1742,24 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
             << "target brightness is provided but Exposure time AND gain are "
             << "declared as fix, so its impossible to reach the brightness");
         result.success = false;
-        return result;
+        return;
     }
 
+    // the images and buffers of previous goals are reused, grab() only
+    // allocates if the image got larger
     result.images.resize(n_images);
+    {
+        boost::lock_guard<boost::mutex> lock(grab_imgs_spare_mutex_);
+        for ( sensor_msgs::Image& img : result.images )
+        {
+            if ( !grab_imgs_spare_images_.empty() )
+            {
+                img = std::move(grab_imgs_spare_images_.back());
+                grab_imgs_spare_images_.pop_back();
+            }
+            grab_imgs_buffer_pool_->acquire(img.data);
+        }
+    }
     result.reached_exposure_times.resize(n_images);
     result.reached_gain_values.resize(n_images);
     result.reached_gamma_values.resize(n_images);
@@ -649,7 +1767,7 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
 
     result.success = true;
 
-    boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
+    TracedLockGuard lock(grab_mutex_, __func__);
 
     float previous_exp, previous_gain, previous_gamma;
     if ( exposure_given )
@@ -707,7 +1825,8 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
         }
 
         sensor_msgs::Image& img = result.images[i];
-        img.encoding = pylon_camera_->currentROSEncoding();
+        // copied from the members, the strings keep their capacity
+        img.encoding = img_raw_msg_.encoding;
         img.height = pylon_camera_->imageRows();
         img.width = pylon_camera_->imageCols();
         // step = full row length in bytes, img_size = (step * rows), imagePixelDepth
@@ -721,7 +1840,9 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
         }
 
         img.header.stamp = ros::Time::now();
-        img.header.frame_id = cameraFrame();
+        img.header.seq = static_cast<uint32_t>(
+                            frame_seq_offset_ + pylon_camera_->frameSequence());
+        img.header.frame_id = img_raw_msg_.header.frame_id;
         feedback.curr_nr_images_taken = i+1;
 
         if ( action_server != nullptr )
@@ -751,7 +1872,7 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
             setGain(previous_gain, reached_val);
             setExposure(previous_exp, reached_val);
         }
-        return result;
+        return;
     }
 
     if ( using_deprecated_interface )
@@ -784,17 +1905,87 @@ camera_control_msgs::GrabImagesResult PylonCameraNode::grabImagesRaw(
         setGain(previous_gain, reached_val);
         setExposure(previous_exp, reached_val);
     }
-    return result;
+}
+
+bool PylonCameraNode::getFrameHistoryCallback(
+                            pylon_camera::GetFrameHistory::Request &req,
+                            pylon_camera::GetFrameHistory::Response &res)
+{
+    if ( frame_history_ == nullptr )
+    {
+        res.success = false;
+        res.message = "The frame history is disabled, set frame_history_size";
+        return true;
+    }
+
+    const ros::Time start = req.event_stamp.toSec() > req.before.toSec()
+                          ? req.event_stamp - req.before
+                          : ros::Time();
+    const ros::Time end = req.event_stamp + req.after;
+
+    // frames after the event may not be grabbed yet, wait until the end of
+    // the window plus the time to grab a frame, but not longer than
+    // GET_FRAME_HISTORY_MAX_WAIT
+    const double wait = std::min(std::max((end - ros::Time::now()).toSec(), 0.0) + 0.5,
+                                 GET_FRAME_HISTORY_MAX_WAIT);
+    frame_history_->waitFor(end, wait);
+
+    frame_history_->query(start, end, res.images);
+    res.success = !res.images.empty();
+    if ( !res.success )
+    {
+        res.message = "No frames in the history within the time window";
+    }
+    res.frames_in_history = static_cast<uint32_t>(frame_history_->size());
+    res.history_capacity = static_cast<uint32_t>(frame_history_->capacity());
+    res.memory_bytes = frame_history_->memoryBytes();
+    res.oldest_stamp = frame_history_->oldestStamp();
+    res.newest_stamp = frame_history_->newestStamp();
+    return true;
 }
 
 bool PylonCameraNode::setUserOutputCB(const int output_id,
                                       camera_control_msgs::SetBool::Request &req,
                                       camera_control_msgs::SetBool::Response &res)
 {
-    res.success = pylon_camera_->setUserOutput(output_id, req.data);
+    // needs no ordering with the grabbing, hence not blocked by a
+    // brightness search holding the grab_mutex_
+    boost::shared_lock<boost::shared_mutex> lock(camera_mutex_);
+    res.success = pylon_camera_ != nullptr &&
+                  pylon_camera_->setUserOutput(output_id, req.data);
     return true;
 }
 
+void PylonCameraNode::setupAcquisitionThread()
+{
+    if ( pylon_camera_parameter_set_.lock_memory_ && realtime::lockMemory() )
+    {
+        ROS_INFO_STREAM("Locked the memory of the process");
+    }
+    if ( !pylon_camera_parameter_set_.acquisition_thread_cpus_.empty() &&
+         realtime::pinThreadToCPUs(pylon_camera_parameter_set_.acquisition_thread_cpus_) )
+    {
+        ROS_INFO_STREAM("Pinned the acquisition thread to "
+                << pylon_camera_parameter_set_.acquisition_thread_cpus_.size()
+                << " CPU(s)");
+    }
+    if ( pylon_camera_parameter_set_.acquisition_thread_priority_ > 0 &&
+         realtime::setThreadPriority(pylon_camera_parameter_set_.acquisition_thread_priority_) )
+    {
+        ROS_INFO_STREAM("Acquisition thread runs with SCHED_FIFO priority "
+                << pylon_camera_parameter_set_.acquisition_thread_priority_);
+    }
+}
+
+void PylonCameraNode::recordSchedulingLatency(const uint64_t& latency_ns)
+{
+    scheduling_latency_.record(latency_ns);
+    if ( latency_stats_ )
+    {
+        latency_stats_->histogram(LS_SCHEDULING).record(latency_ns);
+    }
+}
+
 const double& PylonCameraNode::frameRate() const
 {
     return pylon_camera_parameter_set_.frameRate();
@@ -810,6 +2001,19 @@ uint32_t PylonCameraNode::getNumSubscribersRect() const
     return camera_info_manager_->isCalibrated() ? img_rect_pub_->getNumSubscribers() : 0;
 }
 
+uint32_t PylonCameraNode::getNumSubscribersROI()
+{
+    boost::lock_guard<boost::mutex> lock(client_rois_mutex_);
+    uint32_t num_subscribers = 0;
+    for ( std::map<std::string, ros::Publisher>::const_iterator it = client_roi_pubs_.begin();
+          it != client_roi_pubs_.end();
+          ++it )
+    {
+        num_subscribers += it->second.getNumSubscribers();
+    }
+    return num_subscribers;
+}
+
 uint32_t PylonCameraNode::getNumSubscribers() const
 {
     return img_raw_pub_.getNumSubscribers() + img_rect_pub_->getNumSubscribers();
@@ -889,9 +2093,11 @@ void PylonCameraNode::setupInitialCameraInfo(sensor_msgs::CameraInfo& cam_info_m
     // neighborhoods of pixels into larger "super-pixels." It reduces the
     // resolution of the output image to (width / binning_x) x (height / binning_y).
     // The default values binning_x = binning_y = 0 is considered the same as
-    // binning_x = binning_y = 1 (no subsampling).
-    cam_info_msg.binning_x = pylon_camera_->currentBinningX();
-    cam_info_msg.binning_y = pylon_camera_->currentBinningY();
+    // binning_x = binning_y = 1 (no subsampling). Hence it includes the
+    // decimation.
+    const ImageGeometry geometry = pylon_camera_->currentGeometry();
+    cam_info_msg.binning_x = geometry.binning_x * geometry.decimation_x;
+    cam_info_msg.binning_y = geometry.binning_y * geometry.decimation_y;
 
     // Region of interest (subwindow of full camera resolution), given in full
     // resolution (unbinned) image coordinates. A particular ROI always denotes
@@ -935,114 +2141,344 @@ bool PylonCameraNode::waitForCamera(const ros::Duration& timeout) const
     return result;
 }
 
-bool PylonCameraNode::setBinningX(const size_t& target_binning_x,
-                                  size_t& reached_binning_x)
+bool PylonCameraNode::setGeometry(const ImageGeometry& target,
+                                  ImageGeometry& reached)
 {
-    boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
-    if ( !pylon_camera_->setBinningX(target_binning_x, reached_binning_x) )
+    TracedLockGuard lock(grab_mutex_, __func__);
+    // the grabbing is stopped from here until the derived state is rebuilt
+    ros::WallTime start = ros::WallTime::now();
+    bool success = pylon_camera_->setGeometry(target, reached);
+    if ( !success )
     {
         // retry till timeout
         ros::Rate r(10.0);
         ros::Time timeout(ros::Time::now() + ros::Duration(2.0));
         while ( ros::ok() )
         {
-            if ( pylon_camera_->setBinningX(target_binning_x, reached_binning_x) )
+            if ( pylon_camera_->setGeometry(target, reached) )
             {
+                success = true;
                 break;
             }
             if ( ros::Time::now() > timeout )
             {
-                ROS_ERROR_STREAM("Error in setBinningX(): Unable to set target "
-                << "binning_x factor before timeout");
-                CameraInfoPtr cam_info(new CameraInfo(camera_info_manager_->getCameraInfo()));
-                cam_info->binning_x = pylon_camera_->currentBinningX();
-                camera_info_manager_->setCameraInfo(*cam_info);
-                img_raw_msg_.width = pylon_camera_->imageCols();
-                // step = full row length in bytes, img_size = (step * rows), imagePixelDepth
-                // already contains the number of channels
-                img_raw_msg_.step = img_raw_msg_.width * pylon_camera_->imagePixelDepth();
-                return false;
+                ROS_ERROR_STREAM("Error in setGeometry(): Unable to set target "
+                    << "binning = [" << target.binning_x << ", "
+                    << target.binning_y << "], decimation = ["
+                    << target.decimation_x << ", " << target.decimation_y
+                    << "], roi = [" << target.roi_offset_x
+                    << ", " << target.roi_offset_y << ", " << target.roi_width
+                    << ", " << target.roi_height << "] before timeout");
+                break;
             }
             r.sleep();
         }
     }
+    updateGeometryDependentState();
+    last_geometry_downtime_ms_ = (ros::WallTime::now() - start).toSec() * 1e3;
+    ROS_INFO_STREAM("Changed the image geometry to binning = ["
+            << reached.binning_x << ", " << reached.binning_y << "], decimation = ["
+            << reached.decimation_x << ", " << reached.decimation_y << "], roi = ["
+            << reached.roi_offset_x << ", " << reached.roi_offset_y << ", "
+            << reached.roi_width << ", " << reached.roi_height << "], "
+            << pylon_camera_->imageCols() << "x" << pylon_camera_->imageRows()
+            << " pixels, max possible frame rate = "
+            << pylon_camera_->maxPossibleFramerate() << " Hz, grabbing was "
+            << "interrupted for " << last_geometry_downtime_ms_ << " ms");
+    return success;
+}
+
+void PylonCameraNode::updateGeometryDependentState()
+{
+    current_geometry_ = pylon_camera_->currentGeometry();
+    const ImageGeometry& geometry = current_geometry_;
     CameraInfoPtr cam_info(new CameraInfo(camera_info_manager_->getCameraInfo()));
-    cam_info->binning_x = pylon_camera_->currentBinningX();
+    // the binning of the CameraInfo covers any subsampling, hence the
+    // decimation as well
+    cam_info->binning_x = geometry.binning_x * geometry.decimation_x;
+    cam_info->binning_y = geometry.binning_y * geometry.decimation_y;
+    // the roi is given in unbinned sensor pixels, the rectification of the
+    // image_geometry takes it into account
+    cam_info->roi.x_offset = geometry.roi_offset_x;
+    cam_info->roi.y_offset = geometry.roi_offset_y;
+    cam_info->roi.width = geometry.roi_width;
+    cam_info->roi.height = geometry.roi_height;
     camera_info_manager_->setCameraInfo(*cam_info);
+    img_raw_msg_.height = pylon_camera_->imageRows();
     img_raw_msg_.width = pylon_camera_->imageCols();
     // step = full row length in bytes, img_size = (step * rows), imagePixelDepth
     // already contains the number of channels
     img_raw_msg_.step = img_raw_msg_.width * pylon_camera_->imagePixelDepth();
-    setupSamplingIndices(sampling_indices_,
-                         pylon_camera_->imageRows(),
-                         pylon_camera_->imageCols(),
-                         pylon_camera_parameter_set_.downsampling_factor_exp_search_);
+    img_raw_msg_.data.reserve(pylon_camera_->imageSize());
+    setupBrightnessSampling();
+
+    // the GigE bandwidth is planned for the new AOI, a larger one might not
+    // reach the current frame rate any more
+    if ( pylon_camera_parameter_set_.frameRate() > pylon_camera_->maxPossibleFramerate() )
+    {
+        ROS_INFO_STREAM("Frame rate " << pylon_camera_parameter_set_.frameRate()
+                << " Hz exceeds the max possible one of the new geometry, will "
+                << "limit it to " << pylon_camera_->maxPossibleFramerate() << " Hz");
+        setFrameRate(pylon_camera_->maxPossibleFramerate());
+    }
+}
+
+bool PylonCameraNode::setBinningCallback(camera_control_msgs::SetBinning::Request &req,
+                                         camera_control_msgs::SetBinning::Response &res)
+{
+    // the current geometry must not change before the target is applied
+    TracedLockGuard lock(grab_mutex_, __func__);
+    ImageGeometry target = pylon_camera_->currentGeometry();
+    target.binning_x = req.target_binning_x;
+    target.binning_y = req.target_binning_y;
+    ImageGeometry reached;
+    res.success = setGeometry(target, reached);
+    res.reached_binning_x = static_cast<uint32_t>(reached.binning_x);
+    res.reached_binning_y = static_cast<uint32_t>(reached.binning_y);
+    return true;
+}
+
+bool PylonCameraNode::setDecimationCallback(pylon_camera::SetDecimation::Request &req,
+                                            pylon_camera::SetDecimation::Response &res)
+{
+    TracedLockGuard lock(grab_mutex_, __func__);
+    ImageGeometry target = pylon_camera_->currentGeometry();
+    target.decimation_x = std::max<size_t>(req.target_decimation_x, 1);
+    target.decimation_y = std::max<size_t>(req.target_decimation_y, 1);
+    ImageGeometry reached;
+    res.success = setGeometry(target, reached) &&
+                  reached.decimation_x == target.decimation_x &&
+                  reached.decimation_y == target.decimation_y;
+    res.reached_decimation_x = static_cast<uint32_t>(reached.decimation_x);
+    res.reached_decimation_y = static_cast<uint32_t>(reached.decimation_y);
+    return true;
+}
+
+bool PylonCameraNode::setROICallback(pylon_camera::SetROI::Request &req,
+                                     pylon_camera::SetROI::Response &res)
+{
+    TracedLockGuard lock(grab_mutex_, __func__);
+    ImageGeometry target = pylon_camera_->currentGeometry();
+    target.roi_offset_x = req.target_roi.x_offset;
+    target.roi_offset_y = req.target_roi.y_offset;
+    target.roi_width = req.target_roi.width;
+    target.roi_height = req.target_roi.height;
+    ImageGeometry reached;
+    res.success = setGeometry(target, reached);
+    res.reached_roi.x_offset = static_cast<uint32_t>(reached.roi_offset_x);
+    res.reached_roi.y_offset = static_cast<uint32_t>(reached.roi_offset_y);
+    res.reached_roi.width = static_cast<uint32_t>(reached.roi_width);
+    res.reached_roi.height = static_cast<uint32_t>(reached.roi_height);
+    res.max_frame_rate = pylon_camera_->maxPossibleFramerate();
     return true;
 }
 
-bool PylonCameraNode::setBinningY(const size_t& target_binning_y,
-                                  size_t& reached_binning_y)
+bool PylonCameraNode::registerROICallback(pylon_camera::RegisterROI::Request &req,
+                                          pylon_camera::RegisterROI::Response &res)
 {
-    boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
-    if ( !pylon_camera_->setBinningY(target_binning_y, reached_binning_y) )
+    // the id becomes the relative topic 'roi/<client_id>', global ('/foo')
+    // or private ('~foo') names would make advertise() throw after the
+    // lease has already been stored
+    std::string error;
+    if ( req.client_id.empty() ||
+         req.client_id[0] == '/' || req.client_id[0] == '~' ||
+         !ros::names::validate("roi/" + req.client_id, error) )
+    {
+        ROS_ERROR_STREAM("Error in registerROICallback(): Invalid client_id '"
+                << req.client_id << "' " << error);
+        res.success = false;
+        return true;
+    }
+
+    TracedLockGuard lock(grab_mutex_, __func__);
+    bool changed = false;
     {
-        // retry till timeout
-        ros::Rate r(10.0);
-        ros::Time timeout(ros::Time::now() + ros::Duration(2.0));
-        while ( ros::ok() )
+        boost::lock_guard<boost::mutex> rois_lock(client_rois_mutex_);
+        if ( req.lease_duration <= 0.0 )
+        {
+            changed = client_rois_.remove(req.client_id);
+            client_roi_pubs_.erase(req.client_id);
+            ROS_INFO_STREAM("Client '" << req.client_id << "' unregistered its ROI");
+        }
+        else
         {
-            if ( pylon_camera_->setBinningY(target_binning_y, reached_binning_y) )
+            sensor_msgs::RegionOfInterest roi = req.roi;
+            roi.do_rectify = false;
+            changed = client_rois_.update(
+                            req.client_id,
+                            roi,
+                            ros::Time::now() + ros::Duration(req.lease_duration));
+            std::map<std::string, ros::Publisher>::iterator it =
+                                        client_roi_pubs_.find(req.client_id);
+            if ( it == client_roi_pubs_.end() )
             {
-                break;
+                it = client_roi_pubs_.insert(std::make_pair(
+                        req.client_id,
+                        nh_.advertise<sensor_msgs::Image>("roi/" + req.client_id,
+                                                          1))).first;
+                ROS_INFO_STREAM("Client '" << req.client_id << "' registered "
+                        << "roi = [" << roi.x_offset << ", " << roi.y_offset
+                        << ", " << roi.width << ", " << roi.height << "] on "
+                        << it->second.getTopic());
             }
-            if ( ros::Time::now() > timeout )
+            res.topic = it->second.getTopic();
+        }
+    }
+
+    res.success = true;
+    if ( changed )
+    {
+        ImageGeometry reached;
+        res.success = applyClientROIs(reached);
+    }
+    res.camera_roi.x_offset = static_cast<uint32_t>(current_geometry_.roi_offset_x);
+    res.camera_roi.y_offset = static_cast<uint32_t>(current_geometry_.roi_offset_y);
+    res.camera_roi.width = static_cast<uint32_t>(current_geometry_.roi_width);
+    res.camera_roi.height = static_cast<uint32_t>(current_geometry_.roi_height);
+    return true;
+}
+
+bool PylonCameraNode::applyClientROIs(ImageGeometry& reached)
+{
+    TracedLockGuard lock(grab_mutex_, __func__);
+    ImageGeometry target = current_geometry_;
+    {
+        boost::lock_guard<boost::mutex> rois_lock(client_rois_mutex_);
+        sensor_msgs::RegionOfInterest box;
+        if ( client_rois_.boundingBox(box) )
+        {
+            if ( !geometry_before_clients_valid_ )
             {
-                ROS_ERROR_STREAM("Error in setBinningY(): Unable to set target "
-                    << "binning_y factor before timeout");
-                CameraInfoPtr cam_info(new CameraInfo(camera_info_manager_->getCameraInfo()));
-                cam_info->binning_y = pylon_camera_->currentBinningY();
-                camera_info_manager_->setCameraInfo(*cam_info);
-                img_raw_msg_.height = pylon_camera_->imageRows();
-                // step = full row length in bytes, img_size = (step * rows), imagePixelDepth
-                // already contains the number of channels
-                img_raw_msg_.step = img_raw_msg_.width * pylon_camera_->imagePixelDepth();
-                return false;
+                geometry_before_clients_ = current_geometry_;
+                geometry_before_clients_valid_ = true;
             }
-            r.sleep();
+            target.roi_offset_x = box.x_offset;
+            target.roi_offset_y = box.y_offset;
+            target.roi_width = box.width;
+            target.roi_height = box.height;
+        }
+        else if ( geometry_before_clients_valid_ )
+        {
+            target.roi_offset_x = geometry_before_clients_.roi_offset_x;
+            target.roi_offset_y = geometry_before_clients_.roi_offset_y;
+            target.roi_width = geometry_before_clients_.roi_width;
+            target.roi_height = geometry_before_clients_.roi_height;
+            geometry_before_clients_valid_ = false;
+        }
+        else
+        {
+            reached = current_geometry_;
+            return true;
         }
     }
-    CameraInfoPtr cam_info(new CameraInfo(camera_info_manager_->getCameraInfo()));
-    cam_info->binning_y = pylon_camera_->currentBinningY();
-    camera_info_manager_->setCameraInfo(*cam_info);
-    img_raw_msg_.height = pylon_camera_->imageRows();
-    // step = full row length in bytes, img_size = (step * rows), imagePixelDepth
-    // already contains the number of channels
-    img_raw_msg_.step = img_raw_msg_.width * pylon_camera_->imagePixelDepth();
-    setupSamplingIndices(sampling_indices_,
-                         pylon_camera_->imageRows(),
-                         pylon_camera_->imageCols(),
-                         pylon_camera_parameter_set_.downsampling_factor_exp_search_);
-    return true;
+    return setGeometry(target, reached);
 }
 
-bool PylonCameraNode::setBinningCallback(camera_control_msgs::SetBinning::Request &req,
-                                         camera_control_msgs::SetBinning::Response &res)
+void PylonCameraNode::expireClientROIs()
 {
-    size_t reached_binning_x, reached_binning_y;
-    bool success_x = setBinningX(req.target_binning_x,
-                                 reached_binning_x);
-    bool success_y = setBinningY(req.target_binning_y,
-                                 reached_binning_y);
-    res.reached_binning_x = static_cast<uint32_t>(reached_binning_x);
-    res.reached_binning_y = static_cast<uint32_t>(reached_binning_y);
-    res.success = success_x && success_y;
-    return true;
+    std::vector<std::string> expired;
+    {
+        boost::lock_guard<boost::mutex> rois_lock(client_rois_mutex_);
+        if ( client_rois_.size() == 0 )
+        {
+            return;
+        }
+        expired = client_rois_.expire(ros::Time::now());
+        for ( std::size_t i = 0; i < expired.size(); ++i )
+        {
+            client_roi_pubs_.erase(expired[i]);
+            ROS_INFO_STREAM("The ROI lease of client '" << expired[i]
+                    << "' expired");
+        }
+    }
+    if ( !expired.empty() )
+    {
+        ImageGeometry reached;
+        applyClientROIs(reached);
+    }
+}
+
+void PylonCameraNode::publishClientROIs()
+{
+    TracedLockGuard lock(grab_mutex_, __func__);
+    boost::lock_guard<boost::mutex> rois_lock(client_rois_mutex_);
+    if ( client_roi_pubs_.empty() || img_raw_msg_.data.empty() )
+    {
+        return;
+    }
+
+    const ImageGeometry& geometry = current_geometry_;
+    const size_t subsampling_x = geometry.binning_x * geometry.decimation_x;
+    const size_t subsampling_y = geometry.binning_y * geometry.decimation_y;
+    const size_t bytes_per_pixel = img_raw_msg_.step / std::max<size_t>(img_raw_msg_.width, 1);
+    const bool bayer = sensor_msgs::image_encodings::isBayer(img_raw_msg_.encoding);
+
+    ImageView view;
+    view.header = img_raw_msg_.header;
+    view.encoding = img_raw_msg_.encoding;
+    view.is_bigendian = img_raw_msg_.is_bigendian;
+    view.data_step = img_raw_msg_.step;
+
+    for ( std::map<std::string, ros::Publisher>::const_iterator it = client_roi_pubs_.begin();
+          it != client_roi_pubs_.end();
+          ++it )
+    {
+        sensor_msgs::RegionOfInterest roi;
+        if ( it->second.getNumSubscribers() == 0 ||
+             !client_rois_.region(it->first, roi) )
+        {
+            continue;
+        }
+
+        // intersection of the client region with the camera AOI, in binned
+        // image pixels
+        const size_t aoi_x_end = geometry.roi_offset_x + geometry.roi_width;
+        const size_t aoi_y_end = geometry.roi_offset_y + geometry.roi_height;
+        const size_t x_begin = roi.width == 0 ? geometry.roi_offset_x :
+                std::max<size_t>(roi.x_offset, geometry.roi_offset_x);
+        const size_t y_begin = roi.height == 0 ? geometry.roi_offset_y :
+                std::max<size_t>(roi.y_offset, geometry.roi_offset_y);
+        const size_t x_end = roi.width == 0 ? aoi_x_end :
+                std::min<size_t>(static_cast<size_t>(roi.x_offset) + roi.width, aoi_x_end);
+        const size_t y_end = roi.height == 0 ? aoi_y_end :
+                std::min<size_t>(static_cast<size_t>(roi.y_offset) + roi.height, aoi_y_end);
+        if ( x_end <= x_begin || y_end <= y_begin )
+        {
+            continue;
+        }
+        size_t col = std::min<size_t>((x_begin - geometry.roi_offset_x) / subsampling_x,
+                                      img_raw_msg_.width);
+        size_t row = std::min<size_t>((y_begin - geometry.roi_offset_y) / subsampling_y,
+                                      img_raw_msg_.height);
+        size_t cols = std::min<size_t>((x_end - x_begin) / subsampling_x,
+                                       img_raw_msg_.width - col);
+        size_t rows = std::min<size_t>((y_end - y_begin) / subsampling_y,
+                                       img_raw_msg_.height - row);
+        if ( bayer )
+        {
+            // whole 2 x 2 cells keep the phase of the bayer_* encoding
+            alignToBayerCell(col, cols, img_raw_msg_.width);
+            alignToBayerCell(row, rows, img_raw_msg_.height);
+        }
+        if ( cols == 0 || rows == 0 )
+        {
+            continue;
+        }
+
+        view.width = static_cast<uint32_t>(cols);
+        view.height = static_cast<uint32_t>(rows);
+        view.step = static_cast<uint32_t>(cols * bytes_per_pixel);
+        view.data = &img_raw_msg_.data[row * img_raw_msg_.step + col * bytes_per_pixel];
+        // the const reference overload serializes before returning, hence
+        // the view never outlives the image buffer
+        it->second.publish(view);
+    }
 }
 
 bool PylonCameraNode::setExposure(const float& target_exposure,
                                   float& reached_exposure)
 {
-    boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
+    TracedLockGuard lock(grab_mutex_, __func__);
     if ( !pylon_camera_->isReady() )
     {
         ROS_WARN("Error in setExposure(): pylon_camera_ is not ready!");
@@ -1088,7 +2524,7 @@ bool PylonCameraNode::setExposureCallback(camera_control_msgs::SetExposure::Requ
 
 bool PylonCameraNode::setGain(const float& target_gain, float& reached_gain)
 {
-    boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
+    TracedLockGuard lock(grab_mutex_, __func__);
     if ( !pylon_camera_->isReady() )
     {
         ROS_WARN("Error in setGain(): pylon_camera_ is not ready!");
@@ -1132,7 +2568,7 @@ bool PylonCameraNode::setGainCallback(camera_control_msgs::SetGain::Request &req
 
 bool PylonCameraNode::setGamma(const float& target_gamma, float& reached_gamma)
 {
-    boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
+    TracedLockGuard lock(grab_mutex_, __func__);
     if ( !pylon_camera_->isReady() )
     {
         ROS_WARN("Error in setGamma(): pylon_camera_ is not ready!");
@@ -1179,7 +2615,24 @@ bool PylonCameraNode::setBrightness(const int& target_brightness,
                                     const bool& exposure_auto,
                                     const bool& gain_auto)
 {
-    boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
+    if ( searchBrightness(target_brightness,
+                          reached_brightness,
+                          exposure_auto,
+                          gain_auto) )
+    {
+        ++num_brightness_search_succeeded_;
+        return true;
+    }
+    ++num_brightness_search_failed_;
+    return false;
+}
+
+bool PylonCameraNode::searchBrightness(const int& target_brightness,
+                                       int& reached_brightness,
+                                       const bool& exposure_auto,
+                                       const bool& gain_auto)
+{
+    TracedLockGuard lock(grab_mutex_, __func__);
     ros::Time begin = ros::Time::now();  // time measurement for the exposure search
 
     // brightness service can only work, if an image has already been grabbed,
@@ -1357,6 +2810,7 @@ bool PylonCameraNode::setBrightness(const int& target_brightness,
         {
             // cancel all running brightness search by deactivating ExposureAuto
             pylon_camera_->disableAllRunningAutoBrightessFunctions();
+            ++num_brightness_search_timeouts_;
             ROS_WARN_STREAM("Did not reach the target brightness before "
                 << "timeout of " << (timeout - start_time).sec
                 << " sec! Stuck at brightness " << current_brightness
@@ -1419,93 +2873,223 @@ bool PylonCameraNode::setBrightnessCallback(camera_control_msgs::SetBrightness::
     return true;
 }
 
-void PylonCameraNode::setupSamplingIndices(std::vector<std::size_t>& indices,
-                                           std::size_t rows,
-                                           std::size_t cols,
-                                           int downsampling_factor)
-{
-    indices.clear();
-    std::size_t min_window_height = static_cast<float>(rows) /
-                                    static_cast<float>(downsampling_factor);
-    cv::Point2i start_pt(0, 0);
-    cv::Point2i end_pt(cols, rows);
-    // add the iamge center point only once
-    sampling_indices_.push_back(0.5 * rows * cols);
-    genSamplingIndicesRec(indices,
-                          min_window_height,
-                          start_pt,
-                          end_pt);
-    std::sort(indices.begin(), indices.end());
-    return;
-}
-
-void PylonCameraNode::genSamplingIndicesRec(std::vector<std::size_t>& indices,
-                                            const std::size_t& min_window_height,
-                                            const cv::Point2i& s,   // start
-                                            const cv::Point2i& e)   // end
-{
-    if ( static_cast<std::size_t>(std::abs(e.y - s.y)) <= min_window_height )
-    {
-        return;  // abort criteria -> shrinked window has the min_col_size
-    }
-    /*
-     * sampled img:      point:                             idx:
-     * s 0 0 0 0 0 0  a) [(e.x-s.x)*0.5, (e.y-s.y)*0.5]     a.x*a.y*0.5
-     * 0 0 0 d 0 0 0  b) [a.x,           1.5*a.y]           b.y*img_rows+b.x
-     * 0 0 0 0 0 0 0  c) [0.5*a.x,       a.y]               c.y*img_rows+c.x
-     * 0 c 0 a 0 f 0  d) [a.x,           0.5*a.y]           d.y*img_rows+d.x
-     * 0 0 0 0 0 0 0  f) [1.5*a.x,       a.y]               f.y*img_rows+f.x
-     * 0 0 0 b 0 0 0
-     * 0 0 0 0 0 0 e
-     */
-    cv::Point2i a, b, c, d, f, delta;
-    a = s + 0.5 * (e - s);  // center point
-    delta = 0.5 * (e - s);
-    b = s + cv::Point2i(delta.x,       1.5 * delta.y);
-    c = s + cv::Point2i(0.5 * delta.x, delta.y);
-    d = s + cv::Point2i(delta.x,       0.5 * delta.y);
-    f = s + cv::Point2i(1.5 * delta.x, delta.y);
-    indices.push_back(b.y * pylon_camera_->imageCols() + b.x);
-    indices.push_back(c.y * pylon_camera_->imageCols() + c.x);
-    indices.push_back(d.y * pylon_camera_->imageCols() + d.x);
-    indices.push_back(f.y * pylon_camera_->imageCols() + f.x);
-    genSamplingIndicesRec(indices, min_window_height, s, a);
-    genSamplingIndicesRec(indices, min_window_height, a, e);
-    genSamplingIndicesRec(indices, min_window_height, cv::Point2i(s.x, a.y), cv::Point2i(a.x, e.y));
-    genSamplingIndicesRec(indices, min_window_height, cv::Point2i(a.x, s.y), cv::Point2i(e.x, a.y));
-    return;
+void PylonCameraNode::setupBrightnessSampling()
+{
+    const size_t rows = pylon_camera_->imageRows();
+    const size_t cols = pylon_camera_->imageCols();
+    const std::vector<MeteringRegion>& regions =
+                                pylon_camera_parameter_set_.metering_regions_;
+    sampling_weights_.clear();
+    if ( regions.empty() )
+    {
+        image_kernels::setupSamplingIndices(sampling_indices_,
+                                            rows,
+                                            cols,
+                                            pylon_camera_parameter_set_.downsampling_factor_exp_search_);
+        return;
+    }
+
+    // metering regions in pixels of the current image and their bounding box
+    std::vector<cv::Rect> rects;
+    std::vector<float> weights;
+    cv::Rect bounding_box;
+    for ( std::size_t i = 0; i < regions.size(); ++i )
+    {
+        cv::Rect rect(cv::Point(regions[i].x * cols, regions[i].y * rows),
+                      cv::Point((regions[i].x + regions[i].width) * cols,
+                                (regions[i].y + regions[i].height) * rows));
+        rects.push_back(rect);
+        weights.push_back(regions[i].weight);
+        if ( regions[i].weight > 0.0 )
+        {
+            bounding_box = bounding_box.area() > 0 ? (bounding_box | rect) : rect;
+        }
+    }
+    image_kernels::setupWeightedSamplingIndices(sampling_indices_,
+                                                sampling_weights_,
+                                                rows,
+                                                cols,
+                                                pylon_camera_->imagePixelDepth(),
+                                                pylon_camera_parameter_set_.downsampling_factor_exp_search_,
+                                                rects,
+                                                weights,
+                                                pylon_camera_parameter_set_.metering_background_weight_);
+    if ( sampling_weights_.empty() )
+    {
+        ROS_WARN_STREAM("The metering regions do not contain any pixel with "
+            << "weight > 0, will meter the whole image");
+        image_kernels::setupSamplingIndices(sampling_indices_,
+                                            rows,
+                                            cols,
+                                            pylon_camera_parameter_set_.downsampling_factor_exp_search_);
+        return;
+    }
+
+    // the auto functions of the camera can not weight, they meter on the
+    // bounding box of the regions. Without background weight this is close
+    // to what the node meters itself.
+    if ( bounding_box.area() > 0 )
+    {
+        // the box is in pixels of the published image, the camera expects
+        // its own pixels relative to the sensor: undo the software
+        // decimation and add the ROI offset
+        const ImageGeometry& geometry = current_geometry_;
+        const size_t sw_decimation_x = pylon_camera_->softwareDecimationX();
+        const size_t sw_decimation_y = pylon_camera_->softwareDecimationY();
+        const size_t camera_subsampling_x = std::max<size_t>(
+                    geometry.binning_x * geometry.decimation_x / sw_decimation_x, 1);
+        const size_t camera_subsampling_y = std::max<size_t>(
+                    geometry.binning_y * geometry.decimation_y / sw_decimation_y, 1);
+        pylon_camera_->setAutoFunctionAOI(
+                    geometry.roi_offset_x / camera_subsampling_x + bounding_box.x * sw_decimation_x,
+                    geometry.roi_offset_y / camera_subsampling_y + bounding_box.y * sw_decimation_y,
+                    bounding_box.width * sw_decimation_x,
+                    bounding_box.height * sw_decimation_y);
+    }
 }
 
 float PylonCameraNode::calcCurrentBrightness()
 {
-    boost::lock_guard<boost::recursive_mutex> lock(grab_mutex_);
+    TracedLockGuard lock(grab_mutex_, __func__);
     if ( img_raw_msg_.data.empty() )
     {
         return 0.0;
     }
-    float sum = 0.0;
+    if ( !sampling_indices_.empty() &&
+         sampling_indices_.back() >= img_raw_msg_.data.size() )
+    {
+        // the samples are already set up for a new, larger geometry, but no
+        // image has been grabbed with it yet
+        return image_kernels::mean(img_raw_msg_.data);
+    }
+    if ( !sampling_weights_.empty() )
+    {
+        // weighted mean over the samples of the metering regions
+        return image_kernels::weightedSampledMean(img_raw_msg_.data,
+                                                  sampling_indices_,
+                                                  sampling_weights_);
+    }
     if ( sensor_msgs::image_encodings::isMono(img_raw_msg_.encoding) )
     {
         // The mean brightness is calculated using a subset of all pixels
-        for ( const std::size_t& idx : sampling_indices_ )
-        {
-           sum += img_raw_msg_.data.at(idx);
-        }
-        if ( sum > 0.0 )
-        {
-            sum /= static_cast<float>(sampling_indices_.size());
-        }
+        return image_kernels::sampledMean(img_raw_msg_.data, sampling_indices_);
     }
     else
     {
         // The mean brightness is calculated using all pixels and all channels
-        sum = std::accumulate(img_raw_msg_.data.begin(), img_raw_msg_.data.end(), 0);
-        if ( sum > 0.0 )
+        return image_kernels::mean(img_raw_msg_.data);
+    }
+}
+
+bool PylonCameraNode::detectChange()
+{
+    // the byte wise difference is meaningless for the low bytes of 16 bit
+    // values, such images are always published
+    if ( sensor_msgs::image_encodings::bitDepth(img_raw_msg_.encoding) != 8 )
+    {
+        ROS_WARN_STREAM_ONCE("Change detection is only done for encodings with "
+                << "8 bit per channel, not for " << img_raw_msg_.encoding);
+        return true;
+    }
+
+    const std::size_t row_step = pylon_camera_parameter_set_.change_row_step_;
+    const std::size_t rows = img_raw_msg_.height;
+    const std::size_t row_bytes = img_raw_msg_.step;
+    if ( img_raw_msg_.data.size() < rows * row_bytes )
+    {
+        // the geometry changed since the grab, the next image is compared
+        return true;
+    }
+    ++frames_since_publish_;
+
+    bool publish = config_applied_pending_ ||
+                   change_reference_.size() != ((rows + row_step - 1) / row_step) * row_bytes;
+    if ( !publish )
+    {
+        const float difference = image_kernels::sampledRowsMeanAbsDiff(
+                                                        img_raw_msg_.data.data(),
+                                                        rows,
+                                                        row_bytes,
+                                                        row_step,
+                                                        change_reference_);
+        if ( difference >= pylon_camera_parameter_set_.change_threshold_ )
+        {
+            publish = true;
+        }
+        else if ( frames_since_publish_ >= pylon_camera_parameter_set_.change_keyframe_interval_ )
         {
-            sum /= static_cast<float>(img_raw_msg_.data.size());
+            publish = true;
+            ++num_keyframes_;
         }
     }
-    return sum;
+
+    if ( !publish )
+    {
+        ++num_unchanged_skipped_;
+        return false;
+    }
+    image_kernels::copySampledRows(img_raw_msg_.data.data(),
+                                   rows,
+                                   row_bytes,
+                                   row_step,
+                                   change_reference_);
+    frames_since_publish_ = 0;
+    return true;
+}
+
+void PylonCameraNode::publishSharpness()
+{
+    namespace enc = sensor_msgs::image_encodings;
+    TracedLockGuard lock(grab_mutex_, __func__);
+    const std::string& encoding = img_raw_msg_.encoding;
+    if ( enc::bitDepth(encoding) != 8 || img_raw_msg_.width == 0 )
+    {
+        ROS_WARN_STREAM_ONCE("Sharpness is only computed for encodings with "
+                << "8 bit per channel, not for " << encoding);
+        return;
+    }
+    if ( img_raw_msg_.data.size() < img_raw_msg_.height * img_raw_msg_.step )
+    {
+        // the geometry changed since the grab
+        return;
+    }
+
+    // the neighbours of the Laplacian have to be of the same channel
+    const std::size_t bytes_per_pixel = img_raw_msg_.step / img_raw_msg_.width;
+    std::size_t dx = bytes_per_pixel;
+    std::size_t dy = 1;
+    if ( enc::isBayer(encoding) )
+    {
+        dx = 2;
+        dy = 2;
+    }
+    else if ( encoding == enc::YUV422 )
+    {
+        // UYVY, same position in the next macro pixel
+        dx = 4;
+    }
+
+    const std::vector<float>& roi = pylon_camera_parameter_set_.sharpness_roi_;
+    cv::Rect area(0, 0, img_raw_msg_.step, img_raw_msg_.height);
+    if ( !roi.empty() )
+    {
+        area = cv::Rect(static_cast<int>(roi[0] * img_raw_msg_.width) * bytes_per_pixel,
+                        static_cast<int>(roi[1] * img_raw_msg_.height),
+                        static_cast<int>(roi[2] * img_raw_msg_.width) * bytes_per_pixel,
+                        static_cast<int>(roi[3] * img_raw_msg_.height));
+    }
+
+    pylon_camera::Sharpness msg;
+    msg.header = img_raw_msg_.header;
+    msg.sharpness = image_kernels::laplacianVariance(
+                            img_raw_msg_.data.data(),
+                            img_raw_msg_.height,
+                            img_raw_msg_.step,
+                            area,
+                            dx,
+                            dy,
+                            pylon_camera_parameter_set_.sharpness_row_step_);
+    sharpness_pub_.publish(msg);
 }
 
 bool PylonCameraNode::setSleepingCallback(camera_control_msgs::SetSleeping::Request &req,
@@ -1533,10 +3117,47 @@ bool PylonCameraNode::isSleeping()
 
 PylonCameraNode::~PylonCameraNode()
 {
+    // no callback may run while the members are deleted
+    control_spinner_.stop();
+    action_spinner_.stop();
+    history_spinner_.stop();
+    info_spinner_.stop();
+    trigger_spinner_.stop();
     delete pylon_camera_;
     pylon_camera_ = NULL;
+    delete preview_publisher_;
+    preview_publisher_ = nullptr;
     delete it_;
     it_ = NULL;
+    delete img_raw_queue_monitor_;
+    img_raw_queue_monitor_ = nullptr;
+    delete img_rect_queue_monitor_;
+    img_rect_queue_monitor_ = nullptr;
+    delete latency_stats_;
+    latency_stats_ = nullptr;
+    delete img_raw_diagnostic_;
+    img_raw_diagnostic_ = nullptr;
+    delete grab_imgs_rect_as_;
+    grab_imgs_rect_as_ = nullptr;
+    delete grab_imgs_buffer_pool_;
+    grab_imgs_buffer_pool_ = nullptr;
+    delete frame_history_;
+    frame_history_ = nullptr;
+    delete img_rect_pub_;
+    img_rect_pub_ = nullptr;
+    delete pinhole_model_;
+    pinhole_model_ = nullptr;
+    delete cv_bridge_img_rect_;
+    cv_bridge_img_rect_ = nullptr;
+    delete camera_info_manager_;
+    camera_info_manager_ = nullptr;
+    delete reconfigure_server_;
+    reconfigure_server_ = nullptr;
+    for ( auto& entry : service_latency_ )
+    {
+        delete entry.second;
+    }
+    service_latency_.clear();
 }
 
 }  // namespace pylon_camera
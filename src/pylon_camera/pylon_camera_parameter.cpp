@@ -29,41 +29,34 @@
 
 #include <pylon_camera/pylon_camera_parameter.h>
 #include <sensor_msgs/image_encodings.h>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
 
 namespace pylon_camera
 {
 
 PylonCameraParameter::PylonCameraParameter() :
-        camera_frame_("pylon_camera"),
-        device_user_id_(""),
-        frame_rate_(5.0),
-        camera_info_url_(""),
-        image_encoding_(""),
-        binning_x_(1),
-        binning_y_(1),
-        binning_x_given_(false),
-        binning_y_given_(false),
-        downsampling_factor_exp_search_(1),
-        // ##########################
-        //  image intensity settings
-        // ##########################
-        exposure_(10000.0),
-        exposure_given_(false),
-        gain_(0.5),
-        gain_given_(false),
-        gamma_(1.0),
-        gamma_given_(false),
-        brightness_(100),
-        brightness_given_(false),
-        brightness_continuous_(false),
-        exposure_auto_(true),
-        gain_auto_(true),
-        // #########################
-        exposure_search_timeout_(5.),
-        auto_exp_upper_lim_(0.0),
-        mtu_size_(3000),
-        inter_pkg_delay_(1000),
-        shutter_mode_(SM_DEFAULT)
+        PylonCameraSettings(),
+        image_raw_queue_size_(1),
+        image_rect_queue_size_(1),
+        grab_images_pool_size_(10),
+        frame_history_size_(0),
+        frame_history_duration_(0.0),
+        frame_history_max_memory_(512.0),
+        publisher_stats_rate_(1.0),
+        latency_stats_rate_(0.0),
+        triggered_image_topic_(""),
+        trigger_exposure_(-1.0),
+        trigger_gain_(-1.0),
+        publish_sharpness_(false),
+        sharpness_roi_(),
+        sharpness_row_step_(4),
+        change_threshold_(0.0),
+        change_keyframe_interval_(30),
+        change_row_step_(8),
+        preview_rate_(0.0),
+        preview_max_width_(320)
 {}
 
 PylonCameraParameter::~PylonCameraParameter()
@@ -122,10 +115,103 @@ void PylonCameraParameter::readFromRosParameterServer(const ros::NodeHandle& nh)
             binning_y_ = static_cast<size_t>(binning_y);
         }
     }
+    decimation_x_given_ = nh.hasParam("decimation_x");
+    if ( decimation_x_given_ )
+    {
+        int decimation_x;
+        nh.getParam("decimation_x", decimation_x);
+        if ( decimation_x > 32 || decimation_x < 1 )
+        {
+            ROS_WARN_STREAM("Desired horizontal decimation_x factor not in "
+                << "valid range! Decimation x = " << decimation_x << ". Will "
+                << "reset it to default value (1)");
+            decimation_x_given_ = false;
+        }
+        else
+        {
+            decimation_x_ = static_cast<size_t>(decimation_x);
+        }
+    }
+    decimation_y_given_ = nh.hasParam("decimation_y");
+    if ( decimation_y_given_ )
+    {
+        int decimation_y;
+        nh.getParam("decimation_y", decimation_y);
+        if ( decimation_y > 32 || decimation_y < 1 )
+        {
+            ROS_WARN_STREAM("Desired vertical decimation_y factor not in "
+                << "valid range! Decimation y = " << decimation_y << ". Will "
+                << "reset it to default value (1)");
+            decimation_y_given_ = false;
+        }
+        else
+        {
+            decimation_y_ = static_cast<size_t>(decimation_y);
+        }
+    }
+    roi_given_ = false;
+    const std::string roi_names[4] = { "roi_offset_x", "roi_offset_y",
+                                       "roi_width", "roi_height" };
+    size_t* roi_values[4] = { &roi_offset_x_, &roi_offset_y_,
+                              &roi_width_, &roi_height_ };
+    for ( std::size_t i = 0; i < 4; ++i )
+    {
+        if ( nh.hasParam(roi_names[i]) )
+        {
+            int value;
+            nh.getParam(roi_names[i], value);
+            if ( value < 0 )
+            {
+                ROS_WARN_STREAM("Desired " << roi_names[i] << " is negative! "
+                    << "Will reset it to default value (0)");
+                value = 0;
+            }
+            *roi_values[i] = static_cast<size_t>(value);
+            roi_given_ = true;
+        }
+    }
     nh.param<int>("downsampling_factor_exposure_search",
                   downsampling_factor_exp_search_,
                   20);
 
+    // metering_regions: [[x, y, width, height, (weight)], ...]
+    metering_regions_.clear();
+    if ( nh.hasParam("metering_regions") )
+    {
+        XmlRpc::XmlRpcValue regions;
+        nh.getParam("metering_regions", regions);
+        if ( regions.getType() == XmlRpc::XmlRpcValue::TypeArray )
+        {
+            for ( int i = 0; i < regions.size(); ++i )
+            {
+                MeteringRegion region;
+                if ( !parseMeteringRegion(regions[i], region) )
+                {
+                    ROS_WARN_STREAM("Metering region " << i << " is invalid, "
+                        << "expected [x, y, width, height, weight] with "
+                        << "fractions of the image in [0, 1] and weight >= 0. "
+                        << "Will ignore it");
+                    continue;
+                }
+                metering_regions_.push_back(region);
+            }
+        }
+        else
+        {
+            ROS_WARN_STREAM("metering_regions has to be a list of regions. "
+                << "Will meter the whole image");
+        }
+    }
+    nh.param<float>("metering_background_weight",
+                    metering_background_weight_,
+                    0.0);
+    if ( metering_background_weight_ < 0.0 )
+    {
+        ROS_WARN_STREAM("Desired metering_background_weight is negative! "
+            << "Will reset it to default value (0.0)");
+        metering_background_weight_ = 0.0;
+    }
+
     if ( nh.hasParam("image_encoding") )
     {
         std::string encoding;
@@ -214,11 +300,18 @@ void PylonCameraParameter::readFromRosParameterServer(const ros::NodeHandle& nh)
         nh.getParam("gige/mtu_size", mtu_size_);
     }
 
-    if ( nh.hasParam("gige/inter_pkg_delay") )
+    inter_pkg_delay_given_ = nh.hasParam("gige/inter_pkg_delay");
+    if ( inter_pkg_delay_given_ )
     {
         nh.getParam("gige/inter_pkg_delay", inter_pkg_delay_);
     }
 
+    nh.param<bool>("gige/plan_bandwidth", plan_bandwidth_, true);
+    nh.param<int>("gige/num_cameras", num_cameras_on_link_, 1);
+    nh.param<int>("gige/camera_index", camera_index_on_link_, 0);
+    nh.param<double>("gige/link_speed", link_speed_, 1000.0);
+    nh.param<double>("gige/link_headroom", link_headroom_, 0.9);
+
     std::string shutter_param_string;
     nh.param<std::string>("shutter_mode", shutter_param_string, "");
     if ( shutter_param_string == "rolling" )
@@ -238,6 +331,50 @@ void PylonCameraParameter::readFromRosParameterServer(const ros::NodeHandle& nh)
         shutter_mode_ = SM_DEFAULT;
     }
 
+    std::string persistence_param_string;
+    nh.param<std::string>("feature_persistence", persistence_param_string, "");
+    if ( persistence_param_string == "user_set" )
+    {
+        feature_persistence_ = FP_USER_SET;
+    }
+    else if ( persistence_param_string == "file" )
+    {
+        feature_persistence_ = FP_FILE;
+    }
+    else
+    {
+        feature_persistence_ = FP_NONE;
+    }
+    nh.param<std::string>("feature_persistence_user_set",
+                          feature_persistence_user_set_, "UserSet1");
+    nh.param<std::string>("feature_persistence_file",
+                          feature_persistence_file_, "");
+
+    nh.param<int>("image_raw_queue_size", image_raw_queue_size_, 1);
+    nh.param<int>("image_rect_queue_size", image_rect_queue_size_, 1);
+    nh.param<int>("grab_images_pool_size", grab_images_pool_size_, 10);
+    nh.param<int>("frame_history_size", frame_history_size_, 0);
+    nh.param<double>("frame_history_duration", frame_history_duration_, 0.0);
+    nh.param<double>("frame_history_max_memory", frame_history_max_memory_, 512.0);
+    nh.param<double>("publisher_stats_rate", publisher_stats_rate_, 1.0);
+    nh.param<double>("latency_stats_rate", latency_stats_rate_, 0.0);
+    nh.param<int>("acquisition_thread_priority", acquisition_thread_priority_, 0);
+    nh.param<std::vector<int> >("acquisition_thread_cpus",
+                                acquisition_thread_cpus_, std::vector<int>());
+    nh.param<bool>("lock_memory", lock_memory_, false);
+    nh.param<int>("grab_engine_thread_priority", grab_engine_thread_priority_, 0);
+    nh.param<std::string>("triggered_image_topic", triggered_image_topic_, "");
+    nh.param<float>("trigger_exposure", trigger_exposure_, -1.0);
+    nh.param<float>("trigger_gain", trigger_gain_, -1.0);
+    nh.param<bool>("publish_sharpness", publish_sharpness_, false);
+    nh.param<std::vector<float> >("sharpness_roi", sharpness_roi_, std::vector<float>());
+    nh.param<int>("sharpness_row_step", sharpness_row_step_, 4);
+    nh.param<double>("change_threshold", change_threshold_, 0.0);
+    nh.param<int>("change_keyframe_interval", change_keyframe_interval_, 30);
+    nh.param<int>("change_row_step", change_row_step_, 8);
+    nh.param<double>("preview_rate", preview_rate_, 0.0);
+    nh.param<int>("preview_max_width", preview_max_width_, 320);
+
     validateParameterSet(nh);
     return;
 }
@@ -286,52 +423,202 @@ void PylonCameraParameter::validateParameterSet(const ros::NodeHandle& nh)
         brightness_given_ = false;
     }
 
-    if ( exposure_search_timeout_ < 5.)
+    if ( image_raw_queue_size_ < 0 )
     {
-        ROS_WARN_STREAM("Low timeout for exposure search detected! Exposure "
-            << "search may fail.");
+        ROS_WARN_STREAM("Desired image_raw queue size (" << image_raw_queue_size_
+                << ") is negative! Will reset it to default value (1)");
+        image_raw_queue_size_ = 1;
     }
-    return;
-}
 
-const std::string& PylonCameraParameter::deviceUserID() const
-{
-    return device_user_id_;
-}
+    if ( image_rect_queue_size_ < 0 )
+    {
+        ROS_WARN_STREAM("Desired image_rect queue size (" << image_rect_queue_size_
+                << ") is negative! Will reset it to default value (1)");
+        image_rect_queue_size_ = 1;
+    }
 
-std::string PylonCameraParameter::shutterModeString() const
-{
-    if ( shutter_mode_ == SM_ROLLING )
+    if ( grab_images_pool_size_ < 0 )
     {
-        return "rolling";
+        ROS_WARN_STREAM("Negative GrabImages pool size (" << grab_images_pool_size_
+                << ") detected! Will disable the pool");
+        grab_images_pool_size_ = 0;
     }
-    else if ( shutter_mode_ == SM_GLOBAL )
+
+    if ( frame_history_size_ < 0 || frame_history_duration_ < 0.0 ||
+         frame_history_max_memory_ < 0.0 )
     {
-        return "global";
+        ROS_WARN_STREAM("Invalid frame history (size = " << frame_history_size_
+                << ", duration = " << frame_history_duration_ << " s, max "
+                << "memory = " << frame_history_max_memory_ << " MB)! Will "
+                << "disable the frame history");
+        frame_history_size_ = 0;
     }
-    else if ( shutter_mode_ == SM_GLOBAL_RESET_RELEASE )
+
+    if ( publisher_stats_rate_ < 0.0 )
     {
-        return "global_reset";
+        ROS_WARN_STREAM("Negative publisher stats rate (" << publisher_stats_rate_
+                << ") detected! Will disable the publisher statistics");
+        publisher_stats_rate_ = 0.0;
     }
-    else
+
+    if ( latency_stats_rate_ < 0.0 )
     {
-        return "default_shutter_mode";
+        ROS_WARN_STREAM("Negative latency stats rate (" << latency_stats_rate_
+                << ") detected! Will disable the latency statistics");
+        latency_stats_rate_ = 0.0;
     }
-}
 
-const std::string& PylonCameraParameter::imageEncoding() const
-{
-    return image_encoding_;
-}
+    if ( acquisition_thread_priority_ < 0 || acquisition_thread_priority_ > 99 )
+    {
+        ROS_WARN_STREAM("Acquisition thread priority (" << acquisition_thread_priority_
+                << ") not in the SCHED_FIFO range [1 - 99]! Will keep the "
+                << "normal scheduling");
+        acquisition_thread_priority_ = 0;
+    }
 
-const std::string& PylonCameraParameter::cameraFrame() const
-{
-    return camera_frame_;
+    if ( grab_engine_thread_priority_ < 0 || grab_engine_thread_priority_ > 99 )
+    {
+        ROS_WARN_STREAM("Grab engine thread priority (" << grab_engine_thread_priority_
+                << ") not in range [1 - 99]! Will keep the default of pylon");
+        grab_engine_thread_priority_ = 0;
+    }
+
+    if ( trigger_exposure_ > 1e7 || trigger_gain_ > 1.0 )
+    {
+        ROS_WARN_STREAM("Trigger exposure (" << trigger_exposure_ << " us) or "
+                << "gain (" << trigger_gain_ << ") out of range! Triggered "
+                << "images will keep the current values");
+        trigger_exposure_ = -1.0;
+        trigger_gain_ = -1.0;
+    }
+
+    if ( !sharpness_roi_.empty() &&
+         ( sharpness_roi_.size() != 4 ||
+           *std::min_element(sharpness_roi_.begin(), sharpness_roi_.end()) < 0.0 ||
+           *std::max_element(sharpness_roi_.begin(), sharpness_roi_.end()) > 1.0 ||
+           sharpness_roi_[2] <= 0.0 || sharpness_roi_[3] <= 0.0 ) )
+    {
+        ROS_WARN_STREAM("Sharpness ROI has to be [x, y, width, height] with "
+                << "fractions of the image in [0, 1]! Will compute the "
+                << "sharpness on the whole image");
+        sharpness_roi_.clear();
+    }
+
+    if ( sharpness_row_step_ < 1 )
+    {
+        ROS_WARN_STREAM("Desired sharpness_row_step (" << sharpness_row_step_
+                << ") is smaller than 1! Will reset it to default value (4)");
+        sharpness_row_step_ = 4;
+    }
+
+    if ( change_threshold_ < 0.0 )
+    {
+        ROS_WARN_STREAM("Desired change_threshold (" << change_threshold_
+                << ") is negative! Will disable the change detection");
+        change_threshold_ = 0.0;
+    }
+
+    if ( change_keyframe_interval_ < 1 )
+    {
+        ROS_WARN_STREAM("Desired change_keyframe_interval (" << change_keyframe_interval_
+                << ") is smaller than 1! Will reset it to default value (30)");
+        change_keyframe_interval_ = 30;
+    }
+
+    if ( change_row_step_ < 1 )
+    {
+        ROS_WARN_STREAM("Desired change_row_step (" << change_row_step_
+                << ") is smaller than 1! Will reset it to default value (8)");
+        change_row_step_ = 8;
+    }
+
+    if ( preview_rate_ < 0.0 )
+    {
+        ROS_WARN_STREAM("Desired preview_rate (" << preview_rate_
+                << ") is negative! Will disable the preview");
+        preview_rate_ = 0.0;
+    }
+
+    if ( preview_max_width_ < 1 )
+    {
+        ROS_WARN_STREAM("Desired preview_max_width (" << preview_max_width_
+                << ") is smaller than 1! Will reset it to default value (320)");
+        preview_max_width_ = 320;
+    }
+
+    if ( num_cameras_on_link_ < 1 ||
+         camera_index_on_link_ < 0 ||
+         camera_index_on_link_ >= num_cameras_on_link_ )
+    {
+        ROS_WARN_STREAM("Invalid camera index " << camera_index_on_link_
+                << " of " << num_cameras_on_link_ << " cameras on the GigE "
+                << "link! Will plan the bandwidth for a single camera");
+        num_cameras_on_link_ = 1;
+        camera_index_on_link_ = 0;
+    }
+
+    if ( link_speed_ <= 0.0 || link_headroom_ <= 0.0 || link_headroom_ > 1.0 )
+    {
+        ROS_WARN_STREAM("Invalid GigE link speed (" << link_speed_ << " Mbit/s) "
+                << "or headroom (" << link_headroom_ << ")! Will reset them to "
+                << "default values (1000 Mbit/s, 0.9)");
+        link_speed_ = 1000.0;
+        link_headroom_ = 0.9;
+    }
+
+    if ( exposure_search_timeout_ < 5.)
+    {
+        ROS_WARN_STREAM("Low timeout for exposure search detected! Exposure "
+            << "search may fail.");
+    }
+
+    if ( feature_persistence_ != FP_NONE && feature_persistence_file_.empty() )
+    {
+        // one file per node, below $ROS_HOME like the camera_info files
+        const char* ros_home = std::getenv("ROS_HOME");
+        const char* home = std::getenv("HOME");
+        std::string dir = ros_home ? ros_home
+                                   : std::string(home ? home : ".") + "/.ros";
+        std::string name = nh.getNamespace();
+        std::replace(name.begin(), name.end(), '/', '_');
+        feature_persistence_file_ = dir + "/pylon_camera" + name + ".pfs";
+    }
+    return;
 }
 
-const double& PylonCameraParameter::frameRate() const
+bool PylonCameraParameter::parseMeteringRegion(XmlRpc::XmlRpcValue& value,
+                                               MeteringRegion& region) const
 {
-    return frame_rate_;
+    if ( value.getType() != XmlRpc::XmlRpcValue::TypeArray ||
+         value.size() < 4 || value.size() > 5 )
+    {
+        return false;
+    }
+    float numbers[5] = { 0.0, 0.0, 0.0, 0.0, 1.0 };
+    for ( int i = 0; i < value.size(); ++i )
+    {
+        if ( value[i].getType() == XmlRpc::XmlRpcValue::TypeDouble )
+        {
+            numbers[i] = static_cast<double>(value[i]);
+        }
+        else if ( value[i].getType() == XmlRpc::XmlRpcValue::TypeInt )
+        {
+            numbers[i] = static_cast<int>(value[i]);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    region.x = numbers[0];
+    region.y = numbers[1];
+    region.width = numbers[2];
+    region.height = numbers[3];
+    region.weight = numbers[4];
+    return region.x >= 0.0 && region.y >= 0.0 &&
+           region.width > 0.0 && region.height > 0.0 &&
+           region.x + region.width <= 1.0 && region.y + region.height <= 1.0 &&
+           region.weight >= 0.0;
 }
 
 void PylonCameraParameter::setFrameRate(const ros::NodeHandle& nh,
@@ -341,11 +628,6 @@ void PylonCameraParameter::setFrameRate(const ros::NodeHandle& nh,
     nh.setParam("frame_rate", frame_rate_);
 }
 
-const std::string& PylonCameraParameter::cameraInfoURL() const
-{
-    return camera_info_url_;
-}
-
 void PylonCameraParameter::setCameraInfoURL(const ros::NodeHandle& nh,
                                             const std::string& camera_info_url)
 {
@@ -0,0 +1,205 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/pylon_camera_settings.h>
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+
+namespace pylon_camera
+{
+
+PylonCameraSettings::PylonCameraSettings() :
+        camera_frame_("pylon_camera"),
+        device_user_id_(""),
+        frame_rate_(5.0),
+        camera_info_url_(""),
+        image_encoding_(""),
+        binning_x_(1),
+        binning_y_(1),
+        binning_x_given_(false),
+        binning_y_given_(false),
+        decimation_x_(1),
+        decimation_y_(1),
+        decimation_x_given_(false),
+        decimation_y_given_(false),
+        roi_offset_x_(0),
+        roi_offset_y_(0),
+        roi_width_(0),
+        roi_height_(0),
+        roi_given_(false),
+        downsampling_factor_exp_search_(1),
+        metering_regions_(),
+        metering_background_weight_(0.0),
+        // ##########################
+        //  image intensity settings
+        // ##########################
+        exposure_(10000.0),
+        exposure_given_(false),
+        gain_(0.5),
+        gain_given_(false),
+        gamma_(1.0),
+        gamma_given_(false),
+        brightness_(100),
+        brightness_given_(false),
+        brightness_continuous_(false),
+        exposure_auto_(true),
+        gain_auto_(true),
+        // #########################
+        exposure_search_timeout_(5.),
+        auto_exp_upper_lim_(0.0),
+        mtu_size_(3000),
+        inter_pkg_delay_(1000),
+        inter_pkg_delay_given_(false),
+        plan_bandwidth_(true),
+        num_cameras_on_link_(1),
+        camera_index_on_link_(0),
+        link_speed_(1000.0),
+        link_headroom_(0.9),
+        shutter_mode_(SM_DEFAULT),
+        feature_persistence_(FP_NONE),
+        feature_persistence_user_set_("UserSet1"),
+        feature_persistence_file_(""),
+        acquisition_thread_priority_(0),
+        acquisition_thread_cpus_(),
+        lock_memory_(false),
+        grab_engine_thread_priority_(0)
+{}
+
+PylonCameraSettings::~PylonCameraSettings()
+{}
+
+const std::string& PylonCameraSettings::deviceUserID() const
+{
+    return device_user_id_;
+}
+
+std::string PylonCameraSettings::shutterModeString() const
+{
+    if ( shutter_mode_ == SM_ROLLING )
+    {
+        return "rolling";
+    }
+    else if ( shutter_mode_ == SM_GLOBAL )
+    {
+        return "global";
+    }
+    else if ( shutter_mode_ == SM_GLOBAL_RESET_RELEASE )
+    {
+        return "global_reset";
+    }
+    else
+    {
+        return "default_shutter_mode";
+    }
+}
+
+std::string PylonCameraSettings::featurePersistenceString() const
+{
+    if ( feature_persistence_ == FP_USER_SET )
+    {
+        return "user_set";
+    }
+    else if ( feature_persistence_ == FP_FILE )
+    {
+        return "file";
+    }
+    else
+    {
+        return "none";
+    }
+}
+
+std::string PylonCameraSettings::featureSetFingerprint(
+                                    const std::string& device_identity) const
+{
+    // everything which is written to the camera during a cold start, bump
+    // the version whenever the startup configuration itself changes. The
+    // frame rate is left out: the node clamps it to the camera's maximum
+    // after the feature set is written, and restoreHostState() plans the
+    // bandwidth for the current one on each warm start.
+    std::ostringstream config;
+    config << "v2|" << device_identity << "|" << image_encoding_ << "|"
+           << shutter_mode_ << "|"
+           << binning_x_given_ << binning_x_ << "|"
+           << binning_y_given_ << binning_y_ << "|"
+           << decimation_x_given_ << decimation_x_ << "|"
+           << decimation_y_given_ << decimation_y_ << "|"
+           << roi_given_ << roi_offset_x_ << "," << roi_offset_y_ << ","
+           << roi_width_ << "," << roi_height_ << "|"
+           << exposure_given_ << exposure_ << "|"
+           << gain_given_ << gain_ << "|"
+           << gamma_given_ << gamma_ << "|"
+           << brightness_given_ << brightness_ << brightness_continuous_
+           << exposure_auto_ << gain_auto_ << "|"
+           << auto_exp_upper_lim_ << "|"
+           << mtu_size_ << "|" << inter_pkg_delay_given_ << inter_pkg_delay_
+           << "|" << plan_bandwidth_ << num_cameras_on_link_ << ","
+           << camera_index_on_link_ << "," << link_speed_ << ","
+           << link_headroom_ << "|" << metering_background_weight_;
+    for ( const MeteringRegion& region : metering_regions_ )
+    {
+        config << "|" << region.x << "," << region.y << "," << region.width
+               << "," << region.height << "," << region.weight;
+    }
+
+    // 64 bit FNV-1a, stable across builds unlike std::hash
+    const std::string data = config.str();
+    uint64_t hash = 14695981039346656037ULL;
+    for ( const char& c : data )
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ULL;
+    }
+    std::ostringstream hex;
+    hex << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return hex.str();
+}
+
+const std::string& PylonCameraSettings::imageEncoding() const
+{
+    return image_encoding_;
+}
+
+const std::string& PylonCameraSettings::cameraFrame() const
+{
+    return camera_frame_;
+}
+
+const double& PylonCameraSettings::frameRate() const
+{
+    return frame_rate_;
+}
+
+const std::string& PylonCameraSettings::cameraInfoURL() const
+{
+    return camera_info_url_;
+}
+
+}  // namespace pylon_camera
@@ -0,0 +1,163 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/realtime.h>
+#include <pylon_camera/logging.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+namespace pylon_camera
+{
+
+namespace realtime
+{
+
+namespace
+{
+
+uint64_t monotonicNow()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+}  // namespace
+
+bool setThreadPriority(const int& priority)
+{
+    sched_param param;
+    std::memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    const int policy = priority > 0 ? SCHED_FIFO : SCHED_OTHER;
+    // pthread functions return the error instead of setting errno
+    const int err = pthread_setschedparam(pthread_self(), policy, &param);
+    if ( err != 0 )
+    {
+        PYLON_CAMERA_ERROR_STREAM("Could not set the thread priority to " << priority
+                << ": " << std::strerror(err) << ". Real-time priorities need "
+                << "CAP_SYS_NICE or an rtprio entry in /etc/security/limits.conf");
+        return false;
+    }
+    return true;
+}
+
+bool unpinThread()
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    // the kernel ignores the CPUs which do not exist
+    for ( int cpu = 0; cpu < CPU_SETSIZE; ++cpu )
+    {
+        CPU_SET(cpu, &set);
+    }
+    const int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if ( err != 0 )
+    {
+        PYLON_CAMERA_ERROR_STREAM("Could not unpin the thread: " << std::strerror(err));
+        return false;
+    }
+    return true;
+}
+
+bool pinThreadToCPUs(const std::vector<int>& cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for ( const int& cpu : cpus )
+    {
+        if ( cpu < 0 || cpu >= CPU_SETSIZE )
+        {
+            PYLON_CAMERA_ERROR_STREAM("Invalid CPU index " << cpu);
+            return false;
+        }
+        CPU_SET(cpu, &set);
+    }
+    const int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if ( err != 0 )
+    {
+        PYLON_CAMERA_ERROR_STREAM("Could not pin the thread to the given CPUs: "
+                << std::strerror(err));
+        return false;
+    }
+    return true;
+}
+
+bool lockMemory()
+{
+    if ( mlockall(MCL_CURRENT | MCL_FUTURE) != 0 )
+    {
+        PYLON_CAMERA_ERROR_STREAM("Could not lock the memory of the process: "
+                << std::strerror(errno) << ". Raise the memlock limit "
+                << "(ulimit -l) or grant CAP_IPC_LOCK");
+        return false;
+    }
+    return true;
+}
+
+CycleTimer::CycleTimer(const double& rate)
+    : period_ns_(0)
+    , deadline_ns_(monotonicNow())
+{
+    setRate(rate);
+}
+
+void CycleTimer::setRate(const double& rate)
+{
+    period_ns_ = rate > 0.0 ? static_cast<uint64_t>(1e9 / rate) : 0;
+}
+
+bool CycleTimer::sleep(uint64_t& latency_ns)
+{
+    deadline_ns_ += period_ns_;
+    const uint64_t now_ns = monotonicNow();
+    if ( now_ns >= deadline_ns_ )
+    {
+        // overrun, like ros::Rate don't try to catch up the missed cycles
+        deadline_ns_ = now_ns;
+        return false;
+    }
+
+    timespec deadline;
+    deadline.tv_sec = static_cast<time_t>(deadline_ns_ / 1000000000ULL);
+    deadline.tv_nsec = static_cast<long>(deadline_ns_ % 1000000000ULL);  // NOLINT(runtime/int)
+    while ( clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR )
+    {}
+    const uint64_t woken_ns = monotonicNow();
+    latency_ns = woken_ns > deadline_ns_ ? woken_ns - deadline_ns_ : 0;
+    return true;
+}
+
+}  // namespace realtime
+}  // namespace pylon_camera
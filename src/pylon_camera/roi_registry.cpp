@@ -0,0 +1,182 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/roi_registry.h>
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace pylon_camera
+{
+
+RoiRegistry::RoiRegistry()
+    : leases_()
+{}
+
+RoiRegistry::~RoiRegistry()
+{}
+
+bool RoiRegistry::update(const std::string& client_id,
+                         const sensor_msgs::RegionOfInterest& roi,
+                         const ros::Time& expiry)
+{
+    std::map<std::string, Lease>::iterator it = leases_.find(client_id);
+    if ( it == leases_.end() )
+    {
+        Lease lease;
+        lease.roi = roi;
+        lease.expiry = expiry;
+        leases_[client_id] = lease;
+        return true;
+    }
+    it->second.expiry = expiry;
+    if ( it->second.roi.x_offset == roi.x_offset &&
+         it->second.roi.y_offset == roi.y_offset &&
+         it->second.roi.width == roi.width &&
+         it->second.roi.height == roi.height )
+    {
+        // only renewed the lease
+        return false;
+    }
+    it->second.roi = roi;
+    return true;
+}
+
+bool RoiRegistry::remove(const std::string& client_id)
+{
+    return leases_.erase(client_id) > 0;
+}
+
+std::vector<std::string> RoiRegistry::expire(const ros::Time& now)
+{
+    std::vector<std::string> expired;
+    std::map<std::string, Lease>::iterator it = leases_.begin();
+    while ( it != leases_.end() )
+    {
+        if ( it->second.expiry < now )
+        {
+            expired.push_back(it->first);
+            leases_.erase(it++);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    return expired;
+}
+
+namespace
+{
+/**
+ * Extends the range [min, max) of the bounding box by the range of a region.
+ * A size of 0 stands for the full sensor and sets full to true.
+ */
+void extendRange(const uint32_t& offset,
+                 const uint32_t& size,
+                 uint64_t& min,
+                 uint64_t& max,
+                 bool& full)
+{
+    if ( size == 0 )
+    {
+        full = true;
+        return;
+    }
+    min = std::min<uint64_t>(min, offset);
+    max = std::max<uint64_t>(max, static_cast<uint64_t>(offset) + size);
+}
+}  // namespace
+
+bool RoiRegistry::boundingBox(sensor_msgs::RegionOfInterest& box) const
+{
+    if ( leases_.empty() )
+    {
+        return false;
+    }
+    uint64_t x_min = std::numeric_limits<uint64_t>::max();
+    uint64_t y_min = std::numeric_limits<uint64_t>::max();
+    uint64_t x_max = 0;
+    uint64_t y_max = 0;
+    bool full_x = false;
+    bool full_y = false;
+    for ( std::map<std::string, Lease>::const_iterator it = leases_.begin();
+          it != leases_.end();
+          ++it )
+    {
+        const sensor_msgs::RegionOfInterest& roi = it->second.roi;
+        extendRange(roi.x_offset, roi.width, x_min, x_max, full_x);
+        extendRange(roi.y_offset, roi.height, y_min, y_max, full_y);
+    }
+    box = sensor_msgs::RegionOfInterest();
+    if ( !full_x )
+    {
+        box.x_offset = static_cast<uint32_t>(x_min);
+        box.width = static_cast<uint32_t>(x_max - x_min);
+    }
+    if ( !full_y )
+    {
+        box.y_offset = static_cast<uint32_t>(y_min);
+        box.height = static_cast<uint32_t>(y_max - y_min);
+    }
+    return true;
+}
+
+bool RoiRegistry::region(const std::string& client_id,
+                         sensor_msgs::RegionOfInterest& roi) const
+{
+    std::map<std::string, Lease>::const_iterator it = leases_.find(client_id);
+    if ( it == leases_.end() )
+    {
+        return false;
+    }
+    roi = it->second.roi;
+    return true;
+}
+
+std::vector<std::string> RoiRegistry::clients() const
+{
+    std::vector<std::string> ids;
+    ids.reserve(leases_.size());
+    for ( std::map<std::string, Lease>::const_iterator it = leases_.begin();
+          it != leases_.end();
+          ++it )
+    {
+        ids.push_back(it->first);
+    }
+    return ids;
+}
+
+std::size_t RoiRegistry::size() const
+{
+    return leases_.size();
+}
+
+}  // namespace pylon_camera
@@ -0,0 +1,86 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <pylon_camera/ros_log_sink.h>
+#include <ros/ros.h>
+
+namespace pylon_camera
+{
+
+void RosLogSink::log(const LOG_LEVEL& level, const std::string& msg)
+{
+    switch ( level )
+    {
+        case LL_DEBUG:
+            ROS_DEBUG_STREAM(msg);
+            break;
+        case LL_INFO:
+            ROS_INFO_STREAM(msg);
+            break;
+        case LL_WARN:
+            ROS_WARN_STREAM(msg);
+            break;
+        default:
+            ROS_ERROR_STREAM(msg);
+            break;
+    }
+}
+
+LOG_LEVEL RosLogSink::rosconsoleLevel()
+{
+    // the same check the ROS_*_STREAM macros do, it takes the level of the
+    // parent loggers into account
+    {
+        ROSCONSOLE_DEFINE_LOCATION(true, ::ros::console::levels::Debug,
+                                   ROSCONSOLE_DEFAULT_NAME);
+        if ( __rosconsole_define_location__enabled )
+        {
+            return LL_DEBUG;
+        }
+    }
+    {
+        ROSCONSOLE_DEFINE_LOCATION(true, ::ros::console::levels::Info,
+                                   ROSCONSOLE_DEFAULT_NAME);
+        if ( __rosconsole_define_location__enabled )
+        {
+            return LL_INFO;
+        }
+    }
+    {
+        ROSCONSOLE_DEFINE_LOCATION(true, ::ros::console::levels::Warn,
+                                   ROSCONSOLE_DEFAULT_NAME);
+        if ( __rosconsole_define_location__enabled )
+        {
+            return LL_WARN;
+        }
+    }
+    return LL_ERROR;
+}
+
+}  // namespace pylon_camera
@@ -0,0 +1,156 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+#include <cmath>
+
+#include <pylon_camera/gige_bandwidth_planner.h>
+
+using pylon_camera::gige_bandwidth::Plan;
+using pylon_camera::gige_bandwidth::Request;
+using pylon_camera::gige_bandwidth::plan;
+
+namespace
+{
+
+Request defaultRequest()
+{
+    Request request;
+    request.width = 1920;
+    request.height = 1200;
+    request.bytes_per_pixel = 1.0;
+    request.link_speed_bps = 1e9;
+    request.headroom = 0.9;
+    request.mtu = 9000;
+    request.max_packet_size = 8192;
+    request.packet_size_increment = 4;
+    request.tick_frequency_hz = 125e6;
+    return request;
+}
+
+}  // namespace
+
+TEST(GigEBandwidthPlanner, RejectsInvalidRequests)
+{
+    Plan result;
+    Request request = defaultRequest();
+    request.width = 0;
+    EXPECT_FALSE(plan(request, result));
+
+    request = defaultRequest();
+    request.num_cameras = 0;
+    EXPECT_FALSE(plan(request, result));
+
+    request = defaultRequest();
+    request.camera_index = 1;
+    EXPECT_FALSE(plan(request, result));
+
+    request = defaultRequest();
+    request.link_speed_bps = 0.0;
+    EXPECT_FALSE(plan(request, result));
+
+    request = defaultRequest();
+    request.mtu = pylon_camera::gige_bandwidth::PACKET_HEADER_BYTES;
+    EXPECT_FALSE(plan(request, result));
+}
+
+TEST(GigEBandwidthPlanner, PacketSizeFitsMTUAndIncrement)
+{
+    Plan result;
+    Request request = defaultRequest();
+    ASSERT_TRUE(plan(request, result));
+    // limited by the camera
+    EXPECT_EQ(8192u, result.packet_size);
+
+    request.mtu = 1500;
+    request.packet_size_increment = 8;
+    ASSERT_TRUE(plan(request, result));
+    EXPECT_EQ(1496u, result.packet_size);
+    EXPECT_EQ(0u, result.packet_size % 8);
+}
+
+TEST(GigEBandwidthPlanner, SingleCameraUsesItsShareOfTheLink)
+{
+    Plan result;
+    Request request = defaultRequest();
+    ASSERT_TRUE(plan(request, result));
+    EXPECT_DOUBLE_EQ(0.9e9, result.bandwidth_share_bps);
+    const double payload = result.packet_size - pylon_camera::gige_bandwidth::PACKET_HEADER_BYTES;
+    EXPECT_EQ(static_cast<size_t>(std::ceil(1920.0 * 1200.0 / payload)) + 2,
+              result.packets_per_frame);
+    // the frame on the wire is larger than the pixels, hence slower than
+    // share / pixel bits
+    EXPECT_LT(result.max_fps, 0.9e9 / (1920.0 * 1200.0 * 8.0));
+    EXPECT_GT(result.max_fps, 0.95 * 0.9e9 / (1920.0 * 1200.0 * 8.0));
+    EXPECT_DOUBLE_EQ(result.max_fps, result.planned_fps);
+    EXPECT_EQ(0, result.frame_transmission_delay);
+}
+
+TEST(GigEBandwidthPlanner, SharedLinkStaggersCameras)
+{
+    Plan first;
+    Plan second;
+    Request request = defaultRequest();
+    request.num_cameras = 3;
+    ASSERT_TRUE(plan(request, first));
+    request.camera_index = 2;
+    ASSERT_TRUE(plan(request, second));
+
+    Plan single;
+    ASSERT_TRUE(plan(defaultRequest(), single));
+    EXPECT_NEAR(single.max_fps / 3.0, first.max_fps, 1e-9);
+    EXPECT_GT(first.inter_packet_delay, single.inter_packet_delay);
+    EXPECT_EQ(first.inter_packet_delay, second.inter_packet_delay);
+    EXPECT_EQ(0, first.frame_transmission_delay);
+    EXPECT_GT(second.frame_transmission_delay, 0);
+}
+
+TEST(GigEBandwidthPlanner, SmallerImageAllowsHigherFrameRate)
+{
+    Plan full;
+    Plan roi;
+    Request request = defaultRequest();
+    ASSERT_TRUE(plan(request, full));
+    request.width /= 2;
+    request.height /= 2;
+    ASSERT_TRUE(plan(request, roi));
+    EXPECT_GT(roi.max_fps, 3.5 * full.max_fps);
+}
+
+TEST(GigEBandwidthPlanner, TargetFrameRateIsLimited)
+{
+    Plan result;
+    Request request = defaultRequest();
+    request.target_fps = 10.0;
+    ASSERT_TRUE(plan(request, result));
+    EXPECT_DOUBLE_EQ(10.0, result.planned_fps);
+    request.target_fps = 1000.0;
+    ASSERT_TRUE(plan(request, result));
+    EXPECT_DOUBLE_EQ(result.max_fps, result.planned_fps);
+}
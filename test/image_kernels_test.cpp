@@ -0,0 +1,388 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include <pylon_camera/image_kernels.h>
+
+namespace image_kernels = pylon_camera::image_kernels;
+
+namespace
+{
+
+std::vector<uint8_t> pseudoRandomImage(const std::size_t& size)
+{
+    std::vector<uint8_t> image(size);
+    uint32_t state = 12345;
+    for ( std::size_t i = 0; i < size; ++i )
+    {
+        state = state * 1103515245 + 12345;
+        image[i] = static_cast<uint8_t>(state >> 16);
+    }
+    return image;
+}
+
+// scalar decimation, pixel by pixel
+std::vector<uint8_t> referenceDecimate(const std::vector<uint8_t>& src,
+                                       const std::size_t& rows,
+                                       const std::size_t& cols,
+                                       const std::size_t& bytes_per_pixel,
+                                       const std::size_t& cell_size,
+                                       const std::size_t& decimation_x,
+                                       const std::size_t& decimation_y)
+{
+    // only whole steps of cell_size * decimation pixels are kept
+    const std::size_t row_steps = rows / (cell_size * decimation_y);
+    const std::size_t col_steps = cols / (cell_size * decimation_x);
+    std::vector<uint8_t> dst;
+    for ( std::size_t i = 0; i < row_steps; ++i )
+    {
+        const std::size_t row = i * cell_size * decimation_y;
+        for ( std::size_t sub_row = 0; sub_row < cell_size; ++sub_row )
+        {
+            for ( std::size_t j = 0; j < col_steps; ++j )
+            {
+                const std::size_t col = j * cell_size * decimation_x;
+                for ( std::size_t byte = 0; byte < cell_size * bytes_per_pixel; ++byte )
+                {
+                    dst.push_back(src[((row + sub_row) * cols + col) * bytes_per_pixel + byte]);
+                }
+            }
+        }
+    }
+    return dst;
+}
+
+void expectDecimateMatchesReference(const std::size_t& rows,
+                                    const std::size_t& cols,
+                                    const std::size_t& bytes_per_pixel,
+                                    const std::size_t& cell_size,
+                                    const std::size_t& decimation_x,
+                                    const std::size_t& decimation_y)
+{
+    const std::vector<uint8_t> src = pseudoRandomImage(rows * cols * bytes_per_pixel);
+    const std::size_t out_rows = image_kernels::decimatedLength(rows, cell_size, decimation_y);
+    const std::size_t out_cols = image_kernels::decimatedLength(cols, cell_size, decimation_x);
+    std::vector<uint8_t> dst(out_rows * out_cols * bytes_per_pixel);
+    image_kernels::decimate(src.data(), rows, cols, bytes_per_pixel, cell_size,
+                            decimation_x, decimation_y, dst.data());
+    const std::vector<uint8_t> reference = referenceDecimate(src, rows, cols,
+                                                             bytes_per_pixel,
+                                                             cell_size,
+                                                             decimation_x,
+                                                             decimation_y);
+    EXPECT_EQ(reference, dst) << rows << " x " << cols << ", " << bytes_per_pixel
+        << " byte(s), cell " << cell_size << ", decimation " << decimation_x
+        << " x " << decimation_y;
+}
+
+// scalar Laplacian variance over the bytes of the roi that have all
+// neighbours in the image
+double referenceLaplacianVariance(const std::vector<uint8_t>& data,
+                                  const std::size_t& rows,
+                                  const std::size_t& row_bytes,
+                                  const cv::Rect& roi,
+                                  const std::size_t& dx,
+                                  const std::size_t& dy,
+                                  const std::size_t& row_step)
+{
+    const std::size_t first_row = std::max<std::size_t>(std::max(roi.y, 0), dy);
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    std::size_t count = 0;
+    for ( std::size_t row = first_row; row + dy < rows; row += row_step )
+    {
+        for ( std::size_t col = dx; col + dx < row_bytes; ++col )
+        {
+            if ( !roi.contains(cv::Point(col, row)) )
+            {
+                continue;
+            }
+            const std::size_t idx = row * row_bytes + col;
+            const double laplacian = data[idx - dy * row_bytes] + data[idx + dy * row_bytes] +
+                                     data[idx - dx] + data[idx + dx] - 4.0 * data[idx];
+            sum += laplacian;
+            sum_sq += laplacian * laplacian;
+            ++count;
+        }
+    }
+    if ( count == 0 )
+    {
+        return 0.0;
+    }
+    const double mean = sum / count;
+    return sum_sq / count - mean * mean;
+}
+
+// scalar mean absolute difference of every row_step-th row
+float referenceSampledRowsMeanAbsDiff(const std::vector<uint8_t>& data,
+                                      const std::vector<uint8_t>& previous,
+                                      const std::size_t& rows,
+                                      const std::size_t& row_bytes,
+                                      const std::size_t& row_step)
+{
+    uint64_t sad = 0;
+    std::size_t count = 0;
+    for ( std::size_t row = 0; row < rows; row += row_step )
+    {
+        for ( std::size_t col = 0; col < row_bytes; ++col )
+        {
+            const std::size_t idx = row * row_bytes + col;
+            sad += std::abs(static_cast<int>(data[idx]) - static_cast<int>(previous[idx]));
+            ++count;
+        }
+    }
+    return static_cast<float>(sad) / static_cast<float>(count);
+}
+
+// scalar per-pixel box average
+std::vector<uint8_t> referenceBoxDownscale(const std::vector<uint8_t>& src,
+                                           const std::size_t& rows,
+                                           const std::size_t& cols,
+                                           const std::size_t& channels,
+                                           const std::size_t& factor)
+{
+    const std::size_t out_cols = cols / factor;
+    std::vector<uint8_t> dst((rows / factor) * out_cols * channels);
+    for ( std::size_t row = 0; row < rows / factor; ++row )
+    {
+        for ( std::size_t col = 0; col < out_cols; ++col )
+        {
+            for ( std::size_t ch = 0; ch < channels; ++ch )
+            {
+                uint32_t sum = 0;
+                for ( std::size_t i = 0; i < factor; ++i )
+                {
+                    for ( std::size_t j = 0; j < factor; ++j )
+                    {
+                        sum += src[((row * factor + i) * cols + col * factor + j) * channels + ch];
+                    }
+                }
+                dst[(row * out_cols + col) * channels + ch] =
+                                        (sum + factor * factor / 2) / (factor * factor);
+            }
+        }
+    }
+    return dst;
+}
+
+}  // namespace
+
+TEST(ImageKernels, DecimateMatchesReference)
+{
+    // odd sizes leave tails behind the SSE2 loops
+    const std::size_t sizes[][2] = { {48, 64}, {37, 101}, {5, 17}, {2, 3} };
+    for ( const auto& size : sizes )
+    {
+        for ( std::size_t decimation = 1; decimation <= 5; ++decimation )
+        {
+            // mono8, mono16 and rgb8
+            expectDecimateMatchesReference(size[0], size[1], 1, 1, decimation, decimation);
+            expectDecimateMatchesReference(size[0], size[1], 2, 1, decimation, decimation);
+            expectDecimateMatchesReference(size[0], size[1], 3, 1, decimation, 1);
+            // Bayer 8 bit
+            expectDecimateMatchesReference(size[0], size[1], 1, 2, decimation, decimation);
+        }
+    }
+}
+
+TEST(ImageKernels, DecimateKeepsBayerCells)
+{
+    // a 4 x 8 bggr image, each byte is its color
+    const uint8_t pattern[2][2] = { {'b', 'g'}, {'G', 'r'} };
+    std::vector<uint8_t> src(4 * 8);
+    for ( std::size_t row = 0; row < 4; ++row )
+    {
+        for ( std::size_t col = 0; col < 8; ++col )
+        {
+            src[row * 8 + col] = pattern[row % 2][col % 2];
+        }
+    }
+    std::vector<uint8_t> dst(2 * 4);
+    image_kernels::decimate(src.data(), 4, 8, 1, 2, 2, 2, dst.data());
+    const uint8_t expected[] = { 'b', 'g', 'b', 'g', 'G', 'r', 'G', 'r' };
+    EXPECT_EQ(std::vector<uint8_t>(expected, expected + 8), dst);
+}
+
+TEST(ImageKernels, LaplacianVarianceMatchesReference)
+{
+    // widths around the 16 byte SSE2 blocks leave tails behind
+    const std::size_t row_bytes_list[] = { 5, 15, 16, 17, 33, 101 };
+    const std::size_t rows = 23;
+    for ( const std::size_t& row_bytes : row_bytes_list )
+    {
+        const std::vector<uint8_t> image = pseudoRandomImage(rows * row_bytes);
+        const int width = static_cast<int>(row_bytes);
+        // the whole image, regions over the edges, inner and empty regions
+        const cv::Rect rois[] = { cv::Rect(0, 0, width, rows),
+                                  cv::Rect(-4, -3, width / 2 + 4, 10),
+                                  cv::Rect(width / 3, 5, width, rows),
+                                  cv::Rect(1, 1, width - 2, rows - 2),
+                                  cv::Rect(width, 0, 4, rows) };
+        // mono, rgb8 and Bayer neighbours
+        const std::size_t distances[][2] = { {1, 1}, {3, 1}, {2, 2} };
+        for ( const cv::Rect& roi : rois )
+        {
+            for ( const auto& distance : distances )
+            {
+                for ( std::size_t row_step = 1; row_step <= 3; ++row_step )
+                {
+                    const double expected = referenceLaplacianVariance(
+                                image, rows, row_bytes, roi, distance[0],
+                                distance[1], row_step);
+                    const double actual = image_kernels::laplacianVariance(
+                                image.data(), rows, row_bytes, roi, distance[0],
+                                distance[1], row_step);
+                    EXPECT_NEAR(expected, actual, 1e-6 * std::max(1.0, expected))
+                        << row_bytes << " bytes, roi " << roi.x << "," << roi.y
+                        << " " << roi.width << "x" << roi.height << ", dx "
+                        << distance[0] << ", dy " << distance[1]
+                        << ", row step " << row_step;
+                }
+            }
+        }
+    }
+}
+
+TEST(ImageKernels, SampledRowsMeanAbsDiffMatchesReference)
+{
+    const std::size_t row_bytes_list[] = { 1, 15, 16, 17, 31, 64, 101 };
+    const std::size_t rows = 19;
+    for ( const std::size_t& row_bytes : row_bytes_list )
+    {
+        const std::vector<uint8_t> previous = pseudoRandomImage(rows * row_bytes);
+        std::vector<uint8_t> image = pseudoRandomImage(rows * row_bytes + 7);
+        image.erase(image.begin(), image.begin() + 7);
+        for ( std::size_t row_step = 1; row_step <= 8; ++row_step )
+        {
+            std::vector<uint8_t> reference;
+            image_kernels::copySampledRows(previous.data(), rows, row_bytes,
+                                           row_step, reference);
+            EXPECT_FLOAT_EQ(referenceSampledRowsMeanAbsDiff(image, previous, rows,
+                                                            row_bytes, row_step),
+                            image_kernels::sampledRowsMeanAbsDiff(image.data(), rows,
+                                                                  row_bytes, row_step,
+                                                                  reference))
+                << row_bytes << " bytes, row step " << row_step;
+        }
+    }
+}
+
+TEST(ImageKernels, BoxDownscaleMatchesReference)
+{
+    // odd sizes leave rows, columns and SSE2 tails behind
+    const std::size_t sizes[][2] = { {48, 64}, {37, 101}, {17, 17}, {16, 16} };
+    std::vector<uint32_t> column_sums;
+    for ( const auto& size : sizes )
+    {
+        for ( std::size_t channels = 1; channels <= 3; channels += 2 )
+        {
+            const std::vector<uint8_t> src = pseudoRandomImage(size[0] * size[1] * channels);
+            // large factors overflow 16 bit column sums
+            for ( std::size_t factor = 1; factor <= 40; ++factor )
+            {
+                const std::vector<uint8_t> expected = referenceBoxDownscale(
+                                src, size[0], size[1], channels, factor);
+                std::vector<uint8_t> dst(expected.size());
+                image_kernels::boxDownscale(src.data(), size[0], size[1], channels,
+                                            factor, column_sums, dst.data());
+                EXPECT_EQ(expected, dst) << size[0] << " x " << size[1] << ", "
+                    << channels << " channel(s), factor " << factor;
+            }
+        }
+    }
+}
+
+TEST(ImageKernels, WeightedSamplingLeavesRegionsOutOfTheBackground)
+{
+    const std::size_t rows = 480;
+    const std::size_t cols = 640;
+    std::vector<cv::Rect> regions;
+    regions.push_back(cv::Rect(160, 120, 320, 240));
+    std::vector<float> region_weights(1, 4.0);
+    std::vector<std::size_t> indices;
+    std::vector<float> weights;
+    image_kernels::setupWeightedSamplingIndices(indices, weights, rows, cols,
+                                                1, 8, regions,
+                                                region_weights, 1.0);
+    ASSERT_EQ(indices.size(), weights.size());
+    ASSERT_FALSE(indices.empty());
+    for ( std::size_t i = 0; i < indices.size(); ++i )
+    {
+        const cv::Point pixel(indices[i] % cols, indices[i] / cols);
+        EXPECT_FLOAT_EQ(regions[0].contains(pixel) ? 4.0 : 1.0, weights[i]);
+    }
+}
+
+TEST(ImageKernels, WeightedSamplingScalesWithRegionArea)
+{
+    const std::size_t rows = 512;
+    const std::size_t cols = 512;
+    std::vector<float> region_weights(1, 1.0);
+    std::vector<std::size_t> indices;
+    std::vector<float> weights;
+
+    std::vector<cv::Rect> regions(1, cv::Rect(0, 0, 256, 256));
+    image_kernels::setupWeightedSamplingIndices(indices, weights, rows, cols,
+                                                1, 16, regions,
+                                                region_weights, 0.0);
+    const std::size_t large = indices.size();
+
+    regions[0] = cv::Rect(0, 0, 64, 64);
+    image_kernels::setupWeightedSamplingIndices(indices, weights, rows, cols,
+                                                1, 16, regions,
+                                                region_weights, 0.0);
+    const std::size_t small = indices.size();
+
+    // a 16th of the area gets far fewer samples
+    EXPECT_GT(small, 0u);
+    EXPECT_LT(4 * small, large);
+}
+
+TEST(ImageKernels, WeightedSamplingIndexesAllBytesOfAPixel)
+{
+    std::vector<cv::Rect> regions(1, cv::Rect(10, 10, 20, 20));
+    std::vector<float> region_weights(1, 1.0);
+    std::vector<std::size_t> indices;
+    std::vector<float> weights;
+    image_kernels::setupWeightedSamplingIndices(indices, weights, 100, 100,
+                                                3, 4, regions,
+                                                region_weights, 0.0);
+    ASSERT_EQ(0u, indices.size() % 3);
+    for ( std::size_t i = 0; i < indices.size(); i += 3 )
+    {
+        EXPECT_EQ(0u, indices[i] % 3);
+        EXPECT_EQ(indices[i] + 1, indices[i + 1]);
+        EXPECT_EQ(indices[i] + 2, indices[i + 2]);
+    }
+}
@@ -0,0 +1,138 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2016, Magazino GmbH. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Magazino GmbH nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include <pylon_camera/roi_registry.h>
+
+using pylon_camera::RoiRegistry;
+
+namespace
+{
+
+sensor_msgs::RegionOfInterest makeRoi(const uint32_t& x_offset,
+                                      const uint32_t& y_offset,
+                                      const uint32_t& width,
+                                      const uint32_t& height)
+{
+    sensor_msgs::RegionOfInterest roi;
+    roi.x_offset = x_offset;
+    roi.y_offset = y_offset;
+    roi.width = width;
+    roi.height = height;
+    return roi;
+}
+
+}  // namespace
+
+TEST(RoiRegistry, EmptyRegistryHasNoBoundingBox)
+{
+    RoiRegistry registry;
+    sensor_msgs::RegionOfInterest box;
+    EXPECT_FALSE(registry.boundingBox(box));
+    EXPECT_EQ(0u, registry.size());
+}
+
+TEST(RoiRegistry, UpdateReportsChangesOnly)
+{
+    RoiRegistry registry;
+    EXPECT_TRUE(registry.update("a", makeRoi(10, 20, 30, 40), ros::Time(10.0)));
+    // renewing the lease with the same region is no change
+    EXPECT_FALSE(registry.update("a", makeRoi(10, 20, 30, 40), ros::Time(20.0)));
+    EXPECT_TRUE(registry.update("a", makeRoi(10, 20, 30, 50), ros::Time(20.0)));
+
+    sensor_msgs::RegionOfInterest roi;
+    ASSERT_TRUE(registry.region("a", roi));
+    EXPECT_EQ(50u, roi.height);
+    EXPECT_FALSE(registry.region("b", roi));
+}
+
+TEST(RoiRegistry, RemoveReportsRegisteredClients)
+{
+    RoiRegistry registry;
+    registry.update("a", makeRoi(0, 0, 10, 10), ros::Time(10.0));
+    EXPECT_FALSE(registry.remove("b"));
+    EXPECT_TRUE(registry.remove("a"));
+    EXPECT_FALSE(registry.remove("a"));
+    EXPECT_EQ(0u, registry.size());
+}
+
+TEST(RoiRegistry, ExpireRemovesEndedLeases)
+{
+    RoiRegistry registry;
+    registry.update("a", makeRoi(0, 0, 10, 10), ros::Time(10.0));
+    registry.update("b", makeRoi(0, 0, 10, 10), ros::Time(20.0));
+    registry.update("c", makeRoi(0, 0, 10, 10), ros::Time(30.0));
+
+    std::vector<std::string> expired = registry.expire(ros::Time(20.0));
+    ASSERT_EQ(1u, expired.size());
+    EXPECT_EQ("a", expired[0]);
+    EXPECT_EQ(2u, registry.size());
+
+    // renewing moves the end of the lease
+    registry.update("b", makeRoi(0, 0, 10, 10), ros::Time(40.0));
+    expired = registry.expire(ros::Time(35.0));
+    ASSERT_EQ(1u, expired.size());
+    EXPECT_EQ("c", expired[0]);
+
+    std::vector<std::string> clients = registry.clients();
+    ASSERT_EQ(1u, clients.size());
+    EXPECT_EQ("b", clients[0]);
+}
+
+TEST(RoiRegistry, BoundingBoxSpansAllRegions)
+{
+    RoiRegistry registry;
+    registry.update("a", makeRoi(100, 50, 200, 100), ros::Time(10.0));
+    registry.update("b", makeRoi(250, 20, 100, 50), ros::Time(10.0));
+
+    sensor_msgs::RegionOfInterest box;
+    ASSERT_TRUE(registry.boundingBox(box));
+    EXPECT_EQ(100u, box.x_offset);
+    EXPECT_EQ(20u, box.y_offset);
+    EXPECT_EQ(250u, box.width);
+    EXPECT_EQ(130u, box.height);
+}
+
+TEST(RoiRegistry, FullSensorDimensionWins)
+{
+    RoiRegistry registry;
+    registry.update("a", makeRoi(100, 50, 200, 100), ros::Time(10.0));
+    // width 0 means the full sensor width
+    registry.update("b", makeRoi(0, 300, 0, 10), ros::Time(10.0));
+
+    sensor_msgs::RegionOfInterest box;
+    ASSERT_TRUE(registry.boundingBox(box));
+    EXPECT_EQ(0u, box.x_offset);
+    EXPECT_EQ(0u, box.width);
+    EXPECT_EQ(50u, box.y_offset);
+    EXPECT_EQ(260u, box.height);
+}